@@ -0,0 +1,153 @@
+#ifndef SRC_CONTROLLER_INCLUDE_COMMAND_QUEUE_H
+#define SRC_CONTROLLER_INCLUDE_COMMAND_QUEUE_H
+
+/**
+ * @file command_queue.h
+ * @author SevenStreams
+ * @brief This file handles history of transform and settings commands
+ * @version 0.1
+ * @date 2024-03-15
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#define COMMAND_QUEUE_HISTORY_SIZE 256
+
+/**
+ * @brief Kinds of commands, a value of the controller each
+ *
+ */
+typedef enum e_command_types {
+  v_command_rotation_x,
+  v_command_rotation_y,
+  v_command_rotation_z,
+  v_command_translation_x,
+  v_command_translation_y,
+  v_command_translation_z,
+  v_command_scale,
+  v_command_projection_type,  // index, as in Controller::setProjectionType
+  v_command_line_type,        // index, as in Controller::setLineType
+  v_command_display_type,     // index, as in Controller::setDisplayType
+  v_command_line_width,
+  v_command_vertex_size,
+  v_command_background_color,  // three components
+  v_command_line_color,        // three components
+  v_command_vertices_color,    // three components
+  v_command_types_count
+} v_command_types;
+
+/**
+ * @brief Change of one value of the controller
+ *
+ */
+struct ControllerCommand {
+  v_command_types type;
+  float before[3];  // restored by undo
+  float after[3];   // set by the command and by redo
+  bool joined;      // undone and redone together with the previous command
+};
+
+/**
+ * @brief Ring buffer of executed commands
+ *
+ * A command of the same kind as the last one replaces its new value if both
+ * were recorded in one frame. Within a group a command replaces the one of
+ * its kind anywhere in the group, so a drag from press to release is one
+ * step of the history. Commands of separate frames outside of a group are
+ * separate steps, however close in time. Undo and redo return stored
+ * values, intermediate states are never applied again. When the buffer is
+ * full the oldest commands are dropped.
+ */
+class CommandQueue {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * @brief The function handles initializing queue
+   *
+   * @param history_size Maximum number of stored commands
+   * @return CommandQueue
+   */
+  explicit CommandQueue(size_t history_size = COMMAND_QUEUE_HISTORY_SIZE);
+
+  /**
+   * @brief The function adds the executed command, dropping undone ones
+   *
+   * @param command The command
+   */
+  void record(ControllerCommand command);
+
+  /**
+   * @brief The function closes the frame, commands of the next one are
+   * merged only within a group
+   *
+   */
+  void endFrame();
+
+  /**
+   * @brief The function starts a group of commands undone as one
+   *
+   */
+  void beginGroup();
+
+  /**
+   * @brief The function ends the group of commands
+   *
+   */
+  void endGroup();
+
+  /**
+   * @brief The function steps back over the last group of commands
+   *
+   * @param group Commands of the group, the last one first
+   * @return true if there was a group to undo
+   */
+  bool undo(std::vector<ControllerCommand> *group);
+
+  /**
+   * @brief The function steps forward over the next undone group
+   *
+   * @param group Commands of the group, the first one first
+   * @return true if there was a group to redo
+   */
+  bool redo(std::vector<ControllerCommand> *group);
+
+  bool canUndo() const;
+
+  bool canRedo() const;
+
+  /**
+   * @brief The function removes all commands
+   *
+   */
+  void clear();
+
+ private:
+  /**
+   * @brief Command with the frame of its last change
+   *
+   */
+  struct Entry {
+    ControllerCommand command;
+    uint64_t frame;
+  };
+
+  Entry &at(size_t position);
+
+  std::vector<Entry> ring_;
+  size_t first_ = 0;   // index of the oldest entry
+  size_t count_ = 0;   // entries, undone ones included
+  size_t cursor_ = 0;  // entries which are applied
+  uint64_t frame_ = 0;
+  bool mergeable_ = false;  // false after undo and redo
+  int group_depth_ = 0;
+  bool group_started_ = false;  // the open group has its first command
+  size_t group_first_ = 0;      // position of the first command of the group
+};
+
+#endif  // SRC_CONTROLLER_INCLUDE_COMMAND_QUEUE_H
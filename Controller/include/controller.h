@@ -13,30 +13,142 @@
  *
  */
 
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 
+#include "capture_sequence.h"
+#include "command_queue.h"
+#include "interaction_trace.h"
 #include "matrix_generator.h"
+#include "mesh_pager.h"
 #include "model.h"
 #include "parser.h"
+#include "profiler.h"
+#include "tracer.h"
 #include "settings.h"
 #include "settings_path.h"
+#include "settings_store.h"
 
 /**
  * @brief The controller class
  */
 class Controller {
  private:
-  Model *model;
+  Model *model;    // rendered model
+  Model *staging_;  // model being loaded, swapped with model when ready
   Settings *settings;
   const std::string settings_path = SETTINGS_PATH;
   bool ModelInitialized_ = false;
-  Vector4 *vertices_copy_ = nullptr;
+  Vector3 *vertices_copy_ = nullptr;
   Matrix4x4 view_matrix_;
   Matrix4x4 projection_matrix_;
+  Matrix4x4 mvp_matrix_;
+  Matrix4x4 dequantization_matrix_;
+  bool quantized_ = false;
+  float quantization_error_ = 0.0f;
   Vector3 rotation_angles_;
   Vector3 translation_vector_;
   float scale_;
+  CaptureSequence capture_{v_capture_axis_y, 1, Vector3()};
+  std::unique_ptr<SettingsStore> settings_store_;  // created by first save
+  CommandQueue commands_;
+  bool vertices_dirty_ = true;  // vertices need transform without new MVP
+  InteractionTrace *trace_ = nullptr;  // set while recording
+  CommandQueue::Clock::time_point record_start_;
   int error;
+  std::unique_ptr<Parser> spare_parser_;  // parser of the second model
+  std::unique_ptr<Model> spare_model_;    // created by the first load
+  std::thread loader_;  // loads staging_ or frees the replaced model
+  std::atomic<bool> staging_ready_{false};
+  std::mutex load_mutex_;
+  bool loading_ = false;       // the loader thread parses a file
+  bool load_pending_ = false;  // a newer file supersedes the parsed one
+  std::string pending_file_;
+  std::function<void()> pending_ready_;
+  ProgressiveMesh progressive_mesh_;  // batches of the staging model
+  bool progressive_enabled_ = false;
+  bool progressive_loading_ = false;  // batches are drawn until the swap
+  std::string scratch_dir_;  // empty keeps models in memory
+  bool direct_read_ = false;
+  MeshPager pager_;
+  bool paging_ = false;                      // the model is out of core
+  std::vector<size_t> drawn_meshlets_;       // visible and resident
+  std::vector<VertexSpan> drawn_spans_;      // packed into vertices_copy_
+  std::vector<unsigned int> drawn_indices_;  // into the packed vertices
+  size_t drawn_vertices_ = 0;
+  std::vector<IndexRange> resident_ranges_;
+  std::vector<size_t> missing_meshlets_;  // visible, but not in memory
+
+  /**
+   * @brief The function waits for the loading or freeing thread
+   *
+   */
+  void joinLoader();
+
+  /**
+   * @brief The function frees the transformed vertices
+   *
+   */
+  void deleteVerticesCopy();
+
+  /**
+   * @brief The function packs vertices of drawn meshlets of out of core model
+   * and renumbers their indices
+   *
+   */
+  void packDrawnMeshlets();
+
+  /**
+   * @brief The function prepares the staging model for the next load
+   *
+   */
+  void prepareStaging();
+
+  /**
+   * @brief The function loads the staging model
+   *
+   * @param fileName The path to model
+   */
+  void loadStaging(const std::string &fileName);
+
+  /**
+   * @brief The function changes the values and records them in the history
+   *
+   * @param type Kind of the command
+   * @param values Three new values
+   */
+  void executeValues(v_command_types type, const float *values);
+
+  /**
+   * @brief The function appends the event to the recorded trace
+   *
+   * @param type Kind of the event
+   * @param command Kind of the command of state and command events
+   * @param values Values of state and command events
+   */
+  void recordEvent(v_interaction_events type,
+                   v_command_types command = v_command_rotation_x,
+                   const float *values = nullptr);
+
+  /**
+   * @brief The function reads values changed by the command
+   *
+   * @param type Kind of the command
+   * @param values Up to three values
+   */
+  void getCommandValues(v_command_types type, float *values);
+
+  /**
+   * @brief The function sets values changed by the command
+   *
+   * @param type Kind of the command
+   * @param values Up to three values
+   */
+  void setCommandValues(v_command_types type, const float *values);
 
  public:
   using string = std::string;
@@ -46,7 +158,8 @@ class Controller {
    * @param m The model
    * @return Controller The controller
    */
-  Controller(Model *m, Settings *s) : model(m), settings(s), error(0){};
+  Controller(Model *m, Settings *s)
+      : model(m), staging_(m), settings(s), error(0){};
 
   /**
    * @brief The function handles destroying controller
@@ -62,6 +175,129 @@ class Controller {
    */
   int uploadModel(std::string fileName);
 
+  /**
+   * @brief The function handles loading model on a background thread
+   *
+   * The rendered model is kept until swapStagedModel() is called, so frames
+   * are drawn while the file is parsed. A load which is still parsed is
+   * stopped and the loading thread goes on with the new file, so the
+   * calling thread does not wait for it. on_ready of the stopped load is
+   * not called.
+   *
+   * @param fileName The path to model
+   * @param on_ready Called on the loading thread when the model is staged
+   */
+  void loadModelAsync(std::string fileName,
+                      std::function<void()> on_ready = nullptr);
+
+  /**
+   * @brief The function returns if a loaded model waits for the swap
+   *
+   * @return bool True if swapStagedModel() may be called
+   */
+  bool isStagedModelReady();
+
+  /**
+   * @brief The function makes the staged model the rendered one
+   *
+   * On error the rendered model is kept. On success the replaced model is
+   * freed on a background thread and setModel() must be called before the
+   * next updateModel().
+   *
+   * @return int The error code of the staged model
+   */
+  int swapStagedModel();
+
+  /**
+   * @brief The function sets if loadModelAsync() publishes parsed batches
+   *
+   * @param enabled True to draw the model while it is parsed
+   * @param on_batch Called on the loading thread after every batch
+   */
+  void setProgressive(bool enabled, std::function<void()> on_batch = nullptr);
+
+  bool getProgressive();
+
+  /**
+   * @brief The function returns batches of the model being loaded
+   *
+   * @return ProgressiveMesh* The mesh, nullptr if the load is not
+   * progressive or the model is swapped in
+   */
+  ProgressiveMesh *getProgressiveMesh();
+
+  /**
+   * @brief The function returns matrix which normalizes positions of the
+   * progressive mesh by its bounding box and transforms them
+   *
+   * @return Matrix4x4 Transform matrix
+   */
+  Matrix4x4 getProgressiveTransformMatrix();
+
+  /**
+   * @brief The function sets if models are parsed into scratch files
+   *
+   * Out of core models keep only meshlets the view needs in memory, up to
+   * the budget. The setting is used by the next load.
+   *
+   * @param scratch_dir Directory of scratch files, empty to keep models in
+   * memory
+   * @param memory_budget Bytes of meshlets kept in memory
+   */
+  void setOutOfCore(const string &scratch_dir,
+                    size_t memory_budget = MESH_PAGER_DEFAULT_BUDGET);
+
+  /**
+   * @brief The function sets if model files are read around the page cache
+   *
+   * Direct reads keep big models loaded once from evicting the cache. The
+   * setting is used by the next load.
+   *
+   * @param direct True for direct reads
+   */
+  void setDirectRead(bool direct);
+
+  /**
+   * @brief The function returns if the rendered model is paged
+   *
+   * @return bool True for an out of core model
+   */
+  bool isPaging();
+
+  /**
+   * @brief The function requests visible meshlets of out of core model
+   *
+   * It is called before the vertices are transformed. Only the vertices of
+   * drawn meshlets are transformed and uploaded, packed one after another,
+   * so a change of the drawn meshlets makes them dirty and changes the
+   * drawn indices.
+   *
+   * @return bool True if the drawn indices have to be uploaded again
+   */
+  bool pageModel();
+
+  /**
+   * @brief The function returns if requested meshlets are still being read
+   *
+   * @return bool True if a later pageModel() may draw more meshlets
+   */
+  bool isPagingIn();
+
+  /**
+   * @brief The function returns proxies of visible meshlets which are not
+   * in memory
+   *
+   * @return std::vector<Vector3> Centers of the meshlets in clip space
+   */
+  std::vector<Vector3> getProxyPoints();
+
+  /**
+   * @brief The function returns the path of the rendered model
+   *
+   * @return string The path
+   */
+  string getModelPath();
+
   /**
    * @brief The function handles setting model
    *
@@ -74,6 +310,14 @@ class Controller {
    */
   void updateModel();
 
+  /**
+   * @brief The function handles updating model into given array
+   *
+   * @param output Array of getVerticesCount() transformed vertices, may be
+   * mapped GPU memory
+   */
+  void updateModel(Vector3 *output);
+
   /**
    * @brief The function returns if model initialized
    *
@@ -87,6 +331,92 @@ class Controller {
    */
   void setModelMatrixes();
 
+  /**
+   * @brief The function changes the value and records it in the history
+   *
+   * The value is set at once, vertices are transformed by the next
+   * updateModel(), so a burst of commands costs one transform.
+   *
+   * @param type Kind of the command
+   * @param value New value
+   */
+  void execute(v_command_types type, float value);
+
+  /**
+   * @brief The function changes the color and records it in the history
+   *
+   * @param type Kind of the command, one of colors
+   * @param color New color
+   */
+  void execute(v_command_types type, Vector3 color);
+
+  /**
+   * @brief The function starts commands undone as one step
+   *
+   */
+  void beginCommandGroup();
+
+  /**
+   * @brief The function ends the step started by beginCommandGroup()
+   *
+   */
+  void endCommandGroup();
+
+  /**
+   * @brief The function closes the frame, commands of one kind within a
+   * frame are one step of the history
+   *
+   */
+  void endCommandFrame();
+
+  /**
+   * @brief The function restores values before the last step
+   *
+   * @return true if there was a step to undo
+   */
+  bool undo();
+
+  /**
+   * @brief The function applies the last undone step again
+   *
+   * @return true if there was a step to redo
+   */
+  bool redo();
+
+  /**
+   * @brief The function starts recording commands, undo, redo, groups and
+   * frames into the trace
+   *
+   * The trace is cleared and starts with the model path and the current
+   * value of every kind of command, so a replay begins in the same state.
+   *
+   * @param trace The trace, must live until stopRecording()
+   */
+  void startRecording(InteractionTrace *trace);
+
+  /**
+   * @brief The function stops recording
+   *
+   */
+  void stopRecording();
+
+  bool isRecording();
+
+  /**
+   * @brief The function applies the recorded event as the user did it
+   *
+   * @param event The event, frame events are left to the caller
+   */
+  void replayEvent(const InteractionEvent &event);
+
+  /**
+   * @brief The function checks if vertices differ from the last
+   * updateModel()
+   *
+   * @return true if the model, its matrix or the vertex format changed
+   */
+  bool isTransformChanged();
+
   /**
    * @brief The function resets model state
    *
@@ -256,7 +586,7 @@ class Controller {
   bool toColor();
 
   /**
-   * @brief The function uploads settings
+   * @brief The function uploads settings, after pending saves are written
    *
    */
   void uploadSettings();
@@ -264,6 +594,8 @@ class Controller {
   /**
    * @brief The function handles saving settings to file
    *
+   * The file is written in background by SettingsStore, so frequent
+   * changes do not block the caller.
    */
   void saveSettings();
 
@@ -444,12 +776,125 @@ class Controller {
   int getIndicesCount();
   unsigned int *getIndices();
 
+  /**
+   * @brief The function returns normalized vertices of the rendered model
+   *
+   * @return Vector3* Vertices before transform
+   */
+  Vector3 *getModelVertices();
+
   /**
    * @brief The function returns vertices
    *
    * @return Vertices vector
    */
-  Vector4 *getVerticesCopy();
+  Vector3 *getVerticesCopy();
+
+  /**
+   * @brief The function returns the most vertices transformed in one frame
+   *
+   * Out of core model is bounded by the memory budget instead of its size.
+   *
+   * @return int Vertices to allocate for transformed copies
+   */
+  int getStreamVerticesCount();
+
+  /**
+   * @brief The function returns the vertices transformed by updateModel()
+   *
+   * @return int Vertices at the beginning of the copy
+   */
+  int getDrawnVerticesCount();
+
+  /**
+   * @brief The function returns indices of the transformed vertices
+   *
+   * Out of core model has indices of drawn meshlets only, the others have
+   * all indices of the model.
+   *
+   * @return unsigned int* The indices
+   */
+  unsigned int *getDrawnIndices();
+
+  int getDrawnIndicesCount();
+
+  /**
+   * @brief The function returns index ranges of meshlets inside view frustum
+   *
+   * @return Ranges of indices to draw
+   */
+  std::vector<IndexRange> getVisibleRanges();
+
+  /**
+   * @brief The function sets if vertices are uploaded as 16-bit positions
+   *
+   * @param quantized True for 16-bit positions transformed by GL
+   */
+  void setQuantized(bool quantized);
+
+  /**
+   * @brief The function returns if vertices are uploaded as 16-bit positions
+   *
+   * @return bool True for 16-bit positions
+   */
+  bool getQuantized();
+
+  /**
+   * @brief The function packs model vertices into 16-bit positions
+   *
+   * @return Packed positions
+   */
+  QuantizedPositions getQuantizedPositions();
+
+  /**
+   * @brief The function returns error of the last packing
+   *
+   * @return float Max error relative to bounding box size
+   */
+  float getQuantizationError();
+
+  /**
+   * @brief The function returns matrix which unpacks and transforms
+   * 16-bit positions
+   *
+   * @return Matrix4x4 Transform matrix
+   */
+  Matrix4x4 getQuantizedTransformMatrix();
+
+  /**
+   * @brief The function starts turntable capture from current rotation
+   *
+   * @param axis Axis of rotation
+   * @param frames_count Number of frames in full turn
+   */
+  void beginCapture(v_capture_axis axis, int frames_count);
+
+  /**
+   * @brief The function returns number of frames of the capture
+   *
+   * @return int Number of frames
+   */
+  int getCaptureFramesCount();
+
+  /**
+   * @brief The function sets rotation of the capture frame
+   *
+   * @param frame Index of frame
+   */
+  void setCaptureFrame(int frame);
+
+  /**
+   * @brief The function restores rotation which was before the capture
+   *
+   */
+  void endCapture();
+
+  /**
+   * @brief The function returns matrix from model to clip space
+   *
+   * @return Projection, view and model matrixes multiplied
+   */
+  Matrix4x4 getMvpMatrix();
 
   /**
    * @brief The function returns compiled model matrix
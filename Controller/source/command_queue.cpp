@@ -0,0 +1,91 @@
+#include "command_queue.h"
+
+#include <algorithm>
+
+CommandQueue::CommandQueue(size_t history_size)
+    : ring_(std::max<size_t>(history_size, 1)) {}
+
+CommandQueue::Entry &CommandQueue::at(size_t position) {
+  return ring_[(first_ + position) % ring_.size()];
+}
+
+void CommandQueue::record(ControllerCommand command) {
+  Entry *merged = nullptr;
+  if (group_depth_ > 0 && group_started_) {
+    // a group keeps one command of every kind, like a mouse drag
+    for (size_t position = cursor_; position-- > group_first_;) {
+      if (at(position).command.type == command.type) {
+        merged = &at(position);
+        break;
+      }
+    }
+  } else if (group_depth_ == 0 && mergeable_ && cursor_ > 0) {
+    Entry &last = at(cursor_ - 1);
+    if (last.command.type == command.type && last.frame == frame_) {
+      merged = &last;
+    }
+  }
+  count_ = cursor_;
+  if (merged) {
+    std::copy(command.after, command.after + 3, merged->command.after);
+    merged->frame = frame_;
+    return;
+  }
+
+  if (count_ == ring_.size()) {
+    first_ = (first_ + 1) % ring_.size();
+    --count_;
+    if (group_first_ > 0) --group_first_;
+    // the rest of a dropped group can not be undone without it
+    at(0).command.joined = false;
+  }
+  command.joined = group_depth_ > 0 && group_started_;
+  if (group_depth_ > 0 && !group_started_) {
+    group_started_ = true;
+    group_first_ = count_;
+  }
+  at(count_) = {command, frame_};
+  cursor_ = ++count_;
+  mergeable_ = true;
+}
+
+void CommandQueue::endFrame() { ++frame_; }
+
+void CommandQueue::beginGroup() {
+  if (group_depth_++ == 0) group_started_ = false;
+  mergeable_ = false;
+}
+
+void CommandQueue::endGroup() {
+  if (group_depth_ > 0 && --group_depth_ == 0) mergeable_ = false;
+}
+
+bool CommandQueue::undo(std::vector<ControllerCommand> *group) {
+  group->clear();
+  while (cursor_ > 0) {
+    const ControllerCommand &command = at(--cursor_).command;
+    group->push_back(command);
+    if (!command.joined) break;
+  }
+  mergeable_ = false;
+  return !group->empty();
+}
+
+bool CommandQueue::redo(std::vector<ControllerCommand> *group) {
+  group->clear();
+  while (cursor_ < count_ &&
+         (group->empty() || at(cursor_).command.joined)) {
+    group->push_back(at(cursor_++).command);
+  }
+  mergeable_ = false;
+  return !group->empty();
+}
+
+bool CommandQueue::canUndo() const { return cursor_ > 0; }
+
+bool CommandQueue::canRedo() const { return cursor_ < count_; }
+
+void CommandQueue::clear() {
+  first_ = count_ = cursor_ = 0;
+  mergeable_ = false;
+}
@@ -1,9 +1,16 @@
 #include "controller.h"
 
+#include <algorithm>
+
 Controller::~Controller() {
-  if (vertices_copy_ != nullptr) {
-    delete[] vertices_copy_;
+  {
+    std::lock_guard<std::mutex> lock(load_mutex_);
+    load_pending_ = false;
+    if (loading_) staging_->setLoadCancelled(true);
   }
+  joinLoader();
+  deleteVerticesCopy();
+  pager_.clear();
   model->deleteModel();
 }
 
@@ -20,15 +27,192 @@ void Controller::setModelMatrixes() {
 }
 
 int Controller::uploadModel(std::string fileName) {
-  model->deleteModel();
-  model->uploadModel(fileName);
-  model->initModel();
-  settings->uploadSettings(settings_path);
-  error = model->getErrorCode();
-  if (error) ModelInitialized_ = false;
+  TRACE_SCOPE("Controller::uploadModel");
+  prepareStaging();
+  loadStaging(fileName);
+  staging_ready_ = true;
+  return swapStagedModel();
+}
+
+void Controller::loadModelAsync(std::string fileName,
+                                std::function<void()> on_ready) {
+  {
+    std::lock_guard<std::mutex> lock(load_mutex_);
+    if (loading_) {
+      pending_file_ = fileName;
+      pending_ready_ = on_ready;
+      load_pending_ = true;
+      staging_->setLoadCancelled(true);
+      return;
+    }
+    loading_ = true;
+  }
+  prepareStaging();
+  progressive_loading_ = progressive_enabled_;
+  if (progressive_loading_) staging_->setProgressiveMesh(&progressive_mesh_);
+  loader_ = std::thread([this, fileName, on_ready]() {
+    std::string file = fileName;
+    std::function<void()> ready = on_ready;
+    while (true) {
+      loadStaging(file);
+      std::lock_guard<std::mutex> lock(load_mutex_);
+      if (!load_pending_) {
+        loading_ = false;
+        break;
+      }
+      file = pending_file_;
+      ready = pending_ready_;
+      load_pending_ = false;
+      staging_->setLoadCancelled(false);
+    }
+    staging_ready_ = true;
+    if (ready) ready();
+  });
+}
+
+bool Controller::isStagedModelReady() { return staging_ready_; }
+
+int Controller::swapStagedModel() {
+  if (!staging_ready_) return ERROR;
+  joinLoader();
+  staging_ready_ = false;
+  staging_->setProgressiveMesh(nullptr);
+  progressive_loading_ = false;
+  progressive_mesh_.clear();
+  error = staging_->getErrorCode();
+  if (!error) {
+    std::swap(model, staging_);
+    // buffers of the new model are made by setModel()
+    ModelInitialized_ = false;
+    paging_ = false;
+    pager_.clear();
+  }
+  Model *replaced = staging_;
+  loader_ = std::thread([replaced]() { replaced->deleteModel(); });
   return error;
 }
 
+Controller::string Controller::getModelPath() { return model->getFilePath(); }
+
+void Controller::setProgressive(bool enabled,
+                                std::function<void()> on_batch) {
+  progressive_enabled_ = enabled;
+  progressive_mesh_.setBatchHandler(on_batch);
+}
+
+bool Controller::getProgressive() { return progressive_enabled_; }
+
+ProgressiveMesh *Controller::getProgressiveMesh() {
+  return progressive_loading_ ? &progressive_mesh_ : nullptr;
+}
+
+Matrix4x4 Controller::getProgressiveTransformMatrix() {
+  return MatrixGenerator().matrix_mult_4x4(
+      getMvpMatrix(), progressive_mesh_.getNormalizationMatrix());
+}
+
+void Controller::setOutOfCore(const string &scratch_dir,
+                              size_t memory_budget) {
+  scratch_dir_ = scratch_dir;
+  pager_.setBudget(memory_budget);
+}
+
+void Controller::setDirectRead(bool direct) { direct_read_ = direct; }
+
+bool Controller::isPaging() { return paging_; }
+
+bool Controller::pageModel() {
+  if (!paging_ || !ModelInitialized_) return false;
+  TRACE_SCOPE("Controller::pageModel");
+  Matrix4x4 mvp = getMvpMatrix();
+  const std::vector<Meshlet> &meshlets = model->getMeshlets();
+  std::vector<size_t> visible, resident;
+  for (size_t i = 0; i < meshlets.size(); ++i) {
+    if (MeshletBuilder::isVisible(meshlets[i], mvp)) visible.push_back(i);
+  }
+  missing_meshlets_.clear();
+  pager_.update(visible, &resident, &missing_meshlets_);
+  if (resident == drawn_meshlets_) return false;
+  drawn_meshlets_.swap(resident);
+  packDrawnMeshlets();
+  vertices_dirty_ = true;
+  return true;
+}
+
+void Controller::packDrawnMeshlets() {
+  drawn_spans_ = pager_.getSpans(drawn_meshlets_);
+  std::vector<size_t> bases(drawn_spans_.size());
+  drawn_vertices_ = 0;
+  for (size_t i = 0; i < drawn_spans_.size(); ++i) {
+    bases[i] = drawn_vertices_;
+    drawn_vertices_ += drawn_spans_[i].last - drawn_spans_[i].first;
+  }
+  const std::vector<Meshlet> &meshlets = model->getMeshlets();
+  const unsigned int *indices = model->getIndices();
+  // the span which holds a vertex is the last one starting at or before it
+  auto before = [](unsigned int vertex, const VertexSpan &span) {
+    return vertex < span.first;
+  };
+  drawn_indices_.clear();
+  for (size_t i : drawn_meshlets_) {
+    const unsigned int *first = indices + meshlets[i].index_offset;
+    const unsigned int *last = first + meshlets[i].index_count;
+    for (const unsigned int *index = first; index != last; ++index) {
+      size_t span = std::upper_bound(drawn_spans_.begin(), drawn_spans_.end(),
+                                     *index, before) -
+                    drawn_spans_.begin() - 1;
+      drawn_indices_.push_back(bases[span] + *index - drawn_spans_[span].first);
+    }
+  }
+  resident_ranges_.clear();
+  if (!drawn_indices_.empty()) {
+    resident_ranges_.push_back({0, (unsigned int)drawn_indices_.size()});
+  }
+}
+
+bool Controller::isPagingIn() {
+  return paging_ && pager_.getRequestedCount() > 0;
+}
+
+std::vector<Vector3> Controller::getProxyPoints() {
+  std::vector<Vector3> points;
+  const std::vector<Meshlet> &meshlets = model->getMeshlets();
+  for (size_t i : missing_meshlets_) {
+    points.push_back(MatrixGenerator().single_f3d_vertex_processing(
+        meshlets[i].center, mvp_matrix_));
+  }
+  return points;
+}
+
+void Controller::joinLoader() {
+  if (loader_.joinable()) loader_.join();
+}
+
+void Controller::prepareStaging() {
+  joinLoader();
+  staging_ready_ = false;
+  progressive_loading_ = false;
+  staging_->setProgressiveMesh(nullptr);
+  if (staging_ == model) {
+    if (spare_model_ == nullptr) {
+      spare_parser_.reset(new Parser);
+      spare_model_.reset(new Model(spare_parser_.get()));
+    }
+    staging_ = spare_model_.get();
+  }
+  staging_->setScratchDir(scratch_dir_);
+  staging_->setDirectRead(direct_read_);
+  staging_->setLoadCancelled(false);
+}
+
+void Controller::loadStaging(const std::string &fileName) {
+  TRACE_SCOPE("Controller::loadStaging");
+  ScopedTimer timer(v_profiler_load);
+  staging_->deleteModel();
+  staging_->uploadModel(fileName);
+  staging_->initModel();
+}
+
 void Controller::resetState() {
   scale_ = 1.0f;
   rotation_angles_.x() = 0.0f;
@@ -104,27 +288,356 @@ int Controller::getEdgesNumber() { return model->getIndicesCount() * 3; }
 int Controller::getIndicesCount() { return model->getIndicesCount(); }
 unsigned int *Controller::getIndices() { return model->getIndices(); }
 
+Vector3 *Controller::getModelVertices() { return model->getVertices3d(); }
+
 void Controller::setModel() {
   ModelInitialized_ = true;
-  if (vertices_copy_ != nullptr) {
-    delete[] vertices_copy_;
+  vertices_dirty_ = true;
+  commands_.clear();
+  deleteVerticesCopy();
+  paging_ = model->isOutOfCore();
+  drawn_meshlets_.clear();
+  drawn_spans_.clear();
+  drawn_indices_.clear();
+  drawn_vertices_ = 0;
+  resident_ranges_.clear();
+  missing_meshlets_.clear();
+  if (paging_) {
+    pager_.reset(&model->getVerticesFile(), &model->getIndicesFile(),
+                 model->getMeshlets());
+    quantized_ = false;
+  } else {
+    pager_.clear();
   }
-  vertices_copy_ = new Vector4[model->getVerticesCount()];
+  // pages of the copy are touched only by the vertices transformed into it
+  vertices_copy_ = new Vector3[getStreamVerticesCount()];
 }
 
-void Controller::updateModel() {
-  Matrix4x4 result_matrix =
-      MatrixGenerator().matrix_mult_4x4(view_matrix_, compileModelMatrix());
-  result_matrix =
-      MatrixGenerator().matrix_mult_4x4(projection_matrix_, result_matrix);
-  if (ModelInitialized_) {
-    MatrixGenerator().f4d_vertex_array_processing(
-        model->getVertices4d(), vertices_copy_, model->getVerticesCount(),
+void Controller::deleteVerticesCopy() {
+  delete[] vertices_copy_;
+  vertices_copy_ = nullptr;
+}
+
+void Controller::updateModel() { updateModel(vertices_copy_); }
+
+void Controller::updateModel(Vector3 *output) {
+  TRACE_SCOPE("Controller::updateModel");
+  ScopedTimer timer(v_profiler_transform);
+  Matrix4x4 result_matrix = getMvpMatrix();
+  mvp_matrix_ = result_matrix;
+  vertices_dirty_ = false;
+  if (ModelInitialized_ && !quantized_ && paging_) {
+    // other vertices are not drawn and are not read into memory
+    Vector3 *packed = output;
+    for (const VertexSpan &span : drawn_spans_) {
+      MatrixGenerator().f3d_vertex_array_processing(
+          model->getVertices3d() + span.first, packed,
+          span.last - span.first, result_matrix);
+      packed += span.last - span.first;
+    }
+  } else if (ModelInitialized_ && !quantized_) {
+    MatrixGenerator().f3d_vertex_array_processing(
+        model->getVertices3d(), output, model->getVerticesCount(),
         result_matrix);
   }
 }
 
-Vector4 *Controller::getVerticesCopy() { return vertices_copy_; }
+Vector3 *Controller::getVerticesCopy() { return vertices_copy_; }
+
+int Controller::getStreamVerticesCount() {
+  if (paging_) return pager_.getVertexCapacity();
+  return model->getVerticesCount();
+}
+
+int Controller::getDrawnVerticesCount() {
+  if (paging_) return drawn_vertices_;
+  return model->getVerticesCount();
+}
+
+unsigned int *Controller::getDrawnIndices() {
+  if (paging_) return drawn_indices_.data();
+  return model->getIndices();
+}
+
+int Controller::getDrawnIndicesCount() {
+  if (paging_) return drawn_indices_.size();
+  return model->getIndicesCount();
+}
+
+void Controller::setQuantized(bool quantized) {
+  // packing reads every vertex of the model
+  if (paging_) return;
+  if (quantized != quantized_) vertices_dirty_ = true;
+  quantized_ = quantized;
+}
+
+bool Controller::isTransformChanged() {
+  if (vertices_dirty_) return true;
+  Matrix4x4 mvp = getMvpMatrix();
+  for (int row = 0; row < 4; ++row) {
+    for (int col = 0; col < 4; ++col) {
+      if (mvp(row, col) != mvp_matrix_(row, col)) return true;
+    }
+  }
+  return false;
+}
+
+void Controller::execute(v_command_types type, float value) {
+  float values[3];
+  getCommandValues(type, values);
+  values[0] = value;
+  executeValues(type, values);
+}
+
+void Controller::execute(v_command_types type, Vector3 color) {
+  const float values[3] = {color.r(), color.g(), color.b()};
+  executeValues(type, values);
+}
+
+void Controller::executeValues(v_command_types type, const float *values) {
+  ControllerCommand command = {type, {}, {}, false};
+  getCommandValues(type, command.before);
+  std::copy(values, values + 3, command.after);
+  if (std::equal(command.before, command.before + 3, command.after)) return;
+  setCommandValues(type, command.after);
+  commands_.record(command);
+  recordEvent(v_interaction_command, type, command.after);
+}
+
+void Controller::beginCommandGroup() {
+  commands_.beginGroup();
+  recordEvent(v_interaction_group_begin);
+}
+
+void Controller::endCommandGroup() {
+  commands_.endGroup();
+  recordEvent(v_interaction_group_end);
+}
+
+void Controller::endCommandFrame() {
+  commands_.endFrame();
+  recordEvent(v_interaction_frame);
+}
+
+bool Controller::undo() {
+  std::vector<ControllerCommand> group;
+  if (!commands_.undo(&group)) return false;
+  for (const ControllerCommand &command : group) {
+    setCommandValues(command.type, command.before);
+  }
+  recordEvent(v_interaction_undo);
+  return true;
+}
+
+bool Controller::redo() {
+  std::vector<ControllerCommand> group;
+  if (!commands_.redo(&group)) return false;
+  for (const ControllerCommand &command : group) {
+    setCommandValues(command.type, command.after);
+  }
+  recordEvent(v_interaction_redo);
+  return true;
+}
+
+void Controller::startRecording(InteractionTrace *trace) {
+  trace_ = nullptr;
+  trace->clear();
+  trace->setModelPath(model->getFilePath());
+  record_start_ = CommandQueue::Clock::now();
+  trace_ = trace;
+  for (int type = 0; type < v_command_types_count; ++type) {
+    float values[3];
+    getCommandValues((v_command_types)type, values);
+    recordEvent(v_interaction_state, (v_command_types)type, values);
+  }
+}
+
+void Controller::stopRecording() { trace_ = nullptr; }
+
+bool Controller::isRecording() { return trace_ != nullptr; }
+
+void Controller::recordEvent(v_interaction_events type,
+                             v_command_types command, const float *values) {
+  if (trace_ == nullptr) return;
+  InteractionEvent event = {0, type, command, {0.0f, 0.0f, 0.0f}};
+  event.time_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                      CommandQueue::Clock::now() - record_start_)
+                      .count();
+  if (values != nullptr) std::copy(values, values + 3, event.values);
+  trace_->add(event);
+}
+
+void Controller::replayEvent(const InteractionEvent &event) {
+  bool known_command =
+      event.command >= 0 && event.command < v_command_types_count;
+  switch (event.type) {
+    case v_interaction_state:
+      if (known_command) {
+        setCommandValues((v_command_types)event.command, event.values);
+      }
+      break;
+    case v_interaction_command:
+      if (known_command) {
+        executeValues((v_command_types)event.command, event.values);
+      }
+      break;
+    case v_interaction_undo:
+      undo();
+      break;
+    case v_interaction_redo:
+      redo();
+      break;
+    case v_interaction_group_begin:
+      beginCommandGroup();
+      break;
+    case v_interaction_group_end:
+      endCommandGroup();
+      break;
+    case v_interaction_frame:
+    default:
+      break;
+  }
+}
+
+void Controller::getCommandValues(v_command_types type, float *values) {
+  Vector3 color;
+  values[0] = values[1] = values[2] = 0.0f;
+  switch (type) {
+    case v_command_rotation_x:
+      values[0] = rotation_angles_.x();
+      break;
+    case v_command_rotation_y:
+      values[0] = rotation_angles_.y();
+      break;
+    case v_command_rotation_z:
+      values[0] = rotation_angles_.z();
+      break;
+    case v_command_translation_x:
+      values[0] = translation_vector_.x();
+      break;
+    case v_command_translation_y:
+      values[0] = translation_vector_.y();
+      break;
+    case v_command_translation_z:
+      values[0] = translation_vector_.z();
+      break;
+    case v_command_scale:
+      values[0] = scale_;
+      break;
+    case v_command_projection_type:
+      values[0] = getProjectionTypeIndex();
+      break;
+    case v_command_line_type:
+      values[0] = getLineTypeIndex();
+      break;
+    case v_command_display_type:
+      values[0] = getDisplayTypeIndex();
+      break;
+    case v_command_line_width:
+      values[0] = getLineWidth();
+      break;
+    case v_command_vertex_size:
+      values[0] = getVertexSize();
+      break;
+    case v_command_background_color:
+    case v_command_line_color:
+    case v_command_vertices_color:
+      color = type == v_command_background_color ? getBackgroundColor()
+              : type == v_command_line_color      ? getLineColor()
+                                                  : getVerticesColor();
+      values[0] = color.r();
+      values[1] = color.g();
+      values[2] = color.b();
+      break;
+    default:
+      break;
+  }
+}
+
+void Controller::setCommandValues(v_command_types type, const float *values) {
+  switch (type) {
+    case v_command_rotation_x:
+      setRotationAnglesX(values[0]);
+      break;
+    case v_command_rotation_y:
+      setRotationAnglesY(values[0]);
+      break;
+    case v_command_rotation_z:
+      setRotationAnglesZ(values[0]);
+      break;
+    case v_command_translation_x:
+      setTranslationVectorX(values[0]);
+      break;
+    case v_command_translation_y:
+      setTranslationVectorY(values[0]);
+      break;
+    case v_command_translation_z:
+      setTranslationVectorZ(values[0]);
+      break;
+    case v_command_scale:
+      setScale(values[0]);
+      break;
+    case v_command_projection_type:
+      setProjectionType((int)values[0]);
+      break;
+    case v_command_line_type:
+      setLineType((int)values[0]);
+      break;
+    case v_command_display_type:
+      setDisplayType((int)values[0]);
+      break;
+    case v_command_line_width:
+      setLineWidth(values[0]);
+      break;
+    case v_command_vertex_size:
+      setVertexSize(values[0]);
+      break;
+    case v_command_background_color:
+      setBackgroundColorR(values[0]);
+      setBackgroundColorG(values[1]);
+      setBackgroundColorB(values[2]);
+      break;
+    case v_command_line_color:
+      setLineColorR(values[0]);
+      setLineColorG(values[1]);
+      setLineColorB(values[2]);
+      break;
+    case v_command_vertices_color:
+      setVerticesColorR(values[0]);
+      setVerticesColorG(values[1]);
+      setVerticesColorB(values[2]);
+      break;
+    default:
+      break;
+  }
+}
+
+bool Controller::getQuantized() { return quantized_; }
+
+QuantizedPositions Controller::getQuantizedPositions() {
+  QuantizedPositions positions = model->quantizePositions();
+  dequantization_matrix_ = PositionQuantizer::dequantizationMatrix(positions);
+  quantization_error_ = positions.max_error;
+  return positions;
+}
+
+float Controller::getQuantizationError() { return quantization_error_; }
+
+Matrix4x4 Controller::getQuantizedTransformMatrix() {
+  return MatrixGenerator().matrix_mult_4x4(mvp_matrix_,
+                                           dequantization_matrix_);
+}
+
+std::vector<IndexRange> Controller::getVisibleRanges() {
+  if (paging_) return resident_ranges_;
+  return MeshletBuilder::visibleRanges(model->getMeshlets(), mvp_matrix_);
+}
+
+Matrix4x4 Controller::getMvpMatrix() {
+  Matrix4x4 matrix =
+      MatrixGenerator().matrix_mult_4x4(view_matrix_, compileModelMatrix());
+  return MatrixGenerator().matrix_mult_4x4(projection_matrix_, matrix);
+}
 
 Matrix4x4 Controller::compileModelMatrix() {
   Matrix4x4 matrix = MatrixGenerator().generate_XYZaxis_rotation_matrix(
@@ -138,10 +651,18 @@ Matrix4x4 Controller::compileModelMatrix() {
 }
 
 void Controller::uploadSettings() {
-  settings->uploadSettings(SETTINGS_PATH);
+  if (settings_store_) settings_store_->flush();
+  settings->uploadSettings(settings_path);
 }
 
-void Controller::saveSettings() { settings->saveSettings(SETTINGS_PATH); }
+void Controller::saveSettings() {
+  if (!settings_store_) settings_store_.reset(new SettingsStore(settings_path));
+  // writes are asynchronous, so a failed one is reported by the next save
+  if (settings_store_->getError() != v_settings_OK) {
+    settings->setError(settings_store_->getError());
+  }
+  settings_store_->save(*settings);
+}
 
 void Controller::setProjectionType(int index) {
   if (index == 0) {
@@ -300,3 +821,21 @@ bool Controller::toColor() {
   }
   return output;
 }
+
+void Controller::beginCapture(v_capture_axis axis, int frames_count) {
+  // compileModelMatrix() turns about X by y() and about Y by x()
+  if (axis == v_capture_axis_x) {
+    axis = v_capture_axis_y;
+  } else if (axis == v_capture_axis_y) {
+    axis = v_capture_axis_x;
+  }
+  capture_ = CaptureSequence(axis, frames_count, rotation_angles_);
+}
+
+int Controller::getCaptureFramesCount() { return capture_.getFramesCount(); }
+
+void Controller::setCaptureFrame(int frame) {
+  rotation_angles_ = capture_.anglesAt(frame);
+}
+
+void Controller::endCapture() { rotation_angles_ = capture_.getStartAngles(); }
@@ -0,0 +1,296 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <chrono>
+#include <filesystem>
+#include <future>
+#include <set>
+#include <string>
+#include <thread>
+
+#include "controller.h"
+
+#define EPSILON 1e-5
+
+TEST(CaptureTest, TestCapture1) {
+  Settings settings;
+  Parser parser;
+  Model model(&parser);
+  Controller controller(&model, &settings);
+  controller.resetState();
+  const float point[] = {0.3f, 0.7f, -0.4f, 1.0f};
+  // every frame of a turntable keeps coordinate along its axis
+  for (int axis = v_capture_axis_x; axis <= v_capture_axis_z; ++axis) {
+    controller.beginCapture((v_capture_axis)axis, 8);
+    for (int frame = 1; frame < controller.getCaptureFramesCount(); ++frame) {
+      controller.setCaptureFrame(frame);
+      Matrix4x4 matrix = controller.compileModelMatrix();
+      float moved = 0.0f;
+      for (int col = 0; col < 4; ++col) moved += matrix(axis, col) * point[col];
+      EXPECT_NEAR(moved, point[axis], EPSILON) << axis << " " << frame;
+    }
+    controller.endCapture();
+  }
+  EXPECT_NEAR(controller.getRotationAnglesX(), 0.0f, EPSILON);
+  EXPECT_NEAR(controller.getRotationAnglesY(), 0.0f, EPSILON);
+}
+
+TEST(CommandQueueTest, TestCommandQueue1) {
+  Settings settings;
+  Parser parser;
+  Model model(&parser);
+  Controller controller(&model, &settings);
+  controller.resetState();
+  // a drag is one step, however many frames it takes
+  controller.beginCommandGroup();
+  for (int frame = 1; frame <= 10; ++frame) {
+    controller.execute(v_command_rotation_x, frame * 0.1f);
+    controller.execute(v_command_rotation_y, frame * 0.2f);
+    controller.endCommandFrame();
+  }
+  controller.endCommandGroup();
+  EXPECT_TRUE(controller.undo());
+  EXPECT_NEAR(controller.getRotationAnglesX(), 0.0f, EPSILON);
+  EXPECT_NEAR(controller.getRotationAnglesY(), 0.0f, EPSILON);
+  EXPECT_FALSE(controller.undo());
+  EXPECT_TRUE(controller.redo());
+  EXPECT_NEAR(controller.getRotationAnglesX(), 1.0f, EPSILON);
+  EXPECT_NEAR(controller.getRotationAnglesY(), 2.0f, EPSILON);
+  EXPECT_FALSE(controller.redo());
+}
+
+TEST(CommandQueueTest, TestCommandQueue2) {
+  Settings settings;
+  Parser parser;
+  Model model(&parser);
+  Controller controller(&model, &settings);
+  controller.resetState();
+  // commands of one kind in separate frames are separate steps
+  controller.execute(v_command_translation_x, 0.5f);
+  controller.endCommandFrame();
+  controller.execute(v_command_translation_x, 0.7f);
+  controller.endCommandFrame();
+  controller.execute(v_command_scale, 2.0f);
+  controller.execute(v_command_line_color, Vector3(0.1f, 0.2f, 0.3f));
+  controller.endCommandFrame();
+  Vector3 color = controller.getLineColor();
+  EXPECT_NEAR(color.g(), 0.2f, EPSILON);
+
+  EXPECT_TRUE(controller.undo());
+  color = controller.getLineColor();
+  EXPECT_NE(color.g(), 0.2f);
+  EXPECT_NEAR(controller.getScale(), 2.0f, EPSILON);
+  EXPECT_TRUE(controller.undo());
+  EXPECT_NE(controller.getScale(), 2.0f);
+  EXPECT_TRUE(controller.undo());
+  EXPECT_NEAR(controller.getTranslationVectorX(), 0.5f, EPSILON);
+  EXPECT_TRUE(controller.undo());
+  EXPECT_NEAR(controller.getTranslationVectorX(), 0.0f, EPSILON);
+
+  EXPECT_TRUE(controller.redo());
+  EXPECT_TRUE(controller.redo());
+  EXPECT_TRUE(controller.redo());
+  EXPECT_TRUE(controller.redo());
+  EXPECT_NEAR(controller.getTranslationVectorX(), 0.7f, EPSILON);
+  EXPECT_NEAR(controller.getScale(), 2.0f, EPSILON);
+  color = controller.getLineColor();
+  EXPECT_NEAR(color.r(), 0.1f, EPSILON);
+  EXPECT_NEAR(color.g(), 0.2f, EPSILON);
+  EXPECT_NEAR(color.b(), 0.3f, EPSILON);
+}
+
+TEST(CommandQueueTest, TestCommandQueue3) {
+  Settings settings;
+  Parser parser;
+  Model model(&parser);
+  Controller controller(&model, &settings);
+  controller.resetState();
+  controller.execute(v_command_scale, 3.0f);
+  controller.endCommandFrame();
+  // a reset of several values is undone as one step
+  controller.beginCommandGroup();
+  controller.execute(v_command_rotation_z, 1.5f);
+  controller.execute(v_command_translation_y, -0.5f);
+  controller.execute(v_command_scale, 1.0f);
+  controller.execute(v_command_vertices_color, Vector3(1.0f, 0.0f, 0.0f));
+  controller.endCommandGroup();
+  controller.endCommandFrame();
+  EXPECT_TRUE(controller.undo());
+  EXPECT_NEAR(controller.getRotationAnglesZ(), 0.0f, EPSILON);
+  EXPECT_NEAR(controller.getTranslationVectorY(), 0.0f, EPSILON);
+  EXPECT_NEAR(controller.getScale(), 3.0f, EPSILON);
+  // a new command drops the undone ones
+  controller.execute(v_command_translation_z, 0.25f);
+  EXPECT_FALSE(controller.redo());
+  EXPECT_NEAR(controller.getRotationAnglesZ(), 0.0f, EPSILON);
+  EXPECT_TRUE(controller.undo());
+  EXPECT_NEAR(controller.getTranslationVectorZ(), 0.0f, EPSILON);
+  EXPECT_NEAR(controller.getScale(), 3.0f, EPSILON);
+  EXPECT_TRUE(controller.undo());
+  EXPECT_FALSE(controller.undo());
+}
+
+// loads the file in background and waits until it is staged
+static void loadAndWait(Controller *controller, const std::string &name) {
+  std::promise<std::thread::id> ready;
+  std::future<std::thread::id> loader = ready.get_future();
+  controller->loadModelAsync(std::string(OBJECTS_PATH) + "/" + name,
+                             [&ready]() {
+                               ready.set_value(std::this_thread::get_id());
+                             });
+  EXPECT_NE(loader.get(), std::this_thread::get_id());
+  EXPECT_TRUE(controller->isStagedModelReady());
+}
+
+TEST(StagingTest, TestStaging1) {
+  Settings settings;
+  Parser parser;
+  Model model(&parser);
+  Controller controller(&model, &settings);
+  ASSERT_EQ(controller.uploadModel(std::string(OBJECTS_PATH) +
+                                   "/test_triangle.obj"),
+            OK);
+  controller.setModel();
+  EXPECT_EQ(controller.getVerticesCount(), 3);
+
+  loadAndWait(&controller, "cube.obj");
+  // the rendered model is kept until the swap
+  EXPECT_EQ(controller.getVerticesCount(), 3);
+  // settings in memory are current, the swap does not read them again
+  controller.setLineWidth(7.0f);
+  EXPECT_EQ(controller.swapStagedModel(), OK);
+  EXPECT_EQ(controller.getLineWidth(), 7.0f);
+  EXPECT_FALSE(controller.isStagedModelReady());
+  controller.setModel();
+  EXPECT_EQ(controller.getVerticesCount(), 8);
+  EXPECT_NE(controller.getModelPath().find("cube.obj"), std::string::npos);
+}
+
+TEST(StagingTest, TestStaging2) {
+  Settings settings;
+  Parser parser;
+  Model model(&parser);
+  Controller controller(&model, &settings);
+  ASSERT_EQ(controller.uploadModel(std::string(OBJECTS_PATH) + "/cube.obj"),
+            OK);
+  controller.setModel();
+  Vector3 *rendered = controller.getModelVertices();
+
+  loadAndWait(&controller, "missing.obj");
+  int error = controller.swapStagedModel();
+  EXPECT_EQ(error, ERROR_FILE);
+  EXPECT_FALSE(controller.errorHandler(error).empty());
+  // a failed load keeps the rendered model
+  EXPECT_TRUE(controller.getModelInitialized());
+  EXPECT_EQ(controller.getVerticesCount(), 8);
+  EXPECT_EQ(controller.getModelVertices(), rendered);
+  EXPECT_NE(controller.getModelPath().find("cube.obj"), std::string::npos);
+}
+
+TEST(StagingTest, TestStaging3) {
+  Settings settings;
+  Parser parser;
+  Model model(&parser);
+  Controller controller(&model, &settings);
+  ASSERT_EQ(controller.uploadModel(std::string(OBJECTS_PATH) +
+                                   "/test_triangle.obj"),
+            OK);
+  controller.setModel();
+  // every swap frees the replaced model on the loader thread, the next
+  // load joins it before the model is loaded again
+  const char *names[] = {"cube.obj", "test_triangle.obj", "cube.obj",
+                         "test_triangle.obj"};
+  const int vertices[] = {8, 3, 8, 3};
+  for (int i = 0; i < 4; ++i) {
+    loadAndWait(&controller, names[i]);
+    EXPECT_EQ(controller.swapStagedModel(), OK) << i;
+    controller.setModel();
+    EXPECT_EQ(controller.getVerticesCount(), vertices[i]) << i;
+    EXPECT_NE(controller.getModelPath().find(names[i]), std::string::npos);
+  }
+}
+
+TEST(StagingTest, TestStaging4) {
+  Settings settings;
+  Parser parser;
+  Model model(&parser);
+  Controller controller(&model, &settings);
+  ASSERT_EQ(controller.uploadModel(std::string(OBJECTS_PATH) +
+                                   "/test_triangle.obj"),
+            OK);
+  controller.setModel();
+  // the second file supersedes the first one instead of waiting for it
+  controller.loadModelAsync(std::string(OBJECTS_PATH) + "/cow.obj");
+  loadAndWait(&controller, "cube.obj");
+  EXPECT_EQ(controller.swapStagedModel(), OK);
+  controller.setModel();
+  EXPECT_EQ(controller.getVerticesCount(), 8);
+  EXPECT_NE(controller.getModelPath().find("cube.obj"), std::string::npos);
+
+  // a load still parsed when the controller is destroyed is stopped
+  controller.loadModelAsync(std::string(OBJECTS_PATH) + "/cow.obj");
+}
+
+TEST(PagingTest, TestPaging1) {
+  Settings settings;
+  Parser parser;
+  Model model(&parser);
+  Controller controller(&model, &settings);
+  Parser full_parser;
+  Model full_model(&full_parser);
+  full_model.uploadModel(std::string(OBJECTS_PATH) + "/cow.obj");
+  full_model.initModel();
+  ASSERT_EQ(full_model.getErrorCode(), OK);
+  // half of the vertices with their transformed copies fit into the budget
+  size_t budget = sizeof(Vector3) * full_model.getVerticesCount();
+  controller.setOutOfCore(std::filesystem::temp_directory_path(), budget);
+  ASSERT_EQ(controller.uploadModel(std::string(OBJECTS_PATH) + "/cow.obj"),
+            OK);
+  controller.setModel();
+  ASSERT_TRUE(controller.isPaging());
+  EXPECT_LE(controller.getStreamVerticesCount(),
+            (int)(budget / (2 * sizeof(Vector3))));
+
+  controller.setModelMatrixes();
+  bool changed = false;
+  for (int frame = 0; frame < 1000; ++frame) {
+    changed = controller.pageModel() || changed;
+    if (!controller.isPagingIn()) break;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  ASSERT_TRUE(changed);
+  controller.updateModel();
+  int count = controller.getDrawnVerticesCount();
+  EXPECT_GT(count, 0);
+  EXPECT_LE(count, controller.getStreamVerticesCount());
+
+  // triangles of packed vertices are triangles of the model
+  Matrix4x4 mvp = controller.getMvpMatrix();
+  std::set<std::array<float, 9>> triangles;
+  for (size_t i = 0; i + 2 < full_model.getIndicesCount(); i += 3) {
+    std::array<float, 9> triangle;
+    for (int corner = 0; corner < 3; ++corner) {
+      Vector3 vertex = MatrixGenerator().single_f3d_vertex_processing(
+          full_model.getVertices3d()[full_model.getIndices()[i + corner]],
+          mvp);
+      for (int axis = 0; axis < 3; ++axis) {
+        triangle[corner * 3 + axis] = vertex(axis);
+      }
+    }
+    triangles.insert(triangle);
+  }
+  unsigned int *indices = controller.getDrawnIndices();
+  ASSERT_GT(controller.getDrawnIndicesCount(), 0);
+  for (int i = 0; i + 2 < controller.getDrawnIndicesCount(); i += 3) {
+    std::array<float, 9> triangle;
+    for (int corner = 0; corner < 3; ++corner) {
+      ASSERT_LT(indices[i + corner], (unsigned int)count);
+      Vector3 vertex = controller.getVerticesCopy()[indices[i + corner]];
+      for (int axis = 0; axis < 3; ++axis) {
+        triangle[corner * 3 + axis] = vertex(axis);
+      }
+    }
+    EXPECT_EQ(triangles.count(triangle), 1u) << i;
+  }
+  full_model.deleteModel();
+}
@@ -0,0 +1,155 @@
+#ifndef SRC_CORE_INCLUDE_VIEWER_CORE_H
+#define SRC_CORE_INCLUDE_VIEWER_CORE_H
+
+/**
+ * @file viewer_core.h
+ * @author SevenStreams
+ * @brief This file handles the C interface of the viewer pipeline
+ * @version 0.1
+ * @date 2024-03-15
+ *
+ * @copyright Copyright (c) 2024
+ *
+ * The interface loads .obj models, sets their transform and exports
+ * transformed geometry without Qt or a display. A core is used by one
+ * thread at a time, different cores may be used in parallel. The interface
+ * is for programs embedding the pipeline. The Qt viewer does not use it
+ * yet, it drives Controller directly; moving the viewer onto the interface
+ * needs settings, staged loading, paging and capture here first.
+ */
+
+#include <stddef.h>
+
+#define VIEWER_CORE_PROJECTION_PARALLEL 0
+#define VIEWER_CORE_PROJECTION_CENTRAL 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Model with its transform
+ *
+ */
+typedef struct ViewerCore ViewerCore;
+
+/**
+ * @brief The function creates a core without model
+ *
+ * @return ViewerCore* The core or NULL if there is no memory
+ */
+ViewerCore *viewer_core_create(void);
+
+/**
+ * @brief The function destroys the core and its model
+ *
+ * @param core The core, may be NULL
+ */
+void viewer_core_destroy(ViewerCore *core);
+
+/**
+ * @brief The function loads and normalizes the model, resetting transform
+ *
+ * @param core The core
+ * @param path Path of the .obj file
+ * @return int 0 or error code of the model
+ */
+int viewer_core_load(ViewerCore *core, const char *path);
+
+/**
+ * @brief The function returns the message of the last error of load
+ *
+ * @param core The core
+ * @return const char* The message, valid until the next call with the core
+ */
+const char *viewer_core_error_message(ViewerCore *core);
+
+/**
+ * @brief The function sets rotation of the model
+ *
+ * @param core The core
+ * @param x Angle around x, radians
+ * @param y Angle around y, radians
+ * @param z Angle around z, radians
+ */
+void viewer_core_set_rotation(ViewerCore *core, float x, float y, float z);
+
+/**
+ * @brief The function sets translation of the model
+ *
+ * @param core The core
+ * @param x Translation along x
+ * @param y Translation along y
+ * @param z Translation along z
+ */
+void viewer_core_set_translation(ViewerCore *core, float x, float y, float z);
+
+/**
+ * @brief The function sets scale of the model
+ *
+ * @param core The core
+ * @param scale The scale
+ */
+void viewer_core_set_scale(ViewerCore *core, float scale);
+
+/**
+ * @brief The function sets projection
+ *
+ * @param core The core
+ * @param projection VIEWER_CORE_PROJECTION_PARALLEL or
+ * VIEWER_CORE_PROJECTION_CENTRAL
+ */
+void viewer_core_set_projection(ViewerCore *core, int projection);
+
+/**
+ * @brief The function returns the matrix applied to model vertices
+ *
+ * @param core The core
+ * @param matrix Sixteen values of the row-major matrix
+ */
+void viewer_core_get_mvp(ViewerCore *core, float *matrix);
+
+/**
+ * @brief The function returns number of vertices of the model
+ *
+ * @param core The core
+ * @return size_t Number of vertices, 0 without model
+ */
+size_t viewer_core_vertices_count(ViewerCore *core);
+
+/**
+ * @brief The function returns number of edge indices of the model
+ *
+ * Sides shared by triangles of the model are one edge.
+ *
+ * @param core The core
+ * @return size_t Number of indices, two per edge
+ */
+size_t viewer_core_indices_count(ViewerCore *core);
+
+/**
+ * @brief The function writes transformed vertices of the model
+ *
+ * @param core The core
+ * @param vertices Three floats for each of viewer_core_vertices_count()
+ * @return int 0, or 1 without model
+ */
+int viewer_core_export_vertices(ViewerCore *core, float *vertices);
+
+/**
+ * @brief The function writes edges of the model
+ *
+ * Every edge is a pair of vertex indices, the lower one first, edges are
+ * sorted by the pairs.
+ *
+ * @param core The core
+ * @param indices viewer_core_indices_count() indices of vertices
+ * @return int 0, or 1 without model
+ */
+int viewer_core_export_indices(ViewerCore *core, unsigned int *indices);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_CORE_INCLUDE_VIEWER_CORE_H
@@ -0,0 +1,122 @@
+#include "viewer_core.h"
+
+#include <algorithm>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "controller.h"
+
+// vertices are written straight into the caller's float array
+static_assert(sizeof(Vector3) == 3 * sizeof(float),
+              "Vector3 must be three packed floats");
+
+struct ViewerCore {
+  Settings settings;
+  Parser parser;
+  Model model{&parser};
+  Controller controller{&model, &settings};
+  std::string message;
+  std::vector<unsigned int> edges;  // pairs of vertices of loaded model
+};
+
+// triangles share their sides, every side is kept once, lower index first
+static void buildEdges(ViewerCore *core) {
+  unsigned int *triangles = core->controller.getIndices();
+  size_t count = core->controller.getIndicesCount() / 3 * 3;
+  std::vector<std::pair<unsigned int, unsigned int>> pairs;
+  pairs.reserve(count);
+  for (size_t i = 0; i < count; i += 3) {
+    for (size_t side = 0; side < 3; ++side) {
+      unsigned int a = triangles[i + side];
+      unsigned int b = triangles[i + (side + 1) % 3];
+      if (a != b) pairs.emplace_back(std::min(a, b), std::max(a, b));
+    }
+  }
+  std::sort(pairs.begin(), pairs.end());
+  pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+  core->edges.clear();
+  core->edges.reserve(pairs.size() * 2);
+  for (const auto &edge : pairs) {
+    core->edges.push_back(edge.first);
+    core->edges.push_back(edge.second);
+  }
+}
+
+ViewerCore *viewer_core_create(void) {
+  ViewerCore *core = new (std::nothrow) ViewerCore;
+  if (core != nullptr) core->controller.resetState();
+  return core;
+}
+
+void viewer_core_destroy(ViewerCore *core) { delete core; }
+
+int viewer_core_load(ViewerCore *core, const char *path) {
+  int error = core->controller.uploadModel(path);
+  if (error) {
+    core->message = core->controller.errorHandler(error);
+  } else {
+    core->message.clear();
+    core->controller.setModel();
+    core->controller.resetState();
+    buildEdges(core);
+  }
+  return error;
+}
+
+const char *viewer_core_error_message(ViewerCore *core) {
+  return core->message.c_str();
+}
+
+void viewer_core_set_rotation(ViewerCore *core, float x, float y, float z) {
+  core->controller.setRotationAnglesX(x);
+  core->controller.setRotationAnglesY(y);
+  core->controller.setRotationAnglesZ(z);
+}
+
+void viewer_core_set_translation(ViewerCore *core, float x, float y,
+                                 float z) {
+  core->controller.setTranslationVectorX(x);
+  core->controller.setTranslationVectorY(y);
+  core->controller.setTranslationVectorZ(z);
+}
+
+void viewer_core_set_scale(ViewerCore *core, float scale) {
+  core->controller.setScale(scale);
+}
+
+void viewer_core_set_projection(ViewerCore *core, int projection) {
+  core->controller.setProjectionType(projection);
+}
+
+void viewer_core_get_mvp(ViewerCore *core, float *matrix) {
+  core->controller.setModelMatrixes();
+  Matrix4x4 mvp = core->controller.getMvpMatrix();
+  for (int row = 0; row < 4; ++row) {
+    for (int col = 0; col < 4; ++col) matrix[row * 4 + col] = mvp(row, col);
+  }
+}
+
+size_t viewer_core_vertices_count(ViewerCore *core) {
+  if (!core->controller.getModelInitialized()) return 0;
+  return core->controller.getVerticesCount();
+}
+
+size_t viewer_core_indices_count(ViewerCore *core) {
+  if (!core->controller.getModelInitialized()) return 0;
+  return core->edges.size();
+}
+
+int viewer_core_export_vertices(ViewerCore *core, float *vertices) {
+  if (!core->controller.getModelInitialized()) return 1;
+  core->controller.setModelMatrixes();
+  core->controller.updateModel(reinterpret_cast<Vector3 *>(vertices));
+  return 0;
+}
+
+int viewer_core_export_indices(ViewerCore *core, unsigned int *indices) {
+  if (!core->controller.getModelInitialized()) return 1;
+  std::copy(core->edges.begin(), core->edges.end(), indices);
+  return 0;
+}
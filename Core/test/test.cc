@@ -0,0 +1,47 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "settings_path.h"
+#include "viewer_core.h"
+
+TEST(ViewerCoreTest, TestViewerCore1) {
+  ViewerCore *core = viewer_core_create();
+  ASSERT_NE(core, nullptr);
+  std::string path = OBJECTS_PATH;
+  path += "/cube.obj";
+  ASSERT_EQ(viewer_core_load(core, path.c_str()), 0);
+  EXPECT_STREQ(viewer_core_error_message(core), "");
+
+  ASSERT_EQ(viewer_core_vertices_count(core), 8u);
+  std::vector<float> vertices(viewer_core_vertices_count(core) * 3);
+  EXPECT_EQ(viewer_core_export_vertices(core, vertices.data()), 0);
+
+  // twelve sides of the cube and a diagonal of each of six quads
+  const unsigned int real_result[] = {0, 1, 0, 2, 0, 3, 0, 4, 0, 5, 1, 2,
+                                      1, 5, 1, 6, 2, 3, 2, 6, 2, 7, 3, 4,
+                                      3, 7, 4, 5, 4, 6, 4, 7, 5, 6, 6, 7};
+  size_t count = sizeof(real_result) / sizeof(real_result[0]);
+  ASSERT_EQ(viewer_core_indices_count(core), count);
+  std::vector<unsigned int> indices(count);
+  EXPECT_EQ(viewer_core_export_indices(core, indices.data()), 0);
+  for (size_t i = 0; i < count; ++i) EXPECT_EQ(indices[i], real_result[i]);
+  viewer_core_destroy(core);
+}
+
+TEST(ViewerCoreTest, TestViewerCore2) {
+  ViewerCore *core = viewer_core_create();
+  ASSERT_NE(core, nullptr);
+  EXPECT_EQ(viewer_core_vertices_count(core), 0u);
+  EXPECT_EQ(viewer_core_indices_count(core), 0u);
+  unsigned int index = 0;
+  EXPECT_EQ(viewer_core_export_indices(core, &index), 1);
+
+  std::string path = OBJECTS_PATH;
+  path += "/missing.obj";
+  EXPECT_NE(viewer_core_load(core, path.c_str()), 0);
+  EXPECT_STRNE(viewer_core_error_message(core), "");
+  EXPECT_EQ(viewer_core_indices_count(core), 0u);
+  viewer_core_destroy(core);
+}
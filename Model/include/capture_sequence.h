@@ -0,0 +1,74 @@
+#if !defined(SRC_MODEL_INCLUDE_CAPTURE_SEQUENCE_H)
+#define SRC_MODEL_INCLUDE_CAPTURE_SEQUENCE_H
+
+/**
+ * @file capture_sequence.h
+ * @author SevenStreams
+ * @brief This file handles camera steps of recorded animations
+ * @version 0.1
+ * @date 2024-03-15
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "matrix.h"
+
+/**
+ * @brief Axes of turntable rotation
+ *
+ */
+typedef enum e_capture_axis {
+  v_capture_axis_x,
+  v_capture_axis_y,
+  v_capture_axis_z
+} v_capture_axis;
+
+/**
+ * @brief Turntable of frames_count frames around one axis
+ *
+ * Angle of every frame is computed from its index, not accumulated, so the
+ * same sequence gives the same frames on every run.
+ */
+class CaptureSequence {
+ public:
+  /**
+   * @brief The function handles initializing capture sequence
+   *
+   * @param axis Axis of rotation
+   * @param frames_count Number of frames in full turn
+   * @param start_angles Rotation angles of the first frame, radians
+   * @return CaptureSequence
+   */
+  CaptureSequence(v_capture_axis axis, int frames_count,
+                  const Vector3& start_angles);
+
+  /**
+   * @brief The function returns rotation angles of the frame
+   *
+   * @param frame Index of frame
+   * @return Vector3 Angles in radians
+   */
+  Vector3 anglesAt(int frame) const;
+
+  /**
+   * @brief The function returns number of frames
+   *
+   * @return int Number of frames
+   */
+  int getFramesCount() const;
+
+  /**
+   * @brief The function returns rotation angles of the first frame
+   *
+   * @return Vector3 Angles in radians
+   */
+  Vector3 getStartAngles() const;
+
+ private:
+  v_capture_axis axis_;
+  int frames_count_;
+  Vector3 start_angles_;
+};
+
+#endif  // SRC_MODEL_INCLUDE_CAPTURE_SEQUENCE_H
@@ -0,0 +1,137 @@
+#if !defined(SRC_MODEL_INCLUDE_DECOMPRESS_BUFFER_H)
+#define SRC_MODEL_INCLUDE_DECOMPRESS_BUFFER_H
+
+/**
+ * @file decompress_buffer.h
+ * @author SevenStreams
+ * @brief This file handles reading of compressed .obj files
+ * @version 0.1
+ * @date 2024-03-15
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+#define DECOMPRESS_BUFFER_MAGIC_BYTES 4
+#define DECOMPRESS_BUFFER_BLOCK_SIZE (1 << 16)  // bytes
+#define DECOMPRESS_BUFFER_BLOCKS 16  // decompressed blocks waiting for parser
+
+typedef enum e_compression {
+  v_compression_none,
+  v_compression_gzip,
+  v_compression_zstd
+} v_compression;
+
+/**
+ * @brief Stream buffer of data decompressed on another thread
+ *
+ * The decoder thread reads the compressed source and fills blocks which
+ * wait in a bounded queue, so the file is decompressed while the reader
+ * parses the blocks before it. The decoder waits when the queue is full,
+ * the reader waits when it is empty.
+ */
+class DecompressBuffer : public std::streambuf {
+ public:
+  DecompressBuffer() = default;
+  DecompressBuffer(const DecompressBuffer&) = delete;
+  DecompressBuffer& operator=(const DecompressBuffer&) = delete;
+
+  /**
+   * @brief The function stops the decoder thread
+   *
+   */
+  ~DecompressBuffer();
+
+  /**
+   * @brief The function detects compression by the first bytes of a file
+   *
+   * @param magic The first bytes
+   * @param size Number of the bytes
+   * @return v_compression Compression of the file
+   */
+  static v_compression detect(const char* magic, size_t size);
+
+  /**
+   * @brief The function checks if the compression may be decompressed
+   *
+   * @param compression The compression
+   * @return true if the library of the compression is built in
+   */
+  static bool isSupported(v_compression compression);
+
+  /**
+   * @brief The function starts decompressing the source on another thread
+   *
+   * The source is read by the decoder thread until close() returns.
+   *
+   * @param source Compressed data
+   * @param compression Compression of the data
+   * @return true if the compression is supported
+   */
+  bool open(std::streambuf* source, v_compression compression);
+
+  /**
+   * @brief The function stops the decoder thread and drops decoded blocks
+   *
+   */
+  void close();
+
+  /**
+   * @brief The function checks if the source is broken
+   *
+   * @return true if the decoder stopped on corrupt or truncated data
+   */
+  bool hasError() const;
+
+ protected:
+  int_type underflow() override;
+
+ private:
+  /**
+   * @brief The function decompresses the source, runs on the decoder thread
+   *
+   */
+  void decode();
+
+  bool inflateGzip();
+
+  bool decompressZstd();
+
+  /**
+   * @brief The function returns an empty block for decoded data
+   *
+   * @return std::vector<char> A block read by the reader or a new one
+   */
+  std::vector<char> takeBlock();
+
+  /**
+   * @brief The function queues a decoded block, waits while queue is full
+   *
+   * @param block The block, left empty
+   * @param bytes Decoded bytes at the start of the block
+   * @return false if the reader stopped the decoder
+   */
+  bool pushBlock(std::vector<char>* block, size_t bytes);
+
+  std::streambuf* source_ = nullptr;
+  v_compression compression_ = v_compression_none;
+  std::thread decoder_;
+  mutable std::mutex mutex_;
+  std::condition_variable changed_;
+  std::deque<std::vector<char>> blocks_;  // decoded, not read yet
+  std::vector<std::vector<char>> spare_;  // read, reused by the decoder
+  std::vector<char> current_;             // block being read
+  bool done_ = false;
+  bool stop_ = false;
+  bool error_ = false;
+};
+
+#endif  // SRC_MODEL_INCLUDE_DECOMPRESS_BUFFER_H
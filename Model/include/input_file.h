@@ -0,0 +1,96 @@
+#if !defined(SRC_MODEL_INCLUDE_INPUT_FILE_H)
+#define SRC_MODEL_INCLUDE_INPUT_FILE_H
+
+/**
+ * @file input_file.h
+ * @author SevenStreams
+ * @brief This file handles reading of model files
+ * @version 0.1
+ * @date 2024-03-15
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <cstddef>
+#include <streambuf>
+#include <string>
+
+#define INPUT_FILE_BLOCK_SIZE (1 << 20)  // bytes read by one call
+#define INPUT_FILE_ALIGNMENT 4096        // of the buffer for direct reads
+
+/**
+ * @brief Stream buffer of a file read sequentially in large blocks
+ *
+ * The file is opened once and its size is taken from the open handle, so
+ * a file on a network share costs one metadata round trip. The system is
+ * told the file is read sequentially, so it reads ahead. Direct reads go
+ * around the page cache, they are dropped if the file system refuses them.
+ */
+class InputFile : public std::streambuf {
+ public:
+  InputFile() = default;
+  InputFile(const InputFile&) = delete;
+  InputFile& operator=(const InputFile&) = delete;
+
+  /**
+   * @brief The function closes the file
+   *
+   */
+  ~InputFile();
+
+  /**
+   * @brief The function opens the file for reading
+   *
+   * @param path Path of the file
+   * @param direct True to read around the page cache
+   * @return true if the file is opened and is not a directory
+   */
+  bool open(const std::string& path, bool direct = false);
+
+  void close();
+
+  bool isOpen() const;
+
+  /**
+   * @brief The function returns size of the file when it was opened
+   *
+   * @return size_t Bytes
+   */
+  size_t size() const;
+
+  /**
+   * @brief The function checks if the file is read around the page cache
+   *
+   * @return true while direct reads are used
+   */
+  bool isDirect() const;
+
+  /**
+   * @brief The function copies the next bytes without reading them
+   *
+   * @param data Output bytes
+   * @param bytes Number of bytes to copy
+   * @return size_t Copied bytes, less at the end of the file
+   */
+  size_t peek(char* data, size_t bytes);
+
+ protected:
+  int_type underflow() override;
+
+ private:
+  /**
+   * @brief The function turns direct reads on or off
+   *
+   * @param direct True to read around the page cache
+   * @return true if the mode is changed
+   */
+  bool setDirect(bool direct);
+
+  int fd_ = -1;
+  size_t size_ = 0;
+  char* buffer_ = nullptr;  // aligned for direct reads
+  bool direct_ = false;
+};
+
+#endif  // SRC_MODEL_INCLUDE_INPUT_FILE_H
@@ -0,0 +1,144 @@
+#if !defined(SRC_MODEL_INCLUDE_INTERACTION_TRACE_H)
+#define SRC_MODEL_INCLUDE_INTERACTION_TRACE_H
+
+/**
+ * @file interaction_trace.h
+ * @author SevenStreams
+ * @brief This file handles recorded user interactions for replay
+ * @version 0.1
+ * @date 2024-03-15
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "profiler.h"
+
+#define INTERACTION_TRACE_NAME "s21_3DViewer_interactions"
+#define INTERACTION_TRACE_VERSION 1
+#define INTERACTION_TRACE_FRAME_BUDGET_MS (1000.0 / 60.0)
+
+/**
+ * @brief Kinds of recorded events
+ *
+ */
+typedef enum e_interaction_events {
+  v_interaction_state,        // value when recording started, not in history
+  v_interaction_command,      // command executed by the controller
+  v_interaction_undo,         // step back in the history
+  v_interaction_redo,         // step forward in the history
+  v_interaction_group_begin,  // start of commands undone as one step
+  v_interaction_group_end,    // end of the group
+  v_interaction_frame,        // frame drawn after the events before it
+  v_interaction_events_count
+} v_interaction_events;
+
+/**
+ * @brief Recorded event
+ *
+ */
+struct InteractionEvent {
+  int64_t time_us;  // since start of recording
+  v_interaction_events type;
+  int command;      // kind of command of state and command events
+  float values[3];  // values of state and command events
+};
+
+/**
+ * @brief Frame times of a replay
+ *
+ */
+struct ReplayReport {
+  ProfilerStats frame;        // frame times, ms
+  double budget_ms;           // time of one frame at the target rate
+  size_t dropped_frames = 0;  // frames missed because of slow ones
+  double seconds = 0.0;       // wall time of the replay
+
+  /**
+   * @brief The function returns the report as text
+   *
+   * @return std::string One line per value
+   */
+  std::string toString() const;
+};
+
+/**
+ * @brief Timestamped events with the model they were recorded on
+ *
+ * Traces are saved as text: a header with INTERACTION_TRACE_NAME and
+ * INTERACTION_TRACE_VERSION, the model path and one event per line.
+ */
+class InteractionTrace {
+ public:
+  /**
+   * @brief The function sets path of the model of the trace
+   *
+   * @param path Path of the .obj file
+   */
+  void setModelPath(const std::string &path);
+
+  const std::string &getModelPath() const;
+
+  /**
+   * @brief The function appends the event
+   *
+   * @param event The event, not earlier than the last one
+   */
+  void add(const InteractionEvent &event);
+
+  const std::vector<InteractionEvent> &getEvents() const;
+
+  /**
+   * @brief The function returns number of frame events
+   *
+   * @return size_t Number of frames
+   */
+  size_t getFramesCount() const;
+
+  /**
+   * @brief The function removes the model path and all events
+   *
+   */
+  void clear();
+
+  /**
+   * @brief The function writes the trace to a file
+   *
+   * @param path Path of the file
+   * @return true if the file is written
+   */
+  bool save(const std::string &path) const;
+
+  /**
+   * @brief The function reads a trace written by save()
+   *
+   * @param path Path of the file
+   * @return true if the file is a valid trace, otherwise the trace is empty
+   */
+  bool load(const std::string &path);
+
+  /**
+   * @brief The function summarizes frame times of a replay
+   *
+   * A frame longer than the budget hides the frames which should have
+   * been shown during it, they are counted as dropped.
+   *
+   * @param frame_ms Time of every frame, ms
+   * @param budget_ms Time of one frame at the target rate, ms
+   * @return ReplayReport The report
+   */
+  static ReplayReport makeReport(
+      const std::vector<double> &frame_ms,
+      double budget_ms = INTERACTION_TRACE_FRAME_BUDGET_MS);
+
+ private:
+  std::string model_path_;
+  std::vector<InteractionEvent> events_;
+};
+
+#endif  // SRC_MODEL_INCLUDE_INTERACTION_TRACE_H
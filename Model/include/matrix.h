@@ -68,6 +68,24 @@ class Vector3 {
    */
   float& b();
 
+  /**
+   * @brief Get the x component of the vector.
+   * @return Reference to the x component.
+   */
+  const float& x() const;
+
+  /**
+   * @brief Get the y component of the vector.
+   * @return Reference to the y component.
+   */
+  const float& y() const;
+
+  /**
+   * @brief Get the z component of the vector.
+   * @return Reference to the z component.
+   */
+  const float& z() const;
+
   /**
    * @brief Access element at column col
    *
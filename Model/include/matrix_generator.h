@@ -13,6 +13,7 @@
  */
 
 #include <cmath>
+#include <cstddef>
 
 #include "matrix.h"
 
@@ -152,6 +153,43 @@ class MatrixGenerator {
       out_array[i] = single_f4d_vertex_processing(in_array[i], transf_matrix);
     }
   }
+
+  /**
+   * @brief The function apply transformation matrix to the 3d vector
+   *
+   * The w component of the vertex is implicitly 1, so the last column of the
+   * matrix is added as translation without storing w per vertex.
+   *
+   * @param start_vertex
+   * @param transf_matrix
+   * @return Vector3 The result vector after perspective division
+   */
+  static inline Vector3 single_f3d_vertex_processing(
+      const Vector3& start_vertex, const Matrix4x4& transf_matrix) {
+    const float* m = &(transf_matrix(0, 0));
+    float x = start_vertex.x(), y = start_vertex.y(), z = start_vertex.z();
+    float w = m[12] * x + m[13] * y + m[14] * z + m[15];
+    return Vector3((m[0] * x + m[1] * y + m[2] * z + m[3]) / w,
+                   (m[4] * x + m[5] * y + m[6] * z + m[7]) / w,
+                   (m[8] * x + m[9] * y + m[10] * z + m[11]) / w);
+  }
+
+  /**
+   * @brief The function apply transformation matrix to all 3d vectors in the
+   * list
+   *
+   * @param in_array Input 3d vector
+   * @param out_array Output 3d vector
+   * @param count Number of vectors
+   * @param transf_matrix Matrix 4x4
+   */
+  static inline void f3d_vertex_array_processing(
+      const Vector3* in_array, Vector3* out_array, size_t count,
+      const Matrix4x4& transf_matrix) {
+    for (size_t i = 0; i < count; ++i) {
+      out_array[i] = single_f3d_vertex_processing(in_array[i], transf_matrix);
+    }
+  }
 };
 
 #endif  // SRC_MODEL_INCLUDE_MATRIX_GENERATOR_H
@@ -0,0 +1,163 @@
+#if !defined(SRC_MODEL_INCLUDE_MESH_PAGER_H)
+#define SRC_MODEL_INCLUDE_MESH_PAGER_H
+
+/**
+ * @file mesh_pager.h
+ * @author SevenStreams
+ * @brief This file handles paging meshlets of models kept in scratch files
+ * @version 0.1
+ * @date 2024-03-15
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <vector>
+
+#include "meshlet.h"
+#include "scratch_file.h"
+
+#define MESH_PAGER_DEFAULT_BUDGET ((size_t)1 << 30)  // bytes
+
+/**
+ * @brief Range of vertices
+ *
+ */
+struct VertexSpan {
+  size_t first;  // first vertex
+  size_t last;   // vertex after the last one
+};
+
+/**
+ * @brief Resident set of meshlets of a model in scratch files
+ *
+ * Every meshlet needs its indices, the vertices they reference and the
+ * transformed copy of the vertices. Visible meshlets are read in the
+ * background while the memory they take fits into the budget, meshlets which
+ * were not visible for the longest time give their memory back first. A
+ * meshlet is resident when all its pages are in memory, the others are drawn
+ * by proxies.
+ */
+class MeshPager {
+ public:
+  /**
+   * @brief The function starts paging of the model, nothing is resident
+   *
+   * @param vertices File of the vertices
+   * @param indices File of the indices
+   * @param meshlets Meshlets of the model
+   */
+  void reset(ScratchFile* vertices, ScratchFile* indices,
+             const std::vector<Meshlet>& meshlets);
+
+  /**
+   * @brief The function stops paging
+   *
+   */
+  void clear();
+
+  void setBudget(size_t bytes);
+
+  size_t getBudget() const;
+
+  /**
+   * @brief The function returns the most vertices resident meshlets reference
+   *
+   * @return size_t Vertices which fit into the budget with their copies
+   */
+  size_t getVertexCapacity() const;
+
+  /**
+   * @brief The function returns memory of read and requested meshlets
+   *
+   * @return size_t Bytes
+   */
+  size_t getResidentBytes() const;
+
+  /**
+   * @brief The function returns number of meshlets which are being read
+   *
+   * @return size_t Requested meshlets which are not resident yet
+   */
+  size_t getRequestedCount() const;
+
+  /**
+   * @brief The function requests visible meshlets and evicts the others
+   *
+   * @param visible Indices of visible meshlets in ascending order
+   * @param resident Output visible meshlets which may be drawn
+   * @param missing Output visible meshlets which are not in memory
+   * @return bool True if a meshlet became resident since the last call
+   */
+  bool update(const std::vector<size_t>& visible,
+              std::vector<size_t>* resident, std::vector<size_t>* missing);
+
+  /**
+   * @brief The function returns vertices referenced by the meshlets
+   *
+   * @param meshlets Indices of meshlets
+   * @return std::vector<VertexSpan> Sorted spans which do not overlap
+   */
+  std::vector<VertexSpan> getSpans(const std::vector<size_t>& meshlets) const;
+
+ private:
+  typedef enum e_page_state {
+    v_page_absent,
+    v_page_requested,
+    v_page_resident
+  } v_page_state;
+
+  /**
+   * @brief Pages needed by a meshlet
+   *
+   */
+  struct Page {
+    size_t index_offset;  // bytes in the file of indices
+    size_t index_bytes;
+    std::vector<VertexSpan> vertices;  // runs of referenced vertices
+    std::vector<VertexSpan> reads;     // runs joined within a memory page
+    size_t bytes;  // indices, vertices and their transformed copy
+    v_page_state state = v_page_absent;
+    uint64_t frame = 0;  // last update() the meshlet was visible
+    std::list<size_t>::iterator lru;
+  };
+
+  /**
+   * @brief The function evicts the meshlet used least recently
+   *
+   * @return bool False if all requested meshlets are visible now
+   */
+  bool evictOne();
+
+  /**
+   * @brief The function checks if the pages of the meshlet are read
+   *
+   * @param page The page
+   * @return bool True if the meshlet is in memory
+   */
+  bool isLoaded(const Page& page) const;
+
+  /**
+   * @brief The function finds runs of vertices referenced by the indices
+   *
+   * @param first First index
+   * @param last Index after the last one
+   * @param page Page to fill
+   */
+  void setVertices(const unsigned int* first, const unsigned int* last,
+                   Page* page) const;
+
+  ScratchFile* vertices_ = nullptr;
+  ScratchFile* indices_ = nullptr;
+  std::vector<Page> pages_;
+  std::list<size_t> lru_;  // requested and resident, most recent first
+  size_t budget_ = MESH_PAGER_DEFAULT_BUDGET;
+  size_t resident_bytes_ = 0;
+  size_t requested_count_ = 0;
+  uint64_t frame_ = 0;
+};
+
+#endif  // SRC_MODEL_INCLUDE_MESH_PAGER_H
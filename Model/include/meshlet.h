@@ -0,0 +1,118 @@
+#if !defined(SRC_MODEL_INCLUDE_MESHLET_H)
+#define SRC_MODEL_INCLUDE_MESHLET_H
+
+/**
+ * @file meshlet.h
+ * @author SevenStreams
+ * @brief This file handles partitioning of model into meshlets
+ * @version 0.1
+ * @date 2024-03-15
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <cstddef>
+#include <vector>
+
+#include "matrix.h"
+
+#define MESHLET_MAX_VERTICES 64
+#define MESHLET_MAX_TRIANGLES 126
+#define MESHLET_MIN_PARALLEL_TRIANGLES 16384
+
+/**
+ * @brief Cluster of consecutive triangles of the model
+ *
+ * Meshlet references a contiguous range of the model index array, so it can
+ * be drawn with a single glDrawElements call.
+ */
+struct Meshlet {
+  unsigned int index_offset;  // first index in the model index array
+  unsigned int index_count;   // number of indices, 3 per triangle
+  unsigned int vertex_count;  // number of unique vertices in meshlet
+  Vector3 center;             // center of bounding sphere
+  float radius;               // radius of bounding sphere
+  Vector3 cone_axis;          // average direction of triangle normals
+  float cone_cutoff;  // cos of normal cone half angle, -1 if cone is open
+};
+
+/**
+ * @brief Range of the model index array
+ *
+ */
+struct IndexRange {
+  unsigned int offset;  // first index
+  unsigned int count;   // number of indices
+};
+
+class MeshletBuilder {
+ public:
+  /**
+   * @brief The function splits triangles of model into meshlets
+   *
+   * Triangle list is split into chunks which are processed in parallel, so
+   * meshlets never cross chunk boundaries and keep the original order.
+   *
+   * @param vertices Vertices of model
+   * @param vertices_count Number of vertices
+   * @param indices Indices of model, 3 per triangle
+   * @param indices_count Number of indices
+   * @param max_vertices Max number of unique vertices in meshlet
+   * @param max_triangles Max number of triangles in meshlet
+   * @return std::vector<Meshlet> Meshlets covering all triangles
+   */
+  static std::vector<Meshlet> build(
+      const Vector3* vertices, size_t vertices_count,
+      const unsigned int* indices, size_t indices_count,
+      size_t max_vertices = MESHLET_MAX_VERTICES,
+      size_t max_triangles = MESHLET_MAX_TRIANGLES);
+
+  /**
+   * @brief The function checks whether meshlet intersects view frustum
+   *
+   * @param meshlet The meshlet
+   * @param mvp Matrix which transforms model to clip space
+   * @return bool True if bounding sphere is at least partly inside frustum
+   */
+  static bool isVisible(const Meshlet& meshlet, const Matrix4x4& mvp);
+
+  /**
+   * @brief The function collects index ranges of visible meshlets
+   *
+   * Neighbouring visible meshlets are merged into one range.
+   *
+   * @param meshlets Meshlets of model
+   * @param mvp Matrix which transforms model to clip space
+   * @return std::vector<IndexRange> Ranges to draw
+   */
+  static std::vector<IndexRange> visibleRanges(
+      const std::vector<Meshlet>& meshlets, const Matrix4x4& mvp);
+
+ private:
+  /**
+   * @brief The function partitions range of triangles into meshlets
+   *
+   * @param indices Indices of model
+   * @param first_triangle First triangle of the range
+   * @param last_triangle Triangle after the last one of the range
+   * @param max_vertices Max number of unique vertices in meshlet
+   * @param max_triangles Max number of triangles in meshlet
+   * @param out Output list of meshlets
+   */
+  static void partition(const unsigned int* indices, size_t first_triangle,
+                        size_t last_triangle, size_t max_vertices,
+                        size_t max_triangles, std::vector<Meshlet>& out);
+
+  /**
+   * @brief The function calculates bounding sphere and normal cone of meshlet
+   *
+   * @param vertices Vertices of model
+   * @param indices Indices of model
+   * @param meshlet The meshlet
+   */
+  static void computeBounds(const Vector3* vertices,
+                            const unsigned int* indices, Meshlet& meshlet);
+};
+
+#endif  // SRC_MODEL_INCLUDE_MESHLET_H
@@ -12,8 +12,16 @@
  *
  */
 
+#include <atomic>
+
 #include "interface_model.h"
 #include "matrix_generator.h"
+#include "meshlet.h"
+#include "profiler.h"
+#include "progressive_mesh.h"
+#include "scratch_file.h"
+#include "tracer.h"
+#include "quantized_positions.h"
 
 class Model : public IModel {
  public:
@@ -129,46 +137,127 @@ class Model : public IModel {
   void setVertices3d(Vector3* vertices);
 
   /**
-   * @brief The function gets the 4D vertices
+   * @brief The function gets the indices
    *
    * @return description of return value
    *
    */
-  Vector4* getVertices4d();
+  unsigned int* getIndices();
 
   /**
-   * @brief The function sets the 4D vertices
+   * @brief The function sets the indices
    *
-   * @param vertices description of parameter
+   * @param indices description of parameter
    *
    */
-  void setVertices4d(Vector4* vertices);
+  void setIndices(unsigned int* indices);
 
   /**
-   * @brief The function gets the indices
+   * @brief The function sets the mesh the parser publishes batches to
    *
-   * @return description of return value
+   * @param mesh The mesh, NULL to parse without batches
    *
    */
-  unsigned int* getIndices();
+  void setProgressiveMesh(ProgressiveMesh* mesh);
 
   /**
-   * @brief The function sets the indices
+   * @brief The function gets the mesh the parser publishes batches to
    *
-   * @param indices description of parameter
+   * @return The mesh or NULL
    *
    */
-  void setIndices(unsigned int* indices);
+  ProgressiveMesh* getProgressiveMesh();
+
+  /**
+   * @brief The function sets where the parser spills the model
+   *
+   * @param dir Directory of scratch files, empty to keep model in memory
+   *
+   */
+  void setScratchDir(const std::string& dir);
+
+  const std::string& getScratchDir() const;
+
+  /**
+   * @brief The function sets if the parser reads the file around the page
+   * cache
+   *
+   * @param direct True for direct reads, which are dropped if the file
+   * system refuses them
+   *
+   */
+  void setDirectRead(bool direct);
+
+  bool isDirectRead() const;
+
+  /**
+   * @brief The function asks the parser to stop reading the file
+   *
+   * A stopped load ends with ERROR. It may be called from another thread.
+   *
+   * @param cancelled True to stop, false before the next load
+   *
+   */
+  void setLoadCancelled(bool cancelled);
+
+  bool isLoadCancelled() const;
+
+  /**
+   * @brief The function gets the file which keeps vertices out of memory
+   *
+   * @return The file, vertices are mapped from it if it is open
+   *
+   */
+  ScratchFile& getVerticesFile();
+
+  /**
+   * @brief The function gets the file which keeps indices out of memory
+   *
+   * @return The file, indices are mapped from it if it is open
+   *
+   */
+  ScratchFile& getIndicesFile();
+
+  /**
+   * @brief The function checks if vertices and indices are mapped from
+   * scratch files
+   *
+   * @return true for a model which is out of memory
+   *
+   */
+  bool isOutOfCore() const;
+
+  /**
+   * @brief The function gets the meshlets built on model initializing
+   *
+   * @return Meshlets covering all triangles of model
+   *
+   */
+  const std::vector<Meshlet>& getMeshlets() const;
+
+  /**
+   * @brief The function packs vertices into 16-bit normalized positions
+   *
+   * @return Packed positions with error relative to bounding box
+   *
+   */
+  QuantizedPositions quantizePositions() const;
 
  private:
   IParser* parser;
   std::string file_path;
   Vector3* vertices3d;
-  Vector4* vertices4d;
   size_t vertices_count;  // size of vertices3d array
   unsigned int* indices;
   size_t indices_count;  // indices_count * 3 == size of indices array
   int error_code;        // if 0 -- there is no errors yet
+  std::vector<Meshlet> meshlets;
+  ProgressiveMesh* progressive_mesh;  // not owned
+  std::string scratch_dir;
+  bool direct_read;
+  std::atomic<bool> load_cancelled;
+  ScratchFile vertices_file;
+  ScratchFile indices_file;
 
   /**
    * @brief The functions handles normalizing model
@@ -177,17 +266,10 @@ class Model : public IModel {
   void normalizeModel();
 
   /**
-   * @brief The functions handles creating 4d vertices
-   *
-   */
-  void generate4dFrom3d();
-  /**
-   * @brief Make the 4d vector from 3d vector
+   * @brief The functions handles splitting model into meshlets
    *
-   * @param vector 3d vector
-   * @return Vector4 4d vector
    */
-  Vector4 get4dBy3d(Vector3 vector);
+  void buildMeshlets();
 };
 
 
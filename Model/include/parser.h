@@ -12,14 +12,21 @@
  *
  */
 
-#include <fstream>
+#include <algorithm>
 #include <iostream>
 #include <locale>
 #include <sstream>
 #include <string>
 #include <vector>
 
+#include "decompress_buffer.h"
+#include "input_file.h"
 #include "interface_parser.h"
+#include "scratch_file.h"
+#include "profiler.h"
+#include "tracer.h"
+
+#define PARSER_SPILL_VALUES (1 << 20)  // parsed values kept in memory
 
 class Model;
 
@@ -47,8 +54,12 @@ class Parser : public IParser {
 
  private:
   Model *model;
+  InputFile file;  // open while the model is parsed
   Vector vertexes;
   Vector vertex_indexes;
+  size_t published_vertexes = 0;  // vertexes already in the progressive mesh
+  size_t published_indexes = 0;   // vertex_indexes already published
+  size_t spilled_vertexes = 0;    // vertexes written to the scratch file
 
   /**
    * @brief Clears the vectors containing vertex data and vertex indexes.
@@ -56,20 +67,28 @@ class Parser : public IParser {
   void clearVectors();
 
   /**
-   * @brief This function checks whether file exists or not
+   * @brief This function opens file and checks whether it is empty or not
    *
    * @param filename File's name
    * @return int An error
    */
-  int fileExists(const std::string &filename);
+  int openFile(const std::string &filename);
 
   /**
-   * @brief This function checks whether file if empty or not
+   * @brief This function reserves vectors for values expected in file
    *
-   * @param filename File's name
+   * @param file_size Size of .obj file
+   */
+  void reserveVectors(size_t file_size);
+
+  /**
+   * @brief This function detects compressed file and starts decompressing it
+   *
+   * @param decompressed Buffer of decompressed data
+   * @param input Stream of the file, reads the buffer if file is compressed
    * @return int An error
    */
-  int fileEmpty(const std::string &filename);
+  int openInput(DecompressBuffer *decompressed, std::istream *input);
 
   /**
    * @brief The function handles parsing model
@@ -77,6 +96,37 @@ class Parser : public IParser {
    */
   void process();
 
+  /**
+   * @brief This function publishes vertexes and faces parsed since the last
+   * batch to the progressive mesh
+   *
+   * @param mesh The mesh of the model
+   */
+  void publishBatch(ProgressiveMesh *mesh);
+
+  /**
+   * @brief This function writes parsed vertexes and indexes to the scratch
+   * files of the model and clears them
+   *
+   * @return int An error
+   */
+  int spillVectors();
+
+  /**
+   * @brief This function handles mapping spilled vertexes and indexes into
+   * model
+   *
+   */
+  void mappedToModel();
+
+  /**
+   * @brief This function converts index of .obj file into index of model
+   *
+   * @param index Index from file
+   * @return unsigned int Index in vertices of model
+   */
+  unsigned int resolveIndex(int index);
+
   /**
    * @brief This function handles adding list of vertexes to model
    *
@@ -0,0 +1,195 @@
+#if !defined(SRC_MODEL_INCLUDE_PROFILER_H)
+#define SRC_MODEL_INCLUDE_PROFILER_H
+
+/**
+ * @file profiler.h
+ * @author SevenStreams
+ * @brief This file handles timing of load and render stages
+ * @version 0.1
+ * @date 2024-03-15
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+#define PROFILER_HISTORY 256
+
+/**
+ * @brief Measured stages of load and render pipeline
+ *
+ */
+typedef enum e_profiler_stages {
+  v_profiler_load,
+  v_profiler_parse,
+  v_profiler_normalize,
+  v_profiler_transform,
+  v_profiler_upload,
+  v_profiler_stall,
+  v_profiler_draw,
+  v_profiler_gpu,
+  v_profiler_frame,
+  v_profiler_stages_count
+} v_profiler_stages;
+
+/**
+ * @brief Counters which are not durations
+ *
+ */
+typedef enum e_profiler_counters {
+  v_profiler_upload_bandwidth,  // MB/s of the last vertex upload
+  v_profiler_task_queue_depth,  // most tasks waiting in the scheduler at once
+  v_profiler_task_steals,       // tasks stolen by scheduler threads
+  v_profiler_counters_count
+} v_profiler_counters;
+
+/**
+ * @brief Statistics of one stage over the last PROFILER_HISTORY samples
+ *
+ */
+struct ProfilerStats {
+  double last;     // last sample, ms
+  double average;  // mean of samples, ms
+  double p50;      // median, ms
+  double p95;      // 95th percentile, ms
+  double p99;      // 99th percentile, ms
+  size_t samples;  // number of samples in history
+};
+
+/**
+ * @brief Collector of stage timings shared by Model, Controller and View
+ */
+class Profiler {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * @brief The function returns profiler of the application
+   *
+   * @return Profiler& The profiler
+   */
+  static Profiler& instance();
+
+  /**
+   * @brief The function adds a sample to the stage history
+   *
+   * @param stage The stage
+   * @param ms Duration in milliseconds
+   */
+  void addSample(v_profiler_stages stage, double ms);
+
+  /**
+   * @brief The function marks the end of a frame
+   *
+   * Time between two marks is added as v_profiler_frame sample.
+   */
+  void markFrame();
+
+  /**
+   * @brief The function sets current value of the counter
+   *
+   * @param counter The counter
+   * @param value The value
+   */
+  void setCounter(v_profiler_counters counter, double value);
+
+  /**
+   * @brief The function returns current value of the counter
+   *
+   * @param counter The counter
+   * @return double The value
+   */
+  double getCounter(v_profiler_counters counter) const;
+
+  /**
+   * @brief The function returns statistics of the stage
+   *
+   * @param stage The stage
+   * @return ProfilerStats Statistics
+   */
+  ProfilerStats getStats(v_profiler_stages stage) const;
+
+  /**
+   * @brief The function returns frames per second by average frame time
+   *
+   * @return double Frames per second, 0 if there are no frames yet
+   */
+  double getFps() const;
+
+  /**
+   * @brief The function clears all samples
+   *
+   */
+  void reset();
+
+  /**
+   * @brief The function returns human-readable name of the stage
+   *
+   * @param stage The stage
+   * @return const char* Name
+   */
+  static const char* stageName(v_profiler_stages stage);
+
+  /**
+   * @brief The function returns human-readable name of the counter
+   *
+   * @param counter The counter
+   * @return const char* Name
+   */
+  static const char* counterName(v_profiler_counters counter);
+
+  /**
+   * @brief The function returns statistics of the samples
+   *
+   * @param samples Samples in ms, last one is the most recent
+   * @return ProfilerStats Statistics
+   */
+  static ProfilerStats computeStats(std::vector<double> samples);
+
+ private:
+  Profiler();
+
+  mutable std::mutex mutex_;
+  std::vector<double> history_[v_profiler_stages_count];
+  size_t next_[v_profiler_stages_count];
+  double counters_[v_profiler_counters_count];
+  Clock::time_point last_frame_;
+  bool has_frame_;
+};
+
+/**
+ * @brief Timer which adds its lifetime to the stage on destruction
+ */
+class ScopedTimer {
+ public:
+  /**
+   * @brief The function starts timer for the stage
+   *
+   * @param stage The stage
+   */
+  explicit ScopedTimer(v_profiler_stages stage)
+      : stage_(stage), start_(Profiler::Clock::now()) {}
+
+  /**
+   * @brief The function stops timer and adds the sample
+   *
+   */
+  ~ScopedTimer() {
+    std::chrono::duration<double, std::milli> elapsed =
+        Profiler::Clock::now() - start_;
+    Profiler::instance().addSample(stage_, elapsed.count());
+  }
+
+  ScopedTimer(const ScopedTimer&) = delete;
+  ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+ private:
+  v_profiler_stages stage_;
+  Profiler::Clock::time_point start_;
+};
+
+#endif  // SRC_MODEL_INCLUDE_PROFILER_H
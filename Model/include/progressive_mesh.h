@@ -0,0 +1,141 @@
+#if !defined(SRC_MODEL_INCLUDE_PROGRESSIVE_MESH_H)
+#define SRC_MODEL_INCLUDE_PROGRESSIVE_MESH_H
+
+/**
+ * @file progressive_mesh.h
+ * @author SevenStreams
+ * @brief This file handles geometry published by the parser while it reads
+ * @version 0.1
+ * @date 2024-03-15
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "matrix_generator.h"
+
+#define PROGRESSIVE_MESH_BATCH_LINES 65536
+#define PROGRESSIVE_MESH_BYTES_PER_VERTEX 64  // of a typical .obj file
+#define PROGRESSIVE_MESH_INDICES_PER_VERTEX 6
+
+/**
+ * @brief Part of the loaded geometry after the one already taken
+ *
+ */
+struct ProgressiveBatch {
+  std::vector<Vector3> vertices;      // positions as they are in the file
+  std::vector<unsigned int> indices;  // triangles of loaded vertices
+  size_t first_vertex = 0;            // index of vertices[0] in the mesh
+  size_t first_index = 0;             // index of indices[0] in the mesh
+  Vector3 min;                        // bounding box of loaded vertices
+  Vector3 max;
+  bool finished = false;  // the parser has read the whole file
+  uint64_t generation = 0;  // changed when the mesh starts over
+};
+
+/**
+ * @brief Vertices and triangles of a model which is still being parsed
+ *
+ * The parser appends batches from the loading thread, the viewer takes the
+ * new part of the geometry and appends it to its buffers. Vertices are kept
+ * as they are in the file and normalized by normalizationMatrix() of the
+ * bounding box loaded so far, so the box grows without changes of the
+ * vertices taken before. Triangles which use vertices not loaded yet are
+ * only in the final model.
+ */
+class ProgressiveMesh {
+ public:
+  /**
+   * @brief The function clears the mesh and reserves memory for a file
+   *
+   * @param file_size Size of the file in bytes
+   */
+  void reset(size_t file_size);
+
+  /**
+   * @brief The function frees the mesh
+   *
+   */
+  void clear();
+
+  /**
+   * @brief The function appends a batch and calls the batch handler
+   *
+   * @param vertices Positions of new vertices
+   * @param indices Triangles of all vertices appended so far
+   */
+  void append(const std::vector<Vector3>& vertices,
+              const std::vector<unsigned int>& indices);
+
+  /**
+   * @brief The function marks the file as read and calls the batch handler
+   *
+   */
+  void finish();
+
+  /**
+   * @brief The function sets the function called after every batch
+   *
+   * The handler is called on the loading thread.
+   *
+   * @param handler The handler, may be empty
+   */
+  void setBatchHandler(std::function<void()> handler);
+
+  /**
+   * @brief The function copies geometry loaded after the given counts
+   *
+   * @param first_vertex Vertices which are taken already
+   * @param first_index Indices which are taken already
+   * @return ProgressiveBatch The new geometry with the current bounding box
+   */
+  ProgressiveBatch getBatch(size_t first_vertex, size_t first_index) const;
+
+  size_t getVerticesCount() const;
+
+  size_t getIndicesCount() const;
+
+  /**
+   * @brief The function returns counts expected from the size of the file
+   *
+   * @param vertices_count Expected number of vertices
+   * @param indices_count Expected number of indices
+   */
+  void getExpectedCounts(size_t* vertices_count, size_t* indices_count) const;
+
+  /**
+   * @brief The function returns matrix which normalizes the loaded part
+   *
+   * @return Matrix4x4 Matrix of the current bounding box
+   */
+  Matrix4x4 getNormalizationMatrix() const;
+
+  /**
+   * @brief The function generates matrix doing what Model::initModel does
+   * with vertices inside the bounding box
+   *
+   * @param min Minimal corner of the bounding box
+   * @param max Maximal corner of the bounding box
+   * @return Matrix4x4 Result matrix 4x4
+   */
+  static Matrix4x4 normalizationMatrix(const Vector3& min, const Vector3& max);
+
+ private:
+  mutable std::mutex mutex_;
+  uint64_t generation_ = 0;
+  std::vector<Vector3> vertices_;
+  std::vector<unsigned int> indices_;
+  Vector3 min_;
+  Vector3 max_;
+  size_t expected_vertices_ = 0;
+  bool finished_ = false;
+  std::function<void()> handler_;
+};
+
+#endif  // SRC_MODEL_INCLUDE_PROGRESSIVE_MESH_H
@@ -0,0 +1,68 @@
+#if !defined(SRC_MODEL_INCLUDE_QUANTIZED_POSITIONS_H)
+#define SRC_MODEL_INCLUDE_QUANTIZED_POSITIONS_H
+
+/**
+ * @file quantized_positions.h
+ * @author SevenStreams
+ * @brief This file handles packing of vertex positions into 16-bit integers
+ * @version 0.1
+ * @date 2024-03-15
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "matrix_generator.h"
+
+#define QUANTIZATION_MAX_VALUE 65535.0f
+
+/**
+ * @brief Vertex positions packed as normalized 16-bit x, y, z
+ *
+ * Each component is stored relative to the bounding box of model:
+ * value = offset + q / QUANTIZATION_MAX_VALUE * extent.
+ */
+struct QuantizedPositions {
+  std::vector<uint16_t> data;  // x, y, z of every vertex
+  Vector3 offset;              // minimum corner of bounding box
+  Vector3 extent;              // size of bounding box
+  float max_error;  // max position error relative to bounding box size
+};
+
+class PositionQuantizer {
+ public:
+  /**
+   * @brief The function packs vertices into 16-bit normalized integers
+   *
+   * @param vertices Vertices of model
+   * @param count Number of vertices
+   * @return QuantizedPositions Packed positions with measured error
+   */
+  static QuantizedPositions quantize(const Vector3* vertices, size_t count);
+
+  /**
+   * @brief The function unpacks a single vertex
+   *
+   * @param positions Packed positions
+   * @param index Index of vertex
+   * @return Vector3 The vertex
+   */
+  static Vector3 dequantize(const QuantizedPositions& positions, size_t index);
+
+  /**
+   * @brief The function generates matrix which unpacks normalized positions
+   *
+   * The matrix maps [0, 1] values, as they come from a normalized
+   * GL_UNSIGNED_SHORT attribute, back into model space.
+   *
+   * @param positions Packed positions
+   * @return Matrix4x4 Result matrix 4x4
+   */
+  static Matrix4x4 dequantizationMatrix(const QuantizedPositions& positions);
+};
+
+#endif  // SRC_MODEL_INCLUDE_QUANTIZED_POSITIONS_H
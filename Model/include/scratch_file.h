@@ -0,0 +1,133 @@
+#if !defined(SRC_MODEL_INCLUDE_SCRATCH_FILE_H)
+#define SRC_MODEL_INCLUDE_SCRATCH_FILE_H
+
+/**
+ * @file scratch_file.h
+ * @author SevenStreams
+ * @brief This file handles temporary files which keep models out of memory
+ * @version 0.1
+ * @date 2024-03-15
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <cstddef>
+#include <string>
+
+#define SCRATCH_FILE_TEMPLATE "/s21_3DViewer_XXXXXX"
+
+/**
+ * @brief Temporary file which is written once and then memory-mapped
+ *
+ * The file is removed from the directory as soon as it is created, so it
+ * disappears when it is closed or the process exits. Pages of the mapping
+ * are read from the file on access, so data larger than memory may be
+ * mapped and the pages which are not needed may be given back.
+ */
+class ScratchFile {
+ public:
+  ScratchFile() = default;
+  ScratchFile(const ScratchFile&) = delete;
+  ScratchFile& operator=(const ScratchFile&) = delete;
+
+  /**
+   * @brief The function closes the file
+   *
+   */
+  ~ScratchFile();
+
+  /**
+   * @brief The function creates an empty file
+   *
+   * @param dir Directory of the file
+   * @return true if the file is created
+   */
+  bool open(const std::string& dir);
+
+  /**
+   * @brief The function unmaps and removes the file
+   *
+   */
+  void close();
+
+  bool isOpen() const;
+
+  /**
+   * @brief The function writes data at the end of the file
+   *
+   * @param data The data
+   * @param bytes Size of the data
+   * @return true if all bytes are written
+   */
+  bool append(const void* data, size_t bytes);
+
+  /**
+   * @brief The function sets size of the file before it is mapped
+   *
+   * A grown file takes no disk space until the added part is written.
+   *
+   * @param bytes New size
+   * @return true if the size is changed
+   */
+  bool resize(size_t bytes);
+
+  /**
+   * @brief The function maps the written file for reading and writing
+   *
+   * @return true if the file is mapped
+   */
+  bool map();
+
+  /**
+   * @brief The function returns the mapped data
+   *
+   * @return void* The data, NULL before map() or for an empty file
+   */
+  void* data() const;
+
+  size_t size() const;
+
+  /**
+   * @brief The function starts reading the range into memory
+   *
+   * @param offset Offset of the range in bytes
+   * @param bytes Size of the range
+   */
+  void willNeed(size_t offset, size_t bytes);
+
+  /**
+   * @brief The function gives memory of the range back to the system
+   *
+   * Changed pages are kept by the file, the range is read again on access.
+   *
+   * @param offset Offset of the range in bytes
+   * @param bytes Size of the range
+   */
+  void dontNeed(size_t offset, size_t bytes);
+
+  /**
+   * @brief The function checks if pages of the range are in memory
+   *
+   * @param offset Offset of the range in bytes
+   * @param bytes Size of the range
+   * @return true if access to the range does not read the file
+   */
+  bool isResident(size_t offset, size_t bytes) const;
+
+ private:
+  /**
+   * @brief The function widens the range to whole pages of the mapping
+   *
+   * @param offset Offset of the range, set to offset of the first page
+   * @param bytes Size of the range, set to size of the pages
+   * @return true if the range is not empty
+   */
+  bool pageRange(size_t* offset, size_t* bytes) const;
+
+  int fd_ = -1;
+  char* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+#endif  // SRC_MODEL_INCLUDE_SCRATCH_FILE_H
@@ -15,6 +15,10 @@
 #include "interface_settings.h"
 #include "matrix_generator.h"
 
+#define SETTINGS_FORMAT_NAME "s21_3DViewer_settings"
+#define SETTINGS_FORMAT_VERSION 1
+#define SETTINGS_MAX_SIZE 100.0f  // of lines and vertices, in pixels
+
 class Settings : public ISettings {
  public:
   /**
@@ -32,6 +36,27 @@ class Settings : public ISettings {
    */
   void saveSettings(const std::string &settings_file_path) override;
 
+  /**
+   * @brief The function writes settings as text
+   *
+   * The first line holds SETTINGS_FORMAT_NAME and SETTINGS_FORMAT_VERSION,
+   * every next line holds a key and its values.
+   *
+   * @return std::string The text
+   */
+  std::string serialize();
+
+  /**
+   * @brief The function reads settings written by serialize()
+   *
+   * Unknown keys are skipped and missing keys keep their values. If the
+   * header or any value is invalid the settings are not changed.
+   *
+   * @param text The text
+   * @return true if the settings were read
+   */
+  bool deserialize(const std::string &text);
+
   /**
    * @brief The function initializing settings
    *
@@ -0,0 +1,113 @@
+#if !defined(SRC_MODEL_INCLUDE_SETTINGS_STORE_H)
+#define SRC_MODEL_INCLUDE_SETTINGS_STORE_H
+
+/**
+ * @file settings_store.h
+ * @author SevenStreams
+ * @brief This file handles saving settings in background
+ * @version 0.1
+ * @date 2024-03-15
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "settings.h"
+
+#define SETTINGS_STORE_DELAY_MS 250
+#define SETTINGS_STORE_MAX_DELAY_MS 1000
+
+/**
+ * @brief Writer of settings to a file on its own thread
+ *
+ * Saved settings are written after SETTINGS_STORE_DELAY_MS without new
+ * saves, so a burst of changes, like dragging a color, is written once.
+ * While changes keep coming the file is still written every
+ * SETTINGS_STORE_MAX_DELAY_MS. Only the latest settings are written.
+ */
+class SettingsStore {
+ public:
+  /**
+   * @brief The function handles initializing store
+   *
+   * @param settings_file_path The settings file path
+   * @param delay_ms Time without saves before writing
+   * @param max_delay_ms Longest time from a save to writing
+   * @return SettingsStore
+   */
+  SettingsStore(const std::string &settings_file_path,
+                int delay_ms = SETTINGS_STORE_DELAY_MS,
+                int max_delay_ms = SETTINGS_STORE_MAX_DELAY_MS);
+
+  /**
+   * @brief The function writes pending settings and stops the thread
+   *
+   */
+  ~SettingsStore();
+
+  SettingsStore(const SettingsStore &) = delete;
+  SettingsStore &operator=(const SettingsStore &) = delete;
+
+  /**
+   * @brief The function schedules writing of the settings
+   *
+   * @param settings The settings, copied
+   */
+  void save(const Settings &settings);
+
+  /**
+   * @brief The function waits until saved settings are written
+   *
+   */
+  void flush();
+
+  /**
+   * @brief The function returns result of the last write
+   *
+   * @return v_settings_error_codes The error code
+   */
+  v_settings_error_codes getError();
+
+  /**
+   * @brief The function returns number of writes to the file
+   *
+   * @return size_t Number of writes
+   */
+  size_t getWritesCount();
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * @brief The function writes settings until the store is destroyed
+   *
+   */
+  void run();
+
+  std::string path_;
+  Clock::duration delay_;
+  Clock::duration max_delay_;
+
+  std::mutex mutex_;
+  std::condition_variable changed_;
+  std::condition_variable written_;
+  Settings pending_;
+  bool has_pending_ = false;
+  bool writing_ = false;
+  bool stop_ = false;
+  int flushes_waiting_ = 0;
+  Clock::time_point first_save_;  // of pending settings
+  Clock::time_point deadline_;
+  v_settings_error_codes error_ = v_settings_OK;
+  size_t writes_count_ = 0;
+
+  std::thread thread_;  // started last, after the members it uses
+};
+
+#endif  // SRC_MODEL_INCLUDE_SETTINGS_STORE_H
@@ -0,0 +1,228 @@
+#if !defined(SRC_MODEL_INCLUDE_SOFTWARE_RENDERER_H)
+#define SRC_MODEL_INCLUDE_SOFTWARE_RENDERER_H
+
+/**
+ * @file software_renderer.h
+ * @author SevenStreams
+ * @brief This file handles drawing wireframes without GPU
+ * @version 0.1
+ * @date 2024-03-15
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "matrix.h"
+
+#define SOFTWARE_RENDERER_TILE_SIZE 64
+#define SOFTWARE_RENDERER_MIN_PARALLEL_ITEMS 4096
+#define SOFTWARE_RENDERER_STIPPLE_PATTERN 0x0101  // as in ShaderRenderer
+
+/**
+ * @brief Primitives of the index array
+ *
+ */
+typedef enum e_software_primitives {
+  v_software_triangles,  // three indices per triangle, edges are drawn
+  v_software_lines       // two indices per line
+} v_software_primitives;
+
+/**
+ * @brief Look of the wireframe, the same as the one of ShaderRenderer
+ *
+ */
+struct SoftwareRenderStyle {
+  Vector3 background_color;
+  Vector3 line_color;
+  Vector3 vertex_color;
+  float line_width = 1.0f;         // pixels, at least 1
+  float point_size = 0.0f;         // pixels, 0 hides vertices
+  unsigned int stipple_pattern = 0;  // one bit per pixel, 0 is solid
+  bool round_points = false;
+};
+
+/**
+ * @brief CPU renderer of anti-aliased wireframes into an RGB image
+ *
+ * Vertices are transformed by the MVP matrix and edges are clipped against
+ * the view frustum in homogeneous coordinates. Clipped lines and vertex
+ * markers are sorted into bins of SOFTWARE_RENDERER_TILE_SIZE square tiles,
+ * then tiles are drawn in parallel, four pixels of a row at once with SSE.
+ * Each tile keeps the order of primitives, so the image does not depend on
+ * the number of threads.
+ *
+ * Lines are rectangles of line_width pixels without caps and vertices are
+ * squares or circles of point_size pixels, like in ShaderRenderer, with
+ * coverage of the pixel center used as alpha.
+ */
+class SoftwareRenderer {
+ public:
+  /**
+   * @brief The function handles initializing renderer
+   *
+   * @param width Width of the image
+   * @param height Height of the image
+   * @param threads_count Parts the work is split into, 0 means threads of
+   * TaskScheduler
+   * @return SoftwareRenderer
+   */
+  SoftwareRenderer(int width, int height, int threads_count = 0);
+
+  /**
+   * @brief The function sets look of the wireframe
+   *
+   * @param style The style
+   */
+  void setStyle(const SoftwareRenderStyle& style);
+
+  /**
+   * @brief The function draws the wireframe over the background
+   *
+   * @param vertices Vertices of the model
+   * @param vertices_count Number of vertices
+   * @param indices Index array
+   * @param indices_count Number of indices
+   * @param primitive Kind of primitives of the index array
+   * @param mvp Matrix from model to clip space
+   */
+  void render(const Vector3* vertices, size_t vertices_count,
+              const unsigned int* indices, size_t indices_count,
+              v_software_primitives primitive, const Matrix4x4& mvp);
+
+  int getWidth() const;
+
+  int getHeight() const;
+
+  /**
+   * @brief The function returns number of lines drawn by the last render
+   *
+   * @return size_t Lines left after clipping
+   */
+  size_t getLinesCount() const;
+
+  /**
+   * @brief The function returns pixels of the image
+   *
+   * @return const std::vector<unsigned char>& Rows of RGB pixels, top first
+   */
+  const std::vector<unsigned char>& getPixels() const;
+
+  /**
+   * @brief The function takes pixels of the image, leaving it empty
+   *
+   * @return std::vector<unsigned char> Rows of RGB pixels, top first
+   */
+  std::vector<unsigned char> takePixels();
+
+ private:
+  /**
+   * @brief Clipped line in pixel coordinates
+   *
+   */
+  struct Segment {
+    float x0, y0;    // start
+    float x1, y1;    // end
+    float distance;  // pixels from the unclipped start, for stipple
+  };
+
+  /**
+   * @brief Vertex marker in pixel coordinates
+   *
+   */
+  struct Marker {
+    float x, y;
+  };
+
+  /**
+   * @brief Color planes of one tile, padded for the last group of pixels
+   *
+   */
+  struct TileBuffer {
+    alignas(16) float r[SOFTWARE_RENDERER_TILE_SIZE *
+                            SOFTWARE_RENDERER_TILE_SIZE +
+                        4];
+    alignas(16) float g[SOFTWARE_RENDERER_TILE_SIZE *
+                            SOFTWARE_RENDERER_TILE_SIZE +
+                        4];
+    alignas(16) float b[SOFTWARE_RENDERER_TILE_SIZE *
+                            SOFTWARE_RENDERER_TILE_SIZE +
+                        4];
+  };
+
+  /**
+   * @brief The function runs job(part, first, last) over ranges of items
+   * on TaskScheduler
+   *
+   */
+  template <typename Job>
+  void parallelFor(size_t count, Job job);
+
+  /**
+   * @brief The function clips the line and appends it to segments
+   *
+   */
+  void clipLine(const Vector4& a, const Vector4& b,
+                std::vector<Segment>& segments) const;
+
+  /**
+   * @brief The function appends the vertex to markers if it is visible
+   *
+   */
+  void projectMarker(const Vector4& v, std::vector<Marker>& markers) const;
+
+  /**
+   * @brief The function adds index of the item to bins of covered tiles
+   *
+   */
+  void binRect(float left, float top, float right, float bottom,
+               uint32_t index, std::vector<std::vector<uint32_t>>& bins) const;
+
+  /**
+   * @brief The function adds index of the segment to bins of covered tiles
+   *
+   */
+  void binSegment(const Segment& segment, uint32_t index,
+                  std::vector<std::vector<uint32_t>>& bins) const;
+
+  /**
+   * @brief The function draws all items of the tile into the image
+   *
+   */
+  void drawTile(int tile, TileBuffer& buffer);
+
+  /**
+   * @brief The function blends the segment into the tile
+   *
+   */
+  void drawSegment(const Segment& segment, int tile_x, int tile_y,
+                   int tile_width, int tile_height, TileBuffer& buffer) const;
+
+  /**
+   * @brief The function blends the marker into the tile
+   *
+   */
+  void drawMarker(const Marker& marker, int tile_x, int tile_y,
+                  int tile_width, int tile_height, TileBuffer& buffer) const;
+
+  int width_;
+  int height_;
+  int threads_count_;
+  int tiles_x_;
+  int tiles_y_;
+  SoftwareRenderStyle style_;
+  float half_width_;  // of lines, with half pixel of anti-aliasing
+
+  std::vector<Vector4> clip_;
+  std::vector<std::vector<Segment>> segments_;  // per thread
+  std::vector<std::vector<Marker>> markers_;    // per thread
+  // [thread][tile], items of thread t precede items of thread t + 1
+  std::vector<std::vector<std::vector<uint32_t>>> segment_bins_;
+  std::vector<std::vector<std::vector<uint32_t>>> marker_bins_;
+  std::vector<unsigned char> pixels_;
+};
+
+#endif  // SRC_MODEL_INCLUDE_SOFTWARE_RENDERER_H
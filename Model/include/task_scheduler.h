@@ -0,0 +1,305 @@
+#if !defined(SRC_MODEL_INCLUDE_TASK_SCHEDULER_H)
+#define SRC_MODEL_INCLUDE_TASK_SCHEDULER_H
+
+/**
+ * @file task_scheduler.h
+ * @author SevenStreams
+ * @brief This file handles the work-stealing pool shared by parallel stages
+ * @version 0.1
+ * @date 2024-03-15
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define TASK_SCHEDULER_THREADS_ENV "VIEWER_THREADS"
+#define TASK_SCHEDULER_CHUNKS_PER_THREAD 4
+
+class TaskGroup;
+
+/**
+ * @brief Counters of the scheduler since the last reset
+ *
+ */
+struct TaskSchedulerCounters {
+  uint64_t tasks = 0;          // tasks executed
+  uint64_t steals = 0;         // tasks taken from a deque of another thread
+  size_t queue_depth = 0;      // tasks waiting now
+  size_t max_queue_depth = 0;  // most tasks waiting at once
+};
+
+/**
+ * @brief Pool of worker threads with a deque of tasks each
+ *
+ * A worker pushes and pops tasks at the back of its own deque and, when it
+ * is empty, steals from the front of the others, so the oldest and usually
+ * largest tasks move between threads. Threads which are not workers submit
+ * into one more shared deque. A thread waiting for a TaskGroup runs tasks
+ * meanwhile, so parallel loops may be nested.
+ *
+ * The pool has getThreadsCount() - 1 workers, the thread which waits is the
+ * last one. The count is taken from TASK_SCHEDULER_THREADS_ENV if it is
+ * set, otherwise from availableConcurrency().
+ */
+class TaskScheduler {
+ public:
+  using Task = std::function<void()>;
+
+  /**
+   * @brief The function returns scheduler of the application
+   *
+   * @return TaskScheduler& The scheduler
+   */
+  static TaskScheduler& instance();
+
+  /**
+   * @brief The function stops workers
+   *
+   */
+  ~TaskScheduler();
+
+  /**
+   * @brief The function restarts workers with the new count
+   *
+   * It waits until the running groups of tasks are done, groups started
+   * meanwhile wait for the new workers. It must not be called from a task.
+   *
+   * @param threads_count Threads working on tasks, 0 means
+   * availableConcurrency()
+   */
+  void setThreadsCount(size_t threads_count);
+
+  size_t getThreadsCount() const;
+
+  /**
+   * @brief The function pins workers to the CPUs
+   *
+   * Workers started later are pinned too. Only Linux supports it.
+   *
+   * @param cpus Indices of CPUs, empty to allow all CPUs of the process
+   * @return true if workers are pinned
+   */
+  bool setAffinity(const std::vector<int>& cpus);
+
+  /**
+   * @brief The function returns the number of CPUs the process may use
+   *
+   * It is the smallest of hardware threads, CPUs of the affinity mask and
+   * the CPU quota of the cgroup rounded up.
+   *
+   * @return size_t Number of CPUs, at least 1
+   */
+  static size_t availableConcurrency();
+
+  /**
+   * @brief The function reads the CPU quota of a cgroup
+   *
+   * cpu.max of cgroup v2 and cpu.cfs_quota_us with cpu.cfs_period_us of
+   * cgroup v1 are read.
+   *
+   * @param cgroup_dir Directory of the cgroup
+   * @return double Quota in CPUs, 0 if there is no quota
+   */
+  static double readCgroupQuota(const std::string& cgroup_dir);
+
+  /**
+   * @brief The function returns counters for instrumentation
+   *
+   * @return TaskSchedulerCounters The counters
+   */
+  TaskSchedulerCounters getCounters() const;
+
+  /**
+   * @brief The function resets task, steal and maximum depth counters
+   *
+   */
+  void resetCounters();
+
+  /**
+   * @brief The function calls job(first, last) for parts of [begin, end)
+   *
+   * The range is split into chunks of at least grain items, a few chunks
+   * per thread so that stolen chunks balance uneven ones. The caller runs
+   * the first chunk and returns when all chunks are done.
+   *
+   * @param begin First index
+   * @param end Index after the last one
+   * @param grain Minimal size of a chunk
+   * @param job Function of the first and after the last index of a chunk
+   */
+  template <typename Job>
+  void parallelFor(size_t begin, size_t end, size_t grain, Job job);
+
+  /**
+   * @brief The function maps chunks of [begin, end) and reduces the results
+   *
+   * Chunks are of grain items and their results are reduced in order, so
+   * the result does not depend on the number of threads.
+   *
+   * @param begin First index
+   * @param end Index after the last one
+   * @param grain Size of a chunk
+   * @param identity Result of an empty range
+   * @param map Function of the first and after the last index of a chunk
+   * @param reduce Function of two results
+   * @return T The result
+   */
+  template <typename T, typename Map, typename Reduce>
+  T parallelReduce(size_t begin, size_t end, size_t grain, T identity,
+                   Map map, Reduce reduce);
+
+ private:
+  friend class TaskGroup;
+
+  /**
+   * @brief Task with the group which waits for it
+   *
+   */
+  struct Item {
+    Task task;
+    TaskGroup* group;
+  };
+
+  /**
+   * @brief Deque of a worker, or of other threads for the last one
+   *
+   */
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Item> items;
+  };
+
+  TaskScheduler();
+
+  void start(size_t threads_count);
+
+  void stop();
+
+  void submit(Item item);
+
+  /**
+   * @brief The function runs one task of the own deque or a stolen one
+   *
+   * @return true if a task was run
+   */
+  bool runOne();
+
+  void workerLoop(size_t index);
+
+  bool applyAffinity(std::thread& thread);
+
+  std::vector<std::unique_ptr<Queue>> queues_;  // workers, then others
+  std::vector<std::thread> workers_;
+  std::mutex sleep_mutex_;
+  std::condition_variable wake_;
+  bool stop_ = false;
+  std::atomic<size_t> threads_count_{1};
+  std::mutex groups_mutex_;
+  std::condition_variable groups_idle_;
+  size_t groups_ = 0;      // groups which may submit or run tasks
+  bool resizing_ = false;  // workers are being restarted
+  std::vector<int> cpus_;
+  std::atomic<size_t> pending_{0};
+  std::atomic<size_t> max_pending_{0};
+  std::atomic<uint64_t> tasks_{0};
+  std::atomic<uint64_t> steals_{0};
+};
+
+/**
+ * @brief Tasks which are waited for together
+ */
+class TaskGroup {
+ public:
+  /**
+   * @brief The function handles initializing group
+   *
+   * @param scheduler Scheduler which runs the tasks
+   * @return TaskGroup
+   */
+  explicit TaskGroup(TaskScheduler& scheduler = TaskScheduler::instance());
+
+  /**
+   * @brief The function waits for the tasks
+   *
+   */
+  ~TaskGroup();
+
+  /**
+   * @brief The function submits the task, without workers it is run at once
+   *
+   * @param task The task
+   */
+  void run(TaskScheduler::Task task);
+
+  /**
+   * @brief The function runs tasks until all tasks of the group are done
+   *
+   */
+  void wait();
+
+ private:
+  friend class TaskScheduler;
+
+  void finish();
+
+  TaskScheduler& scheduler_;
+  std::atomic<size_t> pending_{0};
+  std::mutex mutex_;
+  std::condition_variable done_;
+};
+
+template <typename Job>
+void TaskScheduler::parallelFor(size_t begin, size_t end, size_t grain,
+                                Job job) {
+  if (begin >= end) return;
+  size_t count = end - begin;
+  grain = std::max<size_t>(grain, 1);
+  size_t chunks = (count + grain - 1) / grain;
+  size_t threads_count = threads_count_;
+  chunks = std::min(chunks, threads_count * TASK_SCHEDULER_CHUNKS_PER_THREAD);
+  if (chunks <= 1 || threads_count == 1) {
+    job(begin, end);
+    return;
+  }
+  size_t chunk = (count + chunks - 1) / chunks;
+  TaskGroup group(*this);
+  for (size_t first = begin + chunk; first < end; first += chunk) {
+    size_t last = std::min(first + chunk, end);
+    group.run([&job, first, last]() { job(first, last); });
+  }
+  job(begin, begin + chunk);
+  group.wait();
+}
+
+template <typename T, typename Map, typename Reduce>
+T TaskScheduler::parallelReduce(size_t begin, size_t end, size_t grain,
+                                T identity, Map map, Reduce reduce) {
+  if (begin >= end) return identity;
+  grain = std::max<size_t>(grain, 1);
+  size_t chunks = (end - begin + grain - 1) / grain;
+  std::vector<T> results(chunks, identity);
+  parallelFor(0, chunks, 1, [&](size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) {
+      size_t first_item = begin + i * grain;
+      results[i] = map(first_item, std::min(first_item + grain, end));
+    }
+  });
+  T result = identity;
+  for (T& value : results) result = reduce(result, value);
+  return result;
+}
+
+#endif  // SRC_MODEL_INCLUDE_TASK_SCHEDULER_H
@@ -0,0 +1,174 @@
+#if !defined(SRC_MODEL_INCLUDE_TRACER_H)
+#define SRC_MODEL_INCLUDE_TRACER_H
+
+/**
+ * @file tracer.h
+ * @author SevenStreams
+ * @brief This file handles recording of trace spans in Chrome trace format
+ * @version 0.1
+ * @date 2024-03-15
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define TRACER_BUFFER_CAPACITY 65536
+
+#if defined(VIEWER_DISABLE_TRACING)
+#define TRACE_SCOPE(name)
+#else
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+/**
+ * @brief Records a span from this line to the end of the enclosing scope.
+ * The name must be a string literal.
+ */
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#endif
+
+/**
+ * @brief Complete trace event
+ *
+ */
+struct TraceEvent {
+  const char *name;  // string literal
+  int64_t start_us;  // start time since tracer creation
+  int64_t duration_us;
+};
+
+/**
+ * @brief Ring buffer of events owned by one thread
+ *
+ */
+struct TraceBuffer {
+  std::mutex mutex;  // taken by owner on record and by dump
+  std::vector<TraceEvent> events;
+  size_t next = 0;
+  bool wrapped = false;
+  int thread_id = 0;
+};
+
+/**
+ * @brief Collector of trace spans of all threads
+ */
+class Tracer {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * @brief The function returns tracer of the application
+   *
+   * @return Tracer& The tracer
+   */
+  static Tracer &instance();
+
+  /**
+   * @brief The function switches recording on or off
+   *
+   * @param enabled True to record spans
+   */
+  void setEnabled(bool enabled);
+
+  /**
+   * @brief The function returns if spans are recorded
+   *
+   * @return bool True if recording
+   */
+  bool isEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief The function returns microseconds since tracer creation
+   *
+   * @return int64_t Timestamp
+   */
+  int64_t now() const;
+
+  /**
+   * @brief The function adds complete span to the buffer of calling thread
+   *
+   * @param name Span name, must be a string literal
+   * @param start_us Start timestamp
+   * @param duration_us Duration
+   */
+  void record(const char *name, int64_t start_us, int64_t duration_us);
+
+  /**
+   * @brief The function writes recorded spans as Chrome/Perfetto JSON
+   *
+   * @param file_path Path to output file
+   * @return bool True if file was written
+   */
+  bool dump(const std::string &file_path);
+
+  /**
+   * @brief The function drops all recorded spans
+   *
+   */
+  void clear();
+
+  /**
+   * @brief The function returns number of recorded spans
+   *
+   * @return size_t Number of spans in all buffers
+   */
+  size_t eventsCount();
+
+ private:
+  Tracer();
+
+  /**
+   * @brief The function returns buffer of calling thread, creating it once
+   *
+   * @return TraceBuffer& The buffer
+   */
+  TraceBuffer &threadBuffer();
+
+  std::atomic<bool> enabled_;
+  Clock::time_point epoch_;
+  std::mutex buffers_mutex_;
+  std::vector<std::shared_ptr<TraceBuffer>> buffers_;
+};
+
+/**
+ * @brief Span which lasts until the end of the scope
+ */
+class TraceScope {
+ public:
+  /**
+   * @brief The function starts span if tracing is enabled
+   *
+   * @param name Span name, must be a string literal
+   */
+  explicit TraceScope(const char *name)
+      : name_(name),
+        start_(Tracer::instance().isEnabled() ? Tracer::instance().now()
+                                              : -1) {}
+
+  /**
+   * @brief The function records span
+   *
+   */
+  ~TraceScope() {
+    if (start_ >= 0) {
+      Tracer &tracer = Tracer::instance();
+      tracer.record(name_, start_, tracer.now() - start_);
+    }
+  }
+
+  TraceScope(const TraceScope &) = delete;
+  TraceScope &operator=(const TraceScope &) = delete;
+
+ private:
+  const char *name_;
+  int64_t start_;
+};
+
+#endif  // SRC_MODEL_INCLUDE_TRACER_H
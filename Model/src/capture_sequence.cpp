@@ -0,0 +1,20 @@
+#include "capture_sequence.h"
+
+#include <cmath>
+
+CaptureSequence::CaptureSequence(v_capture_axis axis, int frames_count,
+                                 const Vector3& start_angles)
+    : axis_(axis),
+      frames_count_(frames_count > 0 ? frames_count : 1),
+      start_angles_(start_angles) {}
+
+Vector3 CaptureSequence::anglesAt(int frame) const {
+  Vector3 angles = start_angles_;
+  double step = 2.0 * M_PI * (frame % frames_count_) / frames_count_;
+  angles(axis_) = (float)(start_angles_(axis_) + step);
+  return angles;
+}
+
+int CaptureSequence::getFramesCount() const { return frames_count_; }
+
+Vector3 CaptureSequence::getStartAngles() const { return start_angles_; }
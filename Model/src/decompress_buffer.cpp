@@ -0,0 +1,213 @@
+#include "decompress_buffer.h"
+
+#if defined(VIEWER_HAVE_ZLIB)
+#include <zlib.h>
+#endif
+#if defined(VIEWER_HAVE_ZSTD)
+#include <zstd.h>
+#endif
+
+#include <utility>
+
+DecompressBuffer::~DecompressBuffer() { close(); }
+
+v_compression DecompressBuffer::detect(const char* magic, size_t size) {
+  const unsigned char* bytes = reinterpret_cast<const unsigned char*>(magic);
+  if (size >= 2 && bytes[0] == 0x1f && bytes[1] == 0x8b) {
+    return v_compression_gzip;
+  }
+  if (size >= 4 && bytes[0] == 0x28 && bytes[1] == 0xb5 && bytes[2] == 0x2f &&
+      bytes[3] == 0xfd) {
+    return v_compression_zstd;
+  }
+  return v_compression_none;
+}
+
+bool DecompressBuffer::isSupported(v_compression compression) {
+  switch (compression) {
+#if defined(VIEWER_HAVE_ZLIB)
+    case v_compression_gzip:
+      return true;
+#endif
+#if defined(VIEWER_HAVE_ZSTD)
+    case v_compression_zstd:
+      return true;
+#endif
+    default:
+      return false;
+  }
+}
+
+bool DecompressBuffer::open(std::streambuf* source, v_compression compression) {
+  close();
+  if (!isSupported(compression)) return false;
+  source_ = source;
+  compression_ = compression;
+  done_ = stop_ = error_ = false;
+  decoder_ = std::thread(&DecompressBuffer::decode, this);
+  return true;
+}
+
+void DecompressBuffer::close() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  changed_.notify_all();
+  if (decoder_.joinable()) decoder_.join();
+  blocks_.clear();
+  spare_.clear();
+  std::vector<char>().swap(current_);
+  setg(nullptr, nullptr, nullptr);
+  source_ = nullptr;
+}
+
+bool DecompressBuffer::hasError() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return error_;
+}
+
+DecompressBuffer::int_type DecompressBuffer::underflow() {
+  if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+  if (!decoder_.joinable()) return traits_type::eof();
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (current_.capacity() > 0) spare_.push_back(std::move(current_));
+  changed_.wait(lock, [this] { return !blocks_.empty() || done_; });
+  if (blocks_.empty()) {
+    setg(nullptr, nullptr, nullptr);
+    return traits_type::eof();
+  }
+  current_ = std::move(blocks_.front());
+  blocks_.pop_front();
+  lock.unlock();
+  changed_.notify_all();
+  setg(current_.data(), current_.data(), current_.data() + current_.size());
+  return traits_type::to_int_type(*gptr());
+}
+
+std::vector<char> DecompressBuffer::takeBlock() {
+  std::vector<char> block;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!spare_.empty()) {
+      block = std::move(spare_.back());
+      spare_.pop_back();
+    }
+  }
+  block.resize(DECOMPRESS_BUFFER_BLOCK_SIZE);
+  return block;
+}
+
+bool DecompressBuffer::pushBlock(std::vector<char>* block, size_t bytes) {
+  block->resize(bytes);
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    changed_.wait(lock, [this] {
+      return blocks_.size() < DECOMPRESS_BUFFER_BLOCKS || stop_;
+    });
+    if (stop_) return false;
+    if (bytes > 0) blocks_.push_back(std::move(*block));
+  }
+  changed_.notify_all();
+  block->clear();
+  return true;
+}
+
+void DecompressBuffer::decode() {
+  bool decoded = false;
+  if (compression_ == v_compression_gzip) {
+    decoded = inflateGzip();
+  } else if (compression_ == v_compression_zstd) {
+    decoded = decompressZstd();
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    error_ = !decoded && !stop_;
+    done_ = true;
+  }
+  changed_.notify_all();
+}
+
+#if defined(VIEWER_HAVE_ZLIB)
+bool DecompressBuffer::inflateGzip() {
+  z_stream stream = {};
+  // 32 lets zlib read both gzip and zlib headers
+  if (inflateInit2(&stream, 15 + 32) != Z_OK) return false;
+  std::vector<char> input(DECOMPRESS_BUFFER_BLOCK_SIZE);
+  std::vector<char> output = takeBlock();
+  size_t used = 0;
+  bool decoded = true;
+  bool end = false;
+  bool flushed = true;  // inflate keeps no output back
+  while (decoded) {
+    if (stream.avail_in == 0 && flushed) {
+      std::streamsize read = source_->sgetn(input.data(), input.size());
+      if (read <= 0) break;
+      stream.next_in = reinterpret_cast<Bytef*>(input.data());
+      stream.avail_in = read;
+    }
+    // files of several gzip members are decompressed member by member
+    if (end && stream.avail_in > 0) {
+      decoded = inflateReset(&stream) == Z_OK;
+      end = false;
+    }
+    stream.next_out = reinterpret_cast<Bytef*>(output.data() + used);
+    stream.avail_out = output.size() - used;
+    int status = inflate(&stream, Z_NO_FLUSH);
+    used = output.size() - stream.avail_out;
+    if (status == Z_STREAM_END) {
+      end = true;
+    } else if (status != Z_OK && status != Z_BUF_ERROR) {
+      decoded = false;
+    }
+    flushed = end || stream.avail_out > 0;
+    if (decoded && used == output.size()) {
+      decoded = pushBlock(&output, used);
+      output = takeBlock();
+      used = 0;
+    }
+  }
+  decoded = decoded && end && pushBlock(&output, used);
+  inflateEnd(&stream);
+  return decoded;
+}
+#else
+bool DecompressBuffer::inflateGzip() { return false; }
+#endif
+
+#if defined(VIEWER_HAVE_ZSTD)
+bool DecompressBuffer::decompressZstd() {
+  ZSTD_DStream* stream = ZSTD_createDStream();
+  if (stream == NULL) return false;
+  ZSTD_initDStream(stream);
+  std::vector<char> input(ZSTD_DStreamInSize());
+  ZSTD_inBuffer in = {input.data(), 0, 0};
+  std::vector<char> output = takeBlock();
+  ZSTD_outBuffer out = {output.data(), output.size(), 0};
+  size_t status = 0;
+  bool decoded = true;
+  bool flushed = true;  // zstd keeps no output back
+  while (decoded) {
+    if (in.pos == in.size && flushed) {
+      std::streamsize read = source_->sgetn(input.data(), input.size());
+      if (read <= 0) break;
+      in.size = read;
+      in.pos = 0;
+    }
+    status = ZSTD_decompressStream(stream, &out, &in);
+    if (ZSTD_isError(status)) decoded = false;
+    flushed = out.pos < out.size;
+    if (decoded && !flushed) {
+      decoded = pushBlock(&output, out.pos);
+      output = takeBlock();
+      out = {output.data(), output.size(), 0};
+    }
+  }
+  // zero is returned when the last frame is decoded and flushed
+  decoded = decoded && status == 0 && pushBlock(&output, out.pos);
+  ZSTD_freeDStream(stream);
+  return decoded;
+}
+#else
+bool DecompressBuffer::decompressZstd() { return false; }
+#endif
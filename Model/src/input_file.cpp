@@ -0,0 +1,90 @@
+#include "input_file.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+InputFile::~InputFile() { close(); }
+
+bool InputFile::open(const std::string& path, bool direct) {
+  close();
+  fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd_ < 0) return false;
+  struct stat status;
+  if (fstat(fd_, &status) != 0 || S_ISDIR(status.st_mode)) {
+    close();
+    return false;
+  }
+  size_ = status.st_size;
+  void* buffer = nullptr;
+  if (posix_memalign(&buffer, INPUT_FILE_ALIGNMENT, INPUT_FILE_BLOCK_SIZE)) {
+    close();
+    return false;
+  }
+  buffer_ = static_cast<char*>(buffer);
+#if defined(__linux__)
+  posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+  if (direct) setDirect(true);
+  return true;
+}
+
+void InputFile::close() {
+  if (fd_ >= 0) ::close(fd_);
+  free(buffer_);
+  fd_ = -1;
+  size_ = 0;
+  buffer_ = nullptr;
+  direct_ = false;
+  setg(nullptr, nullptr, nullptr);
+}
+
+bool InputFile::isOpen() const { return fd_ >= 0; }
+
+size_t InputFile::size() const { return size_; }
+
+bool InputFile::isDirect() const { return direct_; }
+
+bool InputFile::setDirect(bool direct) {
+#if defined(__linux__)
+  int flags = fcntl(fd_, F_GETFL);
+  if (flags < 0) return false;
+  flags = direct ? flags | O_DIRECT : flags & ~O_DIRECT;
+  if (fcntl(fd_, F_SETFL, flags) != 0) return false;
+#elif defined(__APPLE__)
+  if (fcntl(fd_, F_NOCACHE, direct ? 1 : 0) != 0) return false;
+#else
+  if (direct) return false;
+#endif
+  direct_ = direct;
+  return true;
+}
+
+size_t InputFile::peek(char* data, size_t bytes) {
+  if (gptr() == egptr() && underflow() == traits_type::eof()) return 0;
+  bytes = std::min(bytes, (size_t)(egptr() - gptr()));
+  memcpy(data, gptr(), bytes);
+  return bytes;
+}
+
+InputFile::int_type InputFile::underflow() {
+  if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+  if (fd_ < 0) return traits_type::eof();
+  ssize_t bytes = read(fd_, buffer_, INPUT_FILE_BLOCK_SIZE);
+  while (bytes < 0 && (errno == EINTR || (errno == EINVAL && direct_))) {
+    // file systems without direct reads refuse them only on read
+    if (errno == EINVAL && !setDirect(false)) break;
+    bytes = read(fd_, buffer_, INPUT_FILE_BLOCK_SIZE);
+  }
+  if (bytes <= 0) {
+    setg(nullptr, nullptr, nullptr);
+    return traits_type::eof();
+  }
+  setg(buffer_, buffer_, buffer_ + bytes);
+  return traits_type::to_int_type(*gptr());
+}
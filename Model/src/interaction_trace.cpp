@@ -0,0 +1,143 @@
+#include "interaction_trace.h"
+
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+const char* const kEventNames[v_interaction_events_count] = {
+    "state",       "command",   "undo", "redo",
+    "group_begin", "group_end", "frame"};
+
+bool hasValues(v_interaction_events type) {
+  return type == v_interaction_state || type == v_interaction_command;
+}
+}  // namespace
+
+std::string ReplayReport::toString() const {
+  char text[512];
+  snprintf(text, sizeof(text),
+           "frames: %zu\n"
+           "seconds: %.3f\n"
+           "frame average: %.3f ms\n"
+           "frame p50: %.3f ms\n"
+           "frame p95: %.3f ms\n"
+           "frame p99: %.3f ms\n"
+           "dropped frames: %zu (budget %.3f ms)\n",
+           frame.samples, seconds, frame.average, frame.p50, frame.p95,
+           frame.p99, dropped_frames, budget_ms);
+  return text;
+}
+
+void InteractionTrace::setModelPath(const std::string& path) {
+  model_path_ = path;
+}
+
+const std::string& InteractionTrace::getModelPath() const {
+  return model_path_;
+}
+
+void InteractionTrace::add(const InteractionEvent& event) {
+  events_.push_back(event);
+}
+
+const std::vector<InteractionEvent>& InteractionTrace::getEvents() const {
+  return events_;
+}
+
+size_t InteractionTrace::getFramesCount() const {
+  size_t count = 0;
+  for (const InteractionEvent& event : events_) {
+    if (event.type == v_interaction_frame) ++count;
+  }
+  return count;
+}
+
+void InteractionTrace::clear() {
+  model_path_.clear();
+  events_.clear();
+}
+
+bool InteractionTrace::save(const std::string& path) const {
+  FILE* output = fopen(path.c_str(), "w");
+  if (output == NULL) return false;
+  fprintf(output, "%s %d\nmodel %s\n", INTERACTION_TRACE_NAME,
+          INTERACTION_TRACE_VERSION, model_path_.c_str());
+  for (const InteractionEvent& event : events_) {
+    fprintf(output, "%" PRId64 " %s", event.time_us, kEventNames[event.type]);
+    if (hasValues(event.type)) {
+      // nine digits read floats back exactly
+      fprintf(output, " %d %.9g %.9g %.9g", event.command, event.values[0],
+              event.values[1], event.values[2]);
+    }
+    fputc('\n', output);
+  }
+  return fclose(output) == 0;
+}
+
+bool InteractionTrace::load(const std::string& path) {
+  clear();
+  FILE* input = fopen(path.c_str(), "r");
+  if (input == NULL) return false;
+  char line[4096];
+  char name[64];
+  int version = 0;
+  bool valid = fgets(line, sizeof(line), input) &&
+               sscanf(line, "%63s %d", name, &version) == 2 &&
+               !strcmp(name, INTERACTION_TRACE_NAME) && version >= 1 &&
+               version <= INTERACTION_TRACE_VERSION &&
+               fgets(line, sizeof(line), input) &&
+               !strncmp(line, "model ", 6);
+  if (valid) {
+    model_path_ = line + 6;
+    while (!model_path_.empty() &&
+           (model_path_.back() == '\n' || model_path_.back() == '\r')) {
+      model_path_.pop_back();
+    }
+  }
+
+  int64_t last_time = 0;
+  while (valid && fgets(line, sizeof(line), input)) {
+    InteractionEvent event = {0, v_interaction_frame, 0, {0.0f, 0.0f, 0.0f}};
+    int offset = 0;
+    valid = sscanf(line, "%" SCNd64 " %63s%n", &event.time_us, name,
+                   &offset) == 2 &&
+            event.time_us >= last_time;
+    int type = 0;
+    while (valid && type < v_interaction_events_count &&
+           strcmp(name, kEventNames[type])) {
+      ++type;
+    }
+    valid = valid && type < v_interaction_events_count;
+    if (!valid) break;
+    event.type = (v_interaction_events)type;
+    if (hasValues(event.type)) {
+      valid = sscanf(line + offset, "%d %f %f %f", &event.command,
+                     &event.values[0], &event.values[1],
+                     &event.values[2]) == 4 &&
+              std::isfinite(event.values[0]) &&
+              std::isfinite(event.values[1]) && std::isfinite(event.values[2]);
+    }
+    last_time = event.time_us;
+    if (valid) events_.push_back(event);
+  }
+  fclose(input);
+  if (!valid) clear();
+  return valid;
+}
+
+ReplayReport InteractionTrace::makeReport(const std::vector<double>& frame_ms,
+                                          double budget_ms) {
+  ReplayReport report;
+  report.frame = Profiler::computeStats(frame_ms);
+  report.budget_ms = budget_ms;
+  for (double ms : frame_ms) {
+    report.seconds += ms / 1000.0;
+    if (budget_ms > 0.0 && ms > budget_ms) {
+      // a small tolerance keeps frames of exactly the budget on time
+      report.dropped_frames += (size_t)std::ceil(ms / budget_ms - 1e-3) - 1;
+    }
+  }
+  return report;
+}
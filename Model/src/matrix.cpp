@@ -8,6 +8,10 @@ float& Vector3::r() { return rVal; }
 float& Vector3::g() { return gVal; }
 float& Vector3::b() { return bVal; }
 
+const float& Vector3::x() const { return xVal; }
+const float& Vector3::y() const { return yVal; }
+const float& Vector3::z() const { return zVal; }
+
 float& Vector3::operator()(int col) {
   float* result = nullptr;
   switch (col) {
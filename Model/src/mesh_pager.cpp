@@ -0,0 +1,164 @@
+#include "mesh_pager.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+
+void MeshPager::reset(ScratchFile* vertices, ScratchFile* indices,
+                      const std::vector<Meshlet>& meshlets) {
+  clear();
+  vertices_ = vertices;
+  indices_ = indices;
+  const unsigned int* data = static_cast<const unsigned int*>(indices->data());
+  pages_.resize(meshlets.size());
+  for (size_t i = 0; i < meshlets.size(); ++i) {
+    const Meshlet& meshlet = meshlets[i];
+    Page& page = pages_[i];
+    page.index_offset = sizeof(unsigned int) * meshlet.index_offset;
+    page.index_bytes = sizeof(unsigned int) * meshlet.index_count;
+    const unsigned int* first = data + meshlet.index_offset;
+    setVertices(first, first + meshlet.index_count, &page);
+  }
+  // the model was just read by the parser, so its memory is given back
+  vertices_->dontNeed(0, vertices_->size());
+  indices_->dontNeed(0, indices_->size());
+}
+
+void MeshPager::setVertices(const unsigned int* first,
+                            const unsigned int* last, Page* page) const {
+  std::vector<unsigned int> used(first, last);
+  std::sort(used.begin(), used.end());
+  used.erase(std::unique(used.begin(), used.end()), used.end());
+  for (unsigned int vertex : used) {
+    if (!page->vertices.empty() && page->vertices.back().last == vertex) {
+      ++page->vertices.back().last;
+    } else {
+      page->vertices.push_back({vertex, vertex + 1});
+    }
+  }
+  // runs apart by less than a page are read by the same system calls
+  size_t gap = sysconf(_SC_PAGESIZE) / sizeof(Vector3) + 1;
+  for (const VertexSpan& run : page->vertices) {
+    if (!page->reads.empty() && run.first <= page->reads.back().last + gap) {
+      page->reads.back().last = run.last;
+    } else {
+      page->reads.push_back(run);
+    }
+  }
+  page->bytes = page->index_bytes + 2 * sizeof(Vector3) * used.size();
+}
+
+void MeshPager::clear() {
+  pages_.clear();
+  lru_.clear();
+  resident_bytes_ = 0;
+  requested_count_ = 0;
+  vertices_ = indices_ = nullptr;
+}
+
+void MeshPager::setBudget(size_t bytes) { budget_ = bytes; }
+
+size_t MeshPager::getBudget() const { return budget_; }
+
+size_t MeshPager::getVertexCapacity() const {
+  size_t count = vertices_ ? vertices_->size() / sizeof(Vector3) : 0;
+  return std::min(count, budget_ / (2 * sizeof(Vector3)));
+}
+
+size_t MeshPager::getResidentBytes() const { return resident_bytes_; }
+
+size_t MeshPager::getRequestedCount() const { return requested_count_; }
+
+bool MeshPager::update(const std::vector<size_t>& visible,
+                       std::vector<size_t>* resident,
+                       std::vector<size_t>* missing) {
+  ++frame_;
+  for (size_t i : visible) pages_[i].frame = frame_;
+  bool loaded = false;
+  for (size_t i : visible) {
+    Page& page = pages_[i];
+    if (page.state == v_page_absent) {
+      while (resident_bytes_ + page.bytes > budget_ && evictOne()) {
+      }
+      if (resident_bytes_ + page.bytes > budget_) {
+        missing->push_back(i);
+        continue;
+      }
+      for (const VertexSpan& read : page.reads) {
+        vertices_->willNeed(sizeof(Vector3) * read.first,
+                            sizeof(Vector3) * (read.last - read.first));
+      }
+      indices_->willNeed(page.index_offset, page.index_bytes);
+      page.state = v_page_requested;
+      ++requested_count_;
+      resident_bytes_ += page.bytes;
+      lru_.push_front(i);
+      page.lru = lru_.begin();
+    } else {
+      lru_.splice(lru_.begin(), lru_, page.lru);
+    }
+    if (page.state == v_page_requested && isLoaded(page)) {
+      page.state = v_page_resident;
+      --requested_count_;
+      loaded = true;
+    }
+    if (page.state == v_page_resident) {
+      resident->push_back(i);
+    } else {
+      missing->push_back(i);
+    }
+  }
+  return loaded;
+}
+
+bool MeshPager::evictOne() {
+  if (lru_.empty()) return false;
+  Page& page = pages_[lru_.back()];
+  if (page.frame == frame_) return false;
+  // pages shared with resident neighbours are read again on their access
+  for (const VertexSpan& read : page.reads) {
+    vertices_->dontNeed(sizeof(Vector3) * read.first,
+                        sizeof(Vector3) * (read.last - read.first));
+  }
+  indices_->dontNeed(page.index_offset, page.index_bytes);
+  if (page.state == v_page_requested) --requested_count_;
+  page.state = v_page_absent;
+  resident_bytes_ -= page.bytes;
+  lru_.pop_back();
+  return true;
+}
+
+bool MeshPager::isLoaded(const Page& page) const {
+  if (!indices_->isResident(page.index_offset, page.index_bytes)) {
+    return false;
+  }
+  for (const VertexSpan& read : page.reads) {
+    if (!vertices_->isResident(sizeof(Vector3) * read.first,
+                               sizeof(Vector3) * (read.last - read.first))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::vector<VertexSpan> MeshPager::getSpans(
+    const std::vector<size_t>& meshlets) const {
+  std::vector<VertexSpan> spans;
+  for (size_t i : meshlets) {
+    spans.insert(spans.end(), pages_[i].vertices.begin(),
+                 pages_[i].vertices.end());
+  }
+  std::sort(spans.begin(), spans.end(),
+            [](const VertexSpan& a, const VertexSpan& b) {
+              return a.first < b.first;
+            });
+  std::vector<VertexSpan> merged;
+  for (const VertexSpan& span : spans) {
+    if (!merged.empty() && span.first <= merged.back().last) {
+      merged.back().last = std::max(merged.back().last, span.last);
+    } else {
+      merged.push_back(span);
+    }
+  }
+  return merged;
+}
@@ -0,0 +1,178 @@
+#include "meshlet.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "task_scheduler.h"
+
+std::vector<Meshlet> MeshletBuilder::build(const Vector3* vertices,
+                                           size_t vertices_count,
+                                           const unsigned int* indices,
+                                           size_t indices_count,
+                                           size_t max_vertices,
+                                           size_t max_triangles) {
+  std::vector<Meshlet> result;
+  size_t triangles_count = indices_count / 3;
+  if (!vertices || !indices || vertices_count == 0 || triangles_count == 0) {
+    return result;
+  }
+  // chunks do not depend on the number of threads, so neither do meshlets
+  size_t chunks_count = (triangles_count + MESHLET_MIN_PARALLEL_TRIANGLES - 1) /
+                        MESHLET_MIN_PARALLEL_TRIANGLES;
+  std::vector<std::vector<Meshlet>> parts(chunks_count);
+  TaskScheduler::instance().parallelFor(
+      0, chunks_count, 1, [&](size_t first_chunk, size_t last_chunk) {
+        for (size_t t = first_chunk; t < last_chunk; ++t) {
+          size_t first = t * MESHLET_MIN_PARALLEL_TRIANGLES;
+          size_t last =
+              std::min(first + MESHLET_MIN_PARALLEL_TRIANGLES, triangles_count);
+          partition(indices, first, last, max_vertices, max_triangles,
+                    parts[t]);
+          for (Meshlet& meshlet : parts[t]) {
+            computeBounds(vertices, indices, meshlet);
+          }
+        }
+      });
+
+  for (std::vector<Meshlet>& part : parts) {
+    result.insert(result.end(), part.begin(), part.end());
+  }
+  return result;
+}
+
+void MeshletBuilder::partition(const unsigned int* indices,
+                               size_t first_triangle, size_t last_triangle,
+                               size_t max_vertices, size_t max_triangles,
+                               std::vector<Meshlet>& out) {
+  std::vector<unsigned int> unique;
+  unique.reserve(max_vertices);
+  Meshlet current{};
+  current.index_offset = first_triangle * 3;
+  for (size_t i = first_triangle; i < last_triangle; ++i) {
+    const unsigned int* triangle = indices + i * 3;
+    size_t added = 0;
+    for (int k = 0; k < 3; ++k) {
+      bool found = std::find(unique.begin(), unique.end(), triangle[k]) !=
+                   unique.end();
+      for (int j = 0; j < k && !found; ++j) found = triangle[j] == triangle[k];
+      if (!found) ++added;
+    }
+    if (unique.size() + added > max_vertices ||
+        current.index_count / 3 >= max_triangles) {
+      current.vertex_count = unique.size();
+      out.push_back(current);
+      current = Meshlet{};
+      current.index_offset = i * 3;
+      unique.clear();
+    }
+    for (int k = 0; k < 3; ++k) {
+      if (std::find(unique.begin(), unique.end(), triangle[k]) ==
+          unique.end()) {
+        unique.push_back(triangle[k]);
+      }
+    }
+    current.index_count += 3;
+  }
+  if (current.index_count > 0) {
+    current.vertex_count = unique.size();
+    out.push_back(current);
+  }
+}
+
+void MeshletBuilder::computeBounds(const Vector3* vertices,
+                                   const unsigned int* indices,
+                                   Meshlet& meshlet) {
+  const unsigned int* first = indices + meshlet.index_offset;
+  Vector3 min_v = vertices[first[0]];
+  Vector3 max_v = vertices[first[0]];
+  for (unsigned int i = 0; i < meshlet.index_count; ++i) {
+    const Vector3& v = vertices[first[i]];
+    for (int axis = 0; axis < 3; ++axis) {
+      min_v(axis) = std::min(min_v(axis), v(axis));
+      max_v(axis) = std::max(max_v(axis), v(axis));
+    }
+  }
+  for (int axis = 0; axis < 3; ++axis) {
+    meshlet.center(axis) = (min_v(axis) + max_v(axis)) / 2;
+  }
+  float radius_sq = 0.0f;
+  for (unsigned int i = 0; i < meshlet.index_count; ++i) {
+    const Vector3& v = vertices[first[i]];
+    float dx = v.x() - meshlet.center.x();
+    float dy = v.y() - meshlet.center.y();
+    float dz = v.z() - meshlet.center.z();
+    radius_sq = std::max(radius_sq, dx * dx + dy * dy + dz * dz);
+  }
+  meshlet.radius = sqrtf(radius_sq);
+
+  // normal cone: axis is the mean of unit normals, cutoff is the widest one
+  std::vector<Vector3> normals;
+  normals.reserve(meshlet.index_count / 3);
+  Vector3 sum;
+  for (unsigned int i = 0; i < meshlet.index_count; i += 3) {
+    const Vector3& a = vertices[first[i]];
+    const Vector3& b = vertices[first[i + 1]];
+    const Vector3& c = vertices[first[i + 2]];
+    Vector3 e1(b.x() - a.x(), b.y() - a.y(), b.z() - a.z());
+    Vector3 e2(c.x() - a.x(), c.y() - a.y(), c.z() - a.z());
+    Vector3 n(e1.y() * e2.z() - e1.z() * e2.y(),
+              e1.z() * e2.x() - e1.x() * e2.z(),
+              e1.x() * e2.y() - e1.y() * e2.x());
+    float length = sqrtf(n.x() * n.x() + n.y() * n.y() + n.z() * n.z());
+    if (length > 0.0f) {
+      n = Vector3(n.x() / length, n.y() / length, n.z() / length);
+      normals.push_back(n);
+      sum = Vector3(sum.x() + n.x(), sum.y() + n.y(), sum.z() + n.z());
+    }
+  }
+  float length =
+      sqrtf(sum.x() * sum.x() + sum.y() * sum.y() + sum.z() * sum.z());
+  meshlet.cone_cutoff = -1.0f;
+  if (length > 0.0f) {
+    meshlet.cone_axis =
+        Vector3(sum.x() / length, sum.y() / length, sum.z() / length);
+    float cutoff = 1.0f;
+    for (const Vector3& n : normals) {
+      cutoff = std::min(cutoff, n.x() * meshlet.cone_axis.x() +
+                                    n.y() * meshlet.cone_axis.y() +
+                                    n.z() * meshlet.cone_axis.z());
+    }
+    meshlet.cone_cutoff = cutoff;
+  }
+}
+
+bool MeshletBuilder::isVisible(const Meshlet& meshlet, const Matrix4x4& mvp) {
+  // clip planes are sums and differences of the last row with the others
+  bool visible = true;
+  for (int row = 0; row < 3 && visible; ++row) {
+    for (int sign = -1; sign <= 1 && visible; sign += 2) {
+      float a = mvp(3, 0) + sign * mvp(row, 0);
+      float b = mvp(3, 1) + sign * mvp(row, 1);
+      float c = mvp(3, 2) + sign * mvp(row, 2);
+      float d = mvp(3, 3) + sign * mvp(row, 3);
+      float length = sqrtf(a * a + b * b + c * c);
+      if (length > 0.0f) {
+        float distance = (a * meshlet.center.x() + b * meshlet.center.y() +
+                          c * meshlet.center.z() + d) /
+                         length;
+        visible = distance >= -meshlet.radius;
+      }
+    }
+  }
+  return visible;
+}
+
+std::vector<IndexRange> MeshletBuilder::visibleRanges(
+    const std::vector<Meshlet>& meshlets, const Matrix4x4& mvp) {
+  std::vector<IndexRange> ranges;
+  for (const Meshlet& meshlet : meshlets) {
+    if (!isVisible(meshlet, mvp)) continue;
+    if (!ranges.empty() && ranges.back().offset + ranges.back().count ==
+                               meshlet.index_offset) {
+      ranges.back().count += meshlet.index_count;
+    } else {
+      ranges.push_back({meshlet.index_offset, meshlet.index_count});
+    }
+  }
+  return ranges;
+}
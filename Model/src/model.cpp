@@ -4,11 +4,13 @@ Model::Model(IParser* p)
     : parser(p),
       file_path(""),
       vertices3d(NULL),
-      vertices4d(NULL),
       vertices_count(0),
       indices(NULL),
       indices_count(0),
-      error_code(0) {
+      error_code(0),
+      progressive_mesh(NULL),
+      direct_read(false),
+      load_cancelled(false) {
   parser->initParser(this);
 }
 
@@ -32,29 +34,58 @@ Vector3* Model::getVertices3d() { return vertices3d; }
 
 void Model::setVertices3d(Vector3* vertices) { vertices3d = vertices; }
 
-Vector4* Model::getVertices4d() { return vertices4d; }
-
-void Model::setVertices4d(Vector4* vertices) { vertices4d = vertices; }
-
 unsigned int* Model::getIndices() { return indices; }
 
 void Model::setIndices(unsigned int* indices) { this->indices = indices; }
 
+void Model::setProgressiveMesh(ProgressiveMesh* mesh) {
+  progressive_mesh = mesh;
+}
+
+ProgressiveMesh* Model::getProgressiveMesh() { return progressive_mesh; }
+
+void Model::setScratchDir(const std::string& dir) { scratch_dir = dir; }
+
+const std::string& Model::getScratchDir() const { return scratch_dir; }
+
+void Model::setDirectRead(bool direct) { direct_read = direct; }
+
+bool Model::isDirectRead() const { return direct_read; }
+
+void Model::setLoadCancelled(bool cancelled) { load_cancelled = cancelled; }
+
+bool Model::isLoadCancelled() const { return load_cancelled; }
+
+ScratchFile& Model::getVerticesFile() { return vertices_file; }
+
+ScratchFile& Model::getIndicesFile() { return indices_file; }
+
+bool Model::isOutOfCore() const { return vertices_file.isOpen(); }
+
+const std::vector<Meshlet>& Model::getMeshlets() const { return meshlets; }
+
+QuantizedPositions Model::quantizePositions() const {
+  return PositionQuantizer::quantize(vertices3d, vertices_count);
+}
+
 void Model::uploadModel(std::string file_path) {
   setFilePath(file_path);
   parser->parseFile();
 }
 
 void Model::initModel() {
+  TRACE_SCOPE("Model::initModel");
   if (error_code == 0) {
     normalizeModel();
   }
   if (error_code == 0) {
-    generate4dFrom3d();
+    buildMeshlets();
   }
 }
 
 void Model::normalizeModel() {
+  TRACE_SCOPE("Model::normalizeModel");
+  ScopedTimer timer(v_profiler_normalize);
   float max_x, min_x;
   max_x = min_x = vertices3d[0].x();
   float max_y, min_y;
@@ -87,33 +118,28 @@ void Model::normalizeModel() {
   }
 }
 
-void Model::generate4dFrom3d() {
-  vertices4d = new Vector4[vertices_count];
-  for (size_t i = 0; i < vertices_count; ++i) {
-    vertices4d[i] = get4dBy3d(vertices3d[i]);
-  }
-}
-
-Vector4 Model::get4dBy3d(Vector3 vector) {
-  Vector4 result;
-  result.x() = vector.x();
-  result.y() = vector.y();
-  result.z() = vector.z();
-  result.w() = 1.0f;
-  return result;
+void Model::buildMeshlets() {
+  TRACE_SCOPE("Model::buildMeshlets");
+  meshlets = MeshletBuilder::build(vertices3d, vertices_count, indices,
+                                   indices_count);
 }
 
 void Model::deleteModel() {
-  if (indices) {
+  // mapped arrays are freed with their files
+  if (indices_file.isOpen()) {
+    indices = NULL;
+    indices_file.close();
+  } else if (indices) {
     delete[] indices;
     indices = NULL;
   }
-  if (vertices3d != NULL) {
+  if (vertices_file.isOpen()) {
+    vertices3d = NULL;
+    vertices_file.close();
+  } else if (vertices3d != NULL) {
     delete[] vertices3d;
     vertices3d = NULL;
   };
-  if (vertices4d != NULL) {
-    delete[] vertices4d;
-    vertices4d = NULL;
-  };
+  meshlets.clear();
+  meshlets.shrink_to_fit();
 }
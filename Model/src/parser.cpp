@@ -1,10 +1,15 @@
 #include "parser.h"
 
+#include <charconv>
+
 void Parser::initParser(Model *m) { model = m; }
 
 void Parser::clearVectors() {
-  vertexes.clear();
-  vertex_indexes.clear();
+  Vector().swap(vertexes);
+  Vector().swap(vertex_indexes);
+  published_vertexes = 0;
+  published_indexes = 0;
+  spilled_vertexes = 0;
 }
 
 int Parser::addToVector(const std::string &str) {
@@ -15,9 +20,14 @@ int Parser::addToVector(const std::string &str) {
   std::getline(ss, part, SEP);
   while (std::getline(ss, part, SEP) && !error) {
     if (!part.empty() && str[0] == VECTOR) {
-      char *endptr;
-      double number = std::strtod(part.c_str(), &endptr);
-      if (*endptr == '\0' || *endptr == '\n' || *endptr == '\r') {
+      // numbers have a point whatever locale the process uses
+      const char *first = part.data();
+      const char *last = first + part.size();
+      if (*first == '+') ++first;
+      double number = 0.0;
+      std::from_chars_result result = std::from_chars(first, last, number);
+      if (result.ec == std::errc() &&
+          (result.ptr == last || *result.ptr == '\n' || *result.ptr == '\r')) {
         vertexes.push_back(number);
         ++number_count;
       } else {
@@ -93,6 +103,7 @@ int Parser::parseFace(const std::string &str) {
 }
 
 void Parser::vertexesToModel() {
+  TRACE_SCOPE("Parser::vertexesToModel");
   model->setVerticesCount(vertexes.size() / 3);
   Vector3 *vertices3d = new Vector3[model->getVerticesCount()];
   for (size_t i = 0, j = 0; i < model->getVerticesCount(); ++i) {
@@ -103,56 +114,167 @@ void Parser::vertexesToModel() {
   model->setVertices3d(vertices3d);
 }
 
+unsigned int Parser::resolveIndex(int index) {
+  if (index > (int)model->getVerticesCount()) {
+    index = (index % model->getVerticesCount()) - 1;
+  } else if (index > 0) {
+    index -= 1;
+  } else if (index == 0) {
+    model->setErrorCode(ERROR_F);
+  }
+  if (index < 0) {
+    index = model->getVerticesCount() + index;
+  }
+  return (unsigned)index;
+}
+
 void Parser::indexesToModel() {
+  TRACE_SCOPE("Parser::indexesToModel");
   unsigned int *indices = new unsigned int[vertex_indexes.size()];
   if (model->getVerticesCount() < 1) model->setErrorCode(ERROR_V);
   for (size_t i = 0; i < vertex_indexes.size() && !model->getErrorCode(); ++i) {
-    int index = (int)vertex_indexes[i];
-    if (index > (int)model->getVerticesCount()) {
-      index = (index % model->getVerticesCount()) - 1;
-    } else if (index > 0) {
-      index -= 1;
-    } else if (index == 0) {
-      model->setErrorCode(ERROR_F);
-    }
-    if (index < 0) {
-      index = model->getVerticesCount() + index;
-    }
-    indices[i] = (unsigned)index;
+    indices[i] = resolveIndex((int)vertex_indexes[i]);
   }
   model->setIndices(indices);
   model->setIndicesCount(vertex_indexes.size());
 }
 
-int Parser::fileExists(const std::string &filename) {
-  int error = OK;
-  std::ifstream file(filename);
-  if (!file.is_open()) {
-    error = ERROR_FILE;
+int Parser::spillVectors() {
+  TRACE_SCOPE("Parser::spillVectors");
+  // progressive batches are published before the vectors are cleared
+  ProgressiveMesh *mesh = model->getProgressiveMesh();
+  if (mesh != NULL) publishBatch(mesh);
+  std::vector<Vector3> vertices(vertexes.size() / 3);
+  for (size_t i = 0; i < vertices.size(); ++i) {
+    vertices[i] = Vector3(vertexes[i * 3], vertexes[i * 3 + 1],
+                          vertexes[i * 3 + 2]);
   }
-  return error;
+  std::vector<int> indexes(vertex_indexes.begin(), vertex_indexes.end());
+  bool written = model->getVerticesFile().append(
+                     vertices.data(), sizeof(Vector3) * vertices.size()) &&
+                 model->getIndicesFile().append(
+                     indexes.data(), sizeof(int) * indexes.size());
+  spilled_vertexes += vertices.size();
+  vertexes.clear();
+  vertex_indexes.clear();
+  published_vertexes = 0;
+  published_indexes = 0;
+  return written ? OK : ERROR_FILE;
 }
 
-int Parser::fileEmpty(const std::string &filename) {
-  int error = OK;
-  std::ifstream file(filename);
-  if (!file.is_open()) {
-    error = ERROR_FILE;
+void Parser::mappedToModel() {
+  TRACE_SCOPE("Parser::mappedToModel");
+  ScratchFile &vertices_file = model->getVerticesFile();
+  ScratchFile &indices_file = model->getIndicesFile();
+  if (!vertices_file.map() || !indices_file.map()) {
+    model->setErrorCode(ERROR_FILE);
+    return;
   }
-  if (file.peek() == std::ifstream::traits_type::eof()) {
-    error = EMPTY_FILE;
+  model->setVerticesCount(vertices_file.size() / sizeof(Vector3));
+  model->setVertices3d(static_cast<Vector3 *>(vertices_file.data()));
+  // indexes of the file are replaced by indices of model in place
+  size_t indices_count = indices_file.size() / sizeof(int);
+  int *indexes = static_cast<int *>(indices_file.data());
+  unsigned int *indices = static_cast<unsigned int *>(indices_file.data());
+  if (model->getVerticesCount() < 1) model->setErrorCode(ERROR_V);
+  for (size_t i = 0; i < indices_count && !model->getErrorCode(); ++i) {
+    indices[i] = resolveIndex(indexes[i]);
   }
-  return error;
+  model->setIndices(indices);
+  model->setIndicesCount(indices_count);
+}
+
+void Parser::publishBatch(ProgressiveMesh *mesh) {
+  TRACE_SCOPE("Parser::publishBatch");
+  size_t vertexes_count = spilled_vertexes + vertexes.size() / 3;
+  std::vector<Vector3> vertices;
+  vertices.reserve(vertexes.size() / 3 - published_vertexes);
+  for (size_t i = published_vertexes; i < vertexes.size() / 3; ++i) {
+    vertices.push_back(Vector3(vertexes[i * 3], vertexes[i * 3 + 1],
+                               vertexes[i * 3 + 2]));
+  }
+  // faces with vertexes which are not read yet wait for the final model
+  std::vector<unsigned int> indices;
+  for (size_t i = published_indexes; i + 2 < vertex_indexes.size(); i += 3) {
+    unsigned int triangle[3];
+    bool loaded = true;
+    for (int j = 0; j < 3 && loaded; ++j) {
+      int index = (int)vertex_indexes[i + j];
+      if (index > 0 && index <= (int)vertexes_count) {
+        triangle[j] = index - 1;
+      } else if (index < 0 && -index <= (int)vertexes_count) {
+        triangle[j] = vertexes_count + index;
+      } else {
+        loaded = false;
+      }
+    }
+    if (loaded) indices.insert(indices.end(), triangle, triangle + 3);
+  }
+  published_vertexes = vertexes.size() / 3;
+  published_indexes = vertex_indexes.size();
+  mesh->append(vertices, indices);
+}
+
+int Parser::openFile(const std::string &filename) {
+  TRACE_SCOPE("Parser::openFile");
+  if (!file.open(filename, model->isDirectRead())) return ERROR_FILE;
+  return file.size() == 0 ? EMPTY_FILE : OK;
+}
+
+void Parser::reserveVectors(size_t file_size) {
+  size_t vertexes_count = file_size / PROGRESSIVE_MESH_BYTES_PER_VERTEX + 1;
+  size_t values = 3 * vertexes_count;
+  size_t indexes = PROGRESSIVE_MESH_INDICES_PER_VERTEX * vertexes_count;
+  // spilled vectors never grow past the spill threshold
+  if (!model->getScratchDir().empty()) {
+    values = std::min(values, (size_t)PARSER_SPILL_VALUES);
+    indexes = std::min(indexes, (size_t)PARSER_SPILL_VALUES);
+  }
+  vertexes.reserve(values);
+  vertex_indexes.reserve(indexes);
+}
+
+int Parser::openInput(DecompressBuffer *decompressed, std::istream *input) {
+  TRACE_SCOPE("Parser::openInput");
+  char magic[DECOMPRESS_BUFFER_MAGIC_BYTES] = {};
+  size_t magic_size = file.peek(magic, sizeof(magic));
+  v_compression compression = DecompressBuffer::detect(magic, magic_size);
+  if (compression == v_compression_none) {
+    // size of plain file tells how many values are parsed from it
+    reserveVectors(file.size());
+    return OK;
+  }
+  // compressed file is decompressed on another thread while it is parsed
+  if (!decompressed->open(&file, compression)) return ERROR_FILE;
+  input->rdbuf(decompressed);
+  if (input->peek() == std::istream::traits_type::eof()) {
+    return decompressed->hasError() ? ERROR : EMPTY_FILE;
+  }
+  return OK;
 }
 
 void Parser::process() {
+  TRACE_SCOPE("Parser::process");
   model->setErrorCode(OK);
-  std::ifstream file(model->getFilePath());
   std::string str;
-  if (!file.is_open()) {
+  // out of core model is spilled to scratch files as it is parsed
+  bool spill = !model->getScratchDir().empty();
+  if (spill && !model->getErrorCode() &&
+      (!model->getVerticesFile().open(model->getScratchDir()) ||
+       !model->getIndicesFile().open(model->getScratchDir()))) {
     model->setErrorCode(ERROR_FILE);
   }
-  while (!model->getErrorCode() && std::getline(file, str)) {
+  ProgressiveMesh *mesh = model->getProgressiveMesh();
+  if (mesh != NULL) mesh->reset(file.size());
+  DecompressBuffer decompressed;
+  std::istream input(&file);
+  if (!model->getErrorCode()) {
+    model->setErrorCode(openInput(&decompressed, &input));
+  }
+  size_t lines_count = 0;
+  // a load superseded by another file stops between lines
+  while (!model->getErrorCode() && !model->isLoadCancelled() &&
+         std::getline(input, str)) {
     if (!str.empty()) {
       if (str[0] == VECTOR && str[1] == SPACE) {
         model->setErrorCode(addToVector(str));
@@ -160,19 +282,38 @@ void Parser::process() {
         model->setErrorCode(parseFace(str));
       }
     }
+    if (mesh != NULL && ++lines_count % PROGRESSIVE_MESH_BATCH_LINES == 0) {
+      publishBatch(mesh);
+    }
+    if (spill && !model->getErrorCode() &&
+        vertexes.size() + vertex_indexes.size() >= PARSER_SPILL_VALUES) {
+      model->setErrorCode(spillVectors());
+    }
   }
-  if (!model->getErrorCode()) {
+  if (!model->getErrorCode() &&
+      (decompressed.hasError() || model->isLoadCancelled())) {
+    model->setErrorCode(ERROR);
+  }
+  if (spill && !model->getErrorCode()) model->setErrorCode(spillVectors());
+  if (mesh != NULL) {
+    if (!model->getErrorCode()) publishBatch(mesh);
+    mesh->finish();
+  }
+  if (!model->getErrorCode() && spill) {
+    mappedToModel();
+  } else if (!model->getErrorCode()) {
     vertexesToModel();
     indexesToModel();
   }
-  file.close();
+  // the decoder thread reads the file until it is stopped
+  decompressed.close();
   clearVectors();
 }
 
 void Parser::parseFile() {
-  setlocale(LC_ALL, "C");
-  model->setErrorCode(fileExists(model->getFilePath()));
-  if (!model->getErrorCode())
-    model->setErrorCode(fileEmpty(model->getFilePath()));
+  TRACE_SCOPE("Parser::parseFile");
+  ScopedTimer timer(v_profiler_parse);
+  model->setErrorCode(openFile(model->getFilePath()));
   if (!model->getErrorCode()) process();
+  file.close();
 }
@@ -0,0 +1,113 @@
+#include "profiler.h"
+
+#include <algorithm>
+
+Profiler::Profiler() : has_frame_(false) {
+  for (int i = 0; i < v_profiler_stages_count; ++i) next_[i] = 0;
+  for (int i = 0; i < v_profiler_counters_count; ++i) counters_[i] = 0.0;
+}
+
+Profiler& Profiler::instance() {
+  static Profiler profiler;
+  return profiler;
+}
+
+void Profiler::addSample(v_profiler_stages stage, double ms) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<double>& history = history_[stage];
+  if (history.size() < PROFILER_HISTORY) {
+    history.push_back(ms);
+  } else {
+    history[next_[stage]] = ms;
+  }
+  next_[stage] = (next_[stage] + 1) % PROFILER_HISTORY;
+}
+
+void Profiler::setCounter(v_profiler_counters counter, double value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  counters_[counter] = value;
+}
+
+double Profiler::getCounter(v_profiler_counters counter) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return counters_[counter];
+}
+
+void Profiler::markFrame() {
+  Clock::time_point now = Clock::now();
+  double ms = 0.0;
+  bool has_previous = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    has_previous = has_frame_;
+    ms = std::chrono::duration<double, std::milli>(now - last_frame_).count();
+    last_frame_ = now;
+    has_frame_ = true;
+  }
+  if (has_previous) addSample(v_profiler_frame, ms);
+}
+
+ProfilerStats Profiler::getStats(v_profiler_stages stage) const {
+  std::vector<double> samples;
+  double last = 0.0;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    samples = history_[stage];
+    if (!samples.empty()) {
+      size_t index = (next_[stage] + PROFILER_HISTORY - 1) % PROFILER_HISTORY;
+      last = samples[std::min(index, samples.size() - 1)];
+    }
+  }
+  ProfilerStats stats = computeStats(std::move(samples));
+  stats.last = last;
+  return stats;
+}
+
+ProfilerStats Profiler::computeStats(std::vector<double> samples) {
+  ProfilerStats stats{};
+  stats.samples = samples.size();
+  if (!samples.empty()) {
+    stats.last = samples.back();
+    std::sort(samples.begin(), samples.end());
+    double sum = 0.0;
+    for (double value : samples) sum += value;
+    stats.average = sum / samples.size();
+    // nearest-rank percentiles
+    auto percentile = [&samples](double p) {
+      size_t rank = (size_t)(p * samples.size() + 0.999999);
+      return samples[std::min(std::max(rank, (size_t)1), samples.size()) - 1];
+    };
+    stats.p50 = percentile(0.50);
+    stats.p95 = percentile(0.95);
+    stats.p99 = percentile(0.99);
+  }
+  return stats;
+}
+
+double Profiler::getFps() const {
+  ProfilerStats frame = getStats(v_profiler_frame);
+  return frame.average > 0.0 ? 1000.0 / frame.average : 0.0;
+}
+
+void Profiler::reset() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (int i = 0; i < v_profiler_stages_count; ++i) {
+    history_[i].clear();
+    next_[i] = 0;
+  }
+  for (int i = 0; i < v_profiler_counters_count; ++i) counters_[i] = 0.0;
+  has_frame_ = false;
+}
+
+const char* Profiler::stageName(v_profiler_stages stage) {
+  static const char* names[v_profiler_stages_count] = {
+      "load",  "parse", "normalize", "transform", "upload",
+      "stall", "draw",  "gpu",       "frame"};
+  return stage < v_profiler_stages_count ? names[stage] : "unknown";
+}
+
+const char* Profiler::counterName(v_profiler_counters counter) {
+  static const char* names[v_profiler_counters_count] = {
+      "upload MB/s", "task queue", "task steals"};
+  return counter < v_profiler_counters_count ? names[counter] : "unknown";
+}
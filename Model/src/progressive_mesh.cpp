@@ -0,0 +1,118 @@
+#include "progressive_mesh.h"
+
+#include <algorithm>
+#include <cmath>
+
+void ProgressiveMesh::reset(size_t file_size) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++generation_;
+  vertices_.clear();
+  indices_.clear();
+  expected_vertices_ = file_size / PROGRESSIVE_MESH_BYTES_PER_VERTEX + 1;
+  vertices_.reserve(expected_vertices_);
+  indices_.reserve(expected_vertices_ * PROGRESSIVE_MESH_INDICES_PER_VERTEX);
+  min_ = max_ = Vector3();
+  finished_ = false;
+}
+
+void ProgressiveMesh::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++generation_;
+  std::vector<Vector3>().swap(vertices_);
+  std::vector<unsigned int>().swap(indices_);
+  min_ = max_ = Vector3();
+  expected_vertices_ = 0;
+  finished_ = false;
+}
+
+void ProgressiveMesh::append(const std::vector<Vector3>& vertices,
+                             const std::vector<unsigned int>& indices) {
+  std::function<void()> handler;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (vertices_.empty() && !vertices.empty()) {
+      min_ = max_ = vertices.front();
+    }
+    for (const Vector3& vertex : vertices) {
+      for (int axis = 0; axis < 3; ++axis) {
+        min_(axis) = std::min(min_(axis), vertex(axis));
+        max_(axis) = std::max(max_(axis), vertex(axis));
+      }
+    }
+    vertices_.insert(vertices_.end(), vertices.begin(), vertices.end());
+    indices_.insert(indices_.end(), indices.begin(), indices.end());
+    handler = handler_;
+  }
+  if (handler) handler();
+}
+
+void ProgressiveMesh::finish() {
+  std::function<void()> handler;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    finished_ = true;
+    handler = handler_;
+  }
+  if (handler) handler();
+}
+
+void ProgressiveMesh::setBatchHandler(std::function<void()> handler) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  handler_ = handler;
+}
+
+ProgressiveBatch ProgressiveMesh::getBatch(size_t first_vertex,
+                                           size_t first_index) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ProgressiveBatch batch;
+  batch.first_vertex = std::min(first_vertex, vertices_.size());
+  batch.first_index = std::min(first_index, indices_.size());
+  batch.vertices.assign(vertices_.begin() + batch.first_vertex,
+                        vertices_.end());
+  batch.indices.assign(indices_.begin() + batch.first_index, indices_.end());
+  batch.min = min_;
+  batch.max = max_;
+  batch.finished = finished_;
+  batch.generation = generation_;
+  return batch;
+}
+
+size_t ProgressiveMesh::getVerticesCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return vertices_.size();
+}
+
+size_t ProgressiveMesh::getIndicesCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return indices_.size();
+}
+
+void ProgressiveMesh::getExpectedCounts(size_t* vertices_count,
+                                        size_t* indices_count) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  *vertices_count = std::max(expected_vertices_, vertices_.size());
+  *indices_count =
+      std::max(expected_vertices_ * PROGRESSIVE_MESH_INDICES_PER_VERTEX,
+               indices_.size());
+}
+
+Matrix4x4 ProgressiveMesh::getNormalizationMatrix() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return normalizationMatrix(min_, max_);
+}
+
+Matrix4x4 ProgressiveMesh::normalizationMatrix(const Vector3& min,
+                                               const Vector3& max) {
+  float all_max = std::max(std::max(max.x(), max.y()), max.z());
+  float all_min = std::min(std::min(min.x(), min.y()), min.z());
+  float all_max_abs = std::max(fabsf(all_max), fabsf(all_min));
+  // models inside the unit cube are left as they are
+  if (all_max_abs <= 1) return MatrixGenerator().generate_identity();
+  float scale = 1.0f / all_max_abs;
+  scale *= MINIMIZE_FACTOR;
+  Vector3 center(-(max.x() + min.x()) / 2, -(max.y() + min.y()) / 2,
+                 -(max.z() + min.z()) / 2);
+  return MatrixGenerator().matrix_mult_4x4(
+      MatrixGenerator().generate_scale_matrix(scale, scale, scale),
+      MatrixGenerator().generate_translation_matrix(center));
+}
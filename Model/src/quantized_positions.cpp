@@ -0,0 +1,65 @@
+#include "quantized_positions.h"
+
+#include <algorithm>
+
+QuantizedPositions PositionQuantizer::quantize(const Vector3* vertices,
+                                               size_t count) {
+  QuantizedPositions result;
+  result.max_error = 0.0f;
+  if (!vertices || count == 0) return result;
+
+  Vector3 max_v = vertices[0];
+  result.offset = vertices[0];
+  for (size_t i = 1; i < count; ++i) {
+    for (int axis = 0; axis < 3; ++axis) {
+      result.offset(axis) = std::min(result.offset(axis), vertices[i](axis));
+      max_v(axis) = std::max(max_v(axis), vertices[i](axis));
+    }
+  }
+  float max_extent = 0.0f;
+  for (int axis = 0; axis < 3; ++axis) {
+    result.extent(axis) = max_v(axis) - result.offset(axis);
+    max_extent = std::max(max_extent, result.extent(axis));
+  }
+
+  result.data.resize(count * 3);
+  float max_error = 0.0f;
+  for (size_t i = 0; i < count; ++i) {
+    for (int axis = 0; axis < 3; ++axis) {
+      float extent = result.extent(axis);
+      float value = 0.0f;
+      if (extent > 0.0f) {
+        value = (vertices[i](axis) - result.offset(axis)) / extent *
+                QUANTIZATION_MAX_VALUE;
+      }
+      value = std::min(std::max(value, 0.0f), QUANTIZATION_MAX_VALUE);
+      uint16_t q = (uint16_t)lrintf(value);
+      result.data[i * 3 + axis] = q;
+      float restored =
+          result.offset(axis) + q / QUANTIZATION_MAX_VALUE * extent;
+      max_error = std::max(max_error, fabsf(restored - vertices[i](axis)));
+    }
+  }
+  result.max_error = max_extent > 0.0f ? max_error / max_extent : 0.0f;
+  return result;
+}
+
+Vector3 PositionQuantizer::dequantize(const QuantizedPositions& positions,
+                                      size_t index) {
+  Vector3 result;
+  for (int axis = 0; axis < 3; ++axis) {
+    result(axis) = positions.offset(axis) +
+                   positions.data[index * 3 + axis] / QUANTIZATION_MAX_VALUE *
+                       positions.extent(axis);
+  }
+  return result;
+}
+
+Matrix4x4 PositionQuantizer::dequantizationMatrix(
+    const QuantizedPositions& positions) {
+  return MatrixGenerator().matrix_mult_4x4(
+      MatrixGenerator().generate_translation_matrix(positions.offset),
+      MatrixGenerator().generate_scale_matrix(positions.extent.x(),
+                                              positions.extent.y(),
+                                              positions.extent.z()));
+}
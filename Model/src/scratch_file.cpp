@@ -0,0 +1,106 @@
+#include "scratch_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <vector>
+
+ScratchFile::~ScratchFile() { close(); }
+
+bool ScratchFile::open(const std::string& dir) {
+  close();
+  std::string path = dir + SCRATCH_FILE_TEMPLATE;
+  std::vector<char> name(path.begin(), path.end());
+  name.push_back('\0');
+  fd_ = mkstemp(name.data());
+  if (fd_ < 0) return false;
+  unlink(name.data());
+  return true;
+}
+
+void ScratchFile::close() {
+  if (data_ != nullptr) munmap(data_, size_);
+  if (fd_ >= 0) ::close(fd_);
+  data_ = nullptr;
+  fd_ = -1;
+  size_ = 0;
+}
+
+bool ScratchFile::isOpen() const { return fd_ >= 0; }
+
+bool ScratchFile::append(const void* data, size_t bytes) {
+  if (fd_ < 0 || data_ != nullptr) return false;
+  const char* next = static_cast<const char*>(data);
+  while (bytes > 0) {
+    ssize_t written = write(fd_, next, bytes);
+    if (written < 0 && errno == EINTR) continue;
+    if (written <= 0) return false;
+    next += written;
+    bytes -= written;
+    size_ += written;
+  }
+  return true;
+}
+
+bool ScratchFile::resize(size_t bytes) {
+  if (fd_ < 0 || data_ != nullptr || ftruncate(fd_, bytes) != 0) return false;
+  size_ = bytes;
+  return lseek(fd_, 0, SEEK_END) >= 0;
+}
+
+bool ScratchFile::map() {
+  if (fd_ < 0) return false;
+  if (data_ != nullptr || size_ == 0) return true;
+  void* data =
+      mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  if (data == MAP_FAILED) return false;
+  data_ = static_cast<char*>(data);
+  return true;
+}
+
+void* ScratchFile::data() const { return data_; }
+
+size_t ScratchFile::size() const { return size_; }
+
+bool ScratchFile::pageRange(size_t* offset, size_t* bytes) const {
+  if (data_ == nullptr || *offset >= size_ || *bytes == 0) return false;
+  size_t page = sysconf(_SC_PAGESIZE);
+  size_t end = std::min(*offset + *bytes, size_);
+  *offset -= *offset % page;
+  *bytes = end - *offset;
+  return true;
+}
+
+void ScratchFile::willNeed(size_t offset, size_t bytes) {
+  if (pageRange(&offset, &bytes)) {
+    madvise(data_ + offset, bytes, MADV_WILLNEED);
+  }
+}
+
+void ScratchFile::dontNeed(size_t offset, size_t bytes) {
+  if (!pageRange(&offset, &bytes)) return;
+  madvise(data_ + offset, bytes, MADV_DONTNEED);
+#if defined(__linux__)
+  // pages are dropped from the page cache too once they are written back
+  posix_fadvise(fd_, offset, bytes, POSIX_FADV_DONTNEED);
+#endif
+}
+
+bool ScratchFile::isResident(size_t offset, size_t bytes) const {
+  if (!pageRange(&offset, &bytes)) return true;
+  size_t page = sysconf(_SC_PAGESIZE);
+#if defined(__linux__)
+  std::vector<unsigned char> pages((bytes + page - 1) / page);
+#else
+  std::vector<char> pages((bytes + page - 1) / page);
+#endif
+  if (mincore(data_ + offset, bytes, pages.data()) != 0) return false;
+  for (auto flags : pages) {
+    if (!(flags & 1)) return false;
+  }
+  return true;
+}
@@ -1,5 +1,58 @@
 #include "settings.h"
 
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <sstream>
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+namespace {
+bool validSize(float size) {
+  return std::isfinite(size) && size >= 1.0f && size <= SETTINGS_MAX_SIZE;
+}
+
+bool readColor(std::istringstream& values, Vector3* color) {
+  float r, g, b;
+  if (!(values >> r >> g >> b)) return false;
+  if (!(r >= 0.0f && r <= 1.0f && g >= 0.0f && g <= 1.0f && b >= 0.0f &&
+        b <= 1.0f))
+    return false;
+  color->r() = r;
+  color->g() = g;
+  color->b() = b;
+  return true;
+}
+
+void writeColor(std::ostringstream& text, const char* key, Vector3 color) {
+  text << key << ' ' << color.r() << ' ' << color.g() << ' ' << color.b()
+       << '\n';
+}
+
+// the file is replaced with rename, so readers see the old or the new one
+bool writeAtomically(const std::string& path, const std::string& content) {
+  std::string temp_path = path + ".tmp";
+  FILE* output = fopen(temp_path.c_str(), "wb");
+  if (output == NULL) return false;
+  bool written =
+      fwrite(content.data(), 1, content.size(), output) == content.size() &&
+      fflush(output) == 0;
+#if !defined(_WIN32)
+  written = written && fsync(fileno(output)) == 0;
+#endif
+  written = fclose(output) == 0 && written;
+  std::error_code error;
+  if (written) std::filesystem::rename(temp_path, path, error);
+  if (!written || error) {
+    remove(temp_path.c_str());
+    return false;
+  }
+  return true;
+}
+}  // namespace
+
 void Settings::setProjectionType(v_settings_projection_types type) {
   projection_type = type;
 };
@@ -38,9 +91,9 @@ Vector3 Settings::getBackgroundColor() { return background_color; }
 
 void Settings::setLineColorR(float color) { line_color.r() = color; };
 
-void Settings::setLineColorG(float color) { line_color.r() = color; };
+void Settings::setLineColorG(float color) { line_color.g() = color; };
 
-void Settings::setLineColorB(float color) { line_color.r() = color; };
+void Settings::setLineColorB(float color) { line_color.b() = color; };
 
 Vector3 Settings::getLineColor() { return line_color; }
 
@@ -72,25 +125,88 @@ v_settings_vertex_display_types Settings::getDisplayType() {
   return display_type;
 }
 
+std::string Settings::serialize() {
+  std::ostringstream text;
+  text.precision(9);  // floats are read back exactly
+  text << SETTINGS_FORMAT_NAME << ' ' << SETTINGS_FORMAT_VERSION << '\n';
+  text << "projection_type " << projection_type << '\n';
+  text << "line_type " << line_type << '\n';
+  text << "line_width " << line_width << '\n';
+  text << "vertex_size " << vertex_size << '\n';
+  text << "display_type " << display_type << '\n';
+  writeColor(text, "background_color", background_color);
+  writeColor(text, "line_color", line_color);
+  writeColor(text, "vertices_color", vertices_color);
+  return text.str();
+}
+
+bool Settings::deserialize(const std::string& text) {
+  std::istringstream lines(text);
+  std::string line, name;
+  int version = 0;
+  if (!std::getline(lines, line)) return false;
+  std::istringstream header(line);
+  if (!(header >> name >> version) || name != SETTINGS_FORMAT_NAME ||
+      version < 1 || version > SETTINGS_FORMAT_VERSION)
+    return false;
+
+  Settings result = *this;
+  while (std::getline(lines, line)) {
+    std::istringstream values(line);
+    std::string key;
+    if (!(values >> key)) continue;
+    int type = 0;
+    float size = 0.0f;
+    bool valid = true;
+    if (key == "projection_type") {
+      valid = values >> type && type >= v_settings_projection_parallel &&
+              type <= v_settings_projection_central;
+      result.projection_type = (v_settings_projection_types)type;
+    } else if (key == "line_type") {
+      valid = values >> type && type >= v_settings_line_dotted &&
+              type <= v_settings_line_solid;
+      result.line_type = (v_settings_line_types)type;
+    } else if (key == "display_type") {
+      valid = values >> type && type >= v_settings_vertex_display_no &&
+              type <= v_settings_vertex_display_square;
+      result.display_type = (v_settings_vertex_display_types)type;
+    } else if (key == "line_width") {
+      valid = values >> size && validSize(size);
+      result.line_width = size;
+    } else if (key == "vertex_size") {
+      valid = values >> size && validSize(size);
+      result.vertex_size = size;
+    } else if (key == "background_color") {
+      valid = readColor(values, &result.background_color);
+    } else if (key == "line_color") {
+      valid = readColor(values, &result.line_color);
+    } else if (key == "vertices_color") {
+      valid = readColor(values, &result.vertices_color);
+    }
+    if (!valid) return false;
+  }
+  result.error_code = error_code;
+  *this = result;
+  return true;
+}
+
 void Settings::uploadSettings(const std::string& settings_file_path) {
   FILE* input = fopen(settings_file_path.c_str(), "rb");
+  std::string text;
   if (input != NULL) {
-    Settings tempSettings;
-    if (fread(&tempSettings, sizeof(Settings), 1, input) >= 1) {
-      *this = tempSettings;
+    char buffer[4096];
+    size_t count;
+    while ((count = fread(buffer, 1, sizeof(buffer), input)) > 0) {
+      text.append(buffer, count);
     }
     fclose(input);
-  } else {
-    initSettings();
   }
+  // files of other versions, or of the old binary format, give defaults
+  if (!deserialize(text)) initSettings();
 }
 
 void Settings::saveSettings(const std::string& settings_file_path) {
-  FILE* output = fopen(settings_file_path.c_str(), "wb");
-  if (output != NULL) {
-    fwrite(this, sizeof(*this), 1, output);
-    fclose(output);
-  } else {
+  if (!writeAtomically(settings_file_path, serialize())) {
     error_code = v_settings_CANT_WRITE;
   }
 }
@@ -0,0 +1,78 @@
+#include "settings_store.h"
+
+#include <algorithm>
+
+#include "tracer.h"
+
+SettingsStore::SettingsStore(const std::string& settings_file_path,
+                             int delay_ms, int max_delay_ms)
+    : path_(settings_file_path),
+      delay_(std::chrono::milliseconds(std::max(delay_ms, 0))),
+      max_delay_(std::chrono::milliseconds(std::max(max_delay_ms, 0))),
+      thread_(&SettingsStore::run, this) {}
+
+SettingsStore::~SettingsStore() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  changed_.notify_all();
+  thread_.join();
+}
+
+void SettingsStore::save(const Settings& settings) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Clock::time_point now = Clock::now();
+    if (!has_pending_) first_save_ = now;
+    pending_ = settings;
+    has_pending_ = true;
+    deadline_ = std::min(now + delay_, first_save_ + max_delay_);
+  }
+  changed_.notify_all();
+}
+
+void SettingsStore::flush() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  ++flushes_waiting_;
+  changed_.notify_all();
+  written_.wait(lock, [this]() { return !has_pending_ && !writing_; });
+  --flushes_waiting_;
+}
+
+v_settings_error_codes SettingsStore::getError() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return error_;
+}
+
+size_t SettingsStore::getWritesCount() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return writes_count_;
+}
+
+void SettingsStore::run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    changed_.wait(lock, [this]() { return stop_ || has_pending_; });
+    if (!has_pending_) break;
+    // new saves move the deadline, flush and stop write at once
+    while (!stop_ && flushes_waiting_ == 0 && Clock::now() < deadline_) {
+      changed_.wait_until(lock, deadline_);
+    }
+
+    Settings settings = pending_;
+    has_pending_ = false;
+    writing_ = true;
+    lock.unlock();
+    {
+      TRACE_SCOPE("SettingsStore::write");
+      settings.clearError();
+      settings.saveSettings(path_);
+    }
+    lock.lock();
+    writing_ = false;
+    error_ = settings.getError();
+    ++writes_count_;
+    written_.notify_all();
+  }
+}
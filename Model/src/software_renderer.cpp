@@ -0,0 +1,498 @@
+#include "software_renderer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+
+#include "task_scheduler.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+const int kTile = SOFTWARE_RENDERER_TILE_SIZE;
+const float kMinW = 1e-6f;
+
+inline float saturate(float value) {
+  return std::min(std::max(value, 0.0f), 1.0f);
+}
+
+inline void blend(float* r, float* g, float* b, int index,
+                  const float* color, float coverage) {
+  r[index] += (color[0] - r[index]) * coverage;
+  g[index] += (color[1] - g[index]) * coverage;
+  b[index] += (color[2] - b[index]) * coverage;
+}
+
+// floor and ceil of values in the range of int, without calls to libm
+inline int floorToInt(float value) {
+  int result = (int)value;
+  return result - (result > value);
+}
+
+inline int ceilToInt(float value) {
+  int result = (int)value;
+  return result + (result < value);
+}
+
+inline bool stippled(unsigned int pattern, float distance) {
+  return pattern && !((pattern >> ((int)std::floor(distance) & 15)) & 1);
+}
+
+#if defined(__SSE2__)
+inline __m128 saturate(__m128 value) {
+  return _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+}
+
+inline __m128 absolute(__m128 value) {
+  return _mm_andnot_ps(_mm_set1_ps(-0.0f), value);
+}
+
+inline void blend(float* plane, int index, float color, __m128 coverage) {
+  __m128 dst = _mm_loadu_ps(plane + index);
+  dst = _mm_add_ps(dst,
+                   _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(color), dst), coverage));
+  _mm_storeu_ps(plane + index, dst);
+}
+#endif
+}  // namespace
+
+SoftwareRenderer::SoftwareRenderer(int width, int height, int threads_count)
+    : width_(std::max(width, 1)),
+      height_(std::max(height, 1)),
+      threads_count_(threads_count) {
+  if (threads_count_ <= 0) {
+    threads_count_ = TaskScheduler::instance().getThreadsCount();
+  }
+  tiles_x_ = (width_ + kTile - 1) / kTile;
+  tiles_y_ = (height_ + kTile - 1) / kTile;
+  segments_.resize(threads_count_);
+  markers_.resize(threads_count_);
+  segment_bins_.assign(threads_count_, std::vector<std::vector<uint32_t>>(
+                                           tiles_x_ * tiles_y_));
+  marker_bins_ = segment_bins_;
+  pixels_.resize((size_t)width_ * height_ * 3);
+  setStyle(SoftwareRenderStyle());
+}
+
+void SoftwareRenderer::setStyle(const SoftwareRenderStyle& style) {
+  style_ = style;
+  half_width_ = std::max(style.line_width, 1.0f) * 0.5f + 0.5f;
+}
+
+void SoftwareRenderer::render(const Vector3* vertices, size_t vertices_count,
+                              const unsigned int* indices,
+                              size_t indices_count,
+                              v_software_primitives primitive,
+                              const Matrix4x4& mvp) {
+  pixels_.resize((size_t)width_ * height_ * 3);
+  for (int t = 0; t < threads_count_; ++t) {
+    segments_[t].clear();
+    markers_[t].clear();
+    for (std::vector<uint32_t>& bin : segment_bins_[t]) bin.clear();
+    for (std::vector<uint32_t>& bin : marker_bins_[t]) bin.clear();
+  }
+
+  const float* m = &mvp(0, 0);
+  clip_.resize(vertices_count);
+  parallelFor(vertices_count, [&](size_t, size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) {
+      float x = vertices[i].x(), y = vertices[i].y(), z = vertices[i].z();
+      clip_[i] = Vector4(m[0] * x + m[1] * y + m[2] * z + m[3],
+                         m[4] * x + m[5] * y + m[6] * z + m[7],
+                         m[8] * x + m[9] * y + m[10] * z + m[11],
+                         m[12] * x + m[13] * y + m[14] * z + m[15]);
+    }
+  });
+
+  size_t corners = primitive == v_software_triangles ? 3 : 2;
+  parallelFor(indices_count / corners, [&](size_t t, size_t first,
+                                           size_t last) {
+    std::vector<Segment>& segments = segments_[t];
+    for (size_t p = first; p < last; ++p) {
+      const unsigned int* corner = indices + p * corners;
+      if (std::any_of(corner, corner + corners, [&](unsigned int index) {
+            return index >= vertices_count;
+          }))
+        continue;
+      size_t begin = segments.size();
+      for (size_t i = 0; i < corners; ++i) {
+        // a line has a single edge, a triangle has three
+        if (corners == 2 && i == 1) break;
+        clipLine(clip_[corner[i]], clip_[corner[(i + 1) % corners]],
+                 segments);
+      }
+      for (size_t i = begin; i < segments.size(); ++i) {
+        binSegment(segments[i], (uint32_t)i, segment_bins_[t]);
+      }
+    }
+  });
+
+  if (style_.point_size > 0.0f) {
+    float radius = std::max(style_.point_size, 1.0f) * 0.5f + 0.5f;
+    parallelFor(vertices_count, [&](size_t t, size_t first, size_t last) {
+      std::vector<Marker>& markers = markers_[t];
+      for (size_t i = first; i < last; ++i) {
+        size_t begin = markers.size();
+        projectMarker(clip_[i], markers);
+        if (markers.size() == begin) continue;
+        const Marker& marker = markers.back();
+        binRect(marker.x - radius, marker.y - radius, marker.x + radius,
+                marker.y + radius, (uint32_t)begin, marker_bins_[t]);
+      }
+    });
+  }
+
+  // tiles are taken one by one, so dense tiles do not stall one thread
+  int tiles_count = tiles_x_ * tiles_y_;
+  int threads = std::min(threads_count_, tiles_count);
+  std::atomic<int> next_tile(0);
+  auto draw = [&]() {
+    std::unique_ptr<TileBuffer> buffer(new TileBuffer);
+    for (int tile = next_tile++; tile < tiles_count; tile = next_tile++) {
+      drawTile(tile, *buffer);
+    }
+  };
+  TaskScheduler::instance().parallelFor(0, threads, 1, [&](size_t first,
+                                                           size_t last) {
+    for (size_t t = first; t < last; ++t) draw();
+  });
+}
+
+int SoftwareRenderer::getWidth() const { return width_; }
+
+int SoftwareRenderer::getHeight() const { return height_; }
+
+size_t SoftwareRenderer::getLinesCount() const {
+  size_t count = 0;
+  for (const std::vector<Segment>& segments : segments_) {
+    count += segments.size();
+  }
+  return count;
+}
+
+const std::vector<unsigned char>& SoftwareRenderer::getPixels() const {
+  return pixels_;
+}
+
+std::vector<unsigned char> SoftwareRenderer::takePixels() {
+  return std::move(pixels_);
+}
+
+template <typename Job>
+void SoftwareRenderer::parallelFor(size_t count, Job job) {
+  size_t threads = threads_count_;
+  if (count < SOFTWARE_RENDERER_MIN_PARALLEL_ITEMS) threads = 1;
+  size_t chunk = (count + threads - 1) / threads;
+  // a part keeps its range and buffers whichever thread runs it
+  TaskScheduler::instance().parallelFor(0, threads, 1, [&](size_t first_part,
+                                                           size_t last_part) {
+    for (size_t t = first_part; t < last_part; ++t) {
+      size_t first = std::min(t * chunk, count);
+      job(t, first, std::min(first + chunk, count));
+    }
+  });
+}
+
+void SoftwareRenderer::clipLine(const Vector4& a, const Vector4& b,
+                                std::vector<Segment>& segments) const {
+  // x and y are clipped a bit outside of the viewport, so wide lines
+  // crossing its border keep their full width
+  float guard_x = 1.0f + 2.0f * (half_width_ + 1.0f) / width_;
+  float guard_y = 1.0f + 2.0f * (half_width_ + 1.0f) / height_;
+  auto distances = [&](const Vector4& v, float* d) {
+    d[0] = guard_x * v.w() + v.x();
+    d[1] = guard_x * v.w() - v.x();
+    d[2] = guard_y * v.w() + v.y();
+    d[3] = guard_y * v.w() - v.y();
+    d[4] = v.w() + v.z();
+    d[5] = v.w() - v.z();
+    d[6] = v.w() - kMinW;
+  };
+  float da[7], db[7];
+  distances(a, da);
+  distances(b, db);
+  float t0 = 0.0f, t1 = 1.0f;
+  for (int plane = 0; plane < 7; ++plane) {
+    if (da[plane] < 0.0f && db[plane] < 0.0f) return;
+    if (da[plane] < 0.0f) {
+      t0 = std::max(t0, da[plane] / (da[plane] - db[plane]));
+    } else if (db[plane] < 0.0f) {
+      t1 = std::min(t1, da[plane] / (da[plane] - db[plane]));
+    }
+  }
+  if (t0 > t1) return;
+
+  auto toScreen = [this](const Vector4& v, float t, const Vector4& to,
+                         float* x, float* y) {
+    float w = v.w() + (to.w() - v.w()) * t;
+    *x = ((v.x() + (to.x() - v.x()) * t) / w + 1.0f) * 0.5f * width_;
+    *y = (1.0f - (v.y() + (to.y() - v.y()) * t) / w) * 0.5f * height_;
+  };
+  Segment segment;
+  toScreen(a, t0, b, &segment.x0, &segment.y0);
+  toScreen(a, t1, b, &segment.x1, &segment.y1);
+  segment.distance = 0.0f;
+  if (t0 > 0.0f && a.w() > kMinW) {
+    float x, y;
+    toScreen(a, 0.0f, b, &x, &y);
+    segment.distance = std::hypot(segment.x0 - x, segment.y0 - y);
+  }
+  segments.push_back(segment);
+}
+
+void SoftwareRenderer::projectMarker(const Vector4& v,
+                                     std::vector<Marker>& markers) const {
+  float w = v.w();
+  if (w <= kMinW || std::fabs(v.z()) > w) return;
+  Marker marker = {(v.x() / w + 1.0f) * 0.5f * width_,
+                   (1.0f - v.y() / w) * 0.5f * height_};
+  float radius = std::max(style_.point_size, 1.0f) * 0.5f + 0.5f;
+  if (marker.x < -radius || marker.y < -radius ||
+      marker.x > width_ + radius || marker.y > height_ + radius)
+    return;
+  markers.push_back(marker);
+}
+
+void SoftwareRenderer::binRect(float left, float top, float right,
+                               float bottom, uint32_t index,
+                               std::vector<std::vector<uint32_t>>& bins) const {
+  int tx0 = std::max(0, (int)std::floor(left / kTile));
+  int ty0 = std::max(0, (int)std::floor(top / kTile));
+  int tx1 = std::min(tiles_x_ - 1, (int)std::floor(right / kTile));
+  int ty1 = std::min(tiles_y_ - 1, (int)std::floor(bottom / kTile));
+  for (int ty = ty0; ty <= ty1; ++ty) {
+    for (int tx = tx0; tx <= tx1; ++tx) {
+      bins[ty * tiles_x_ + tx].push_back(index);
+    }
+  }
+}
+
+void SoftwareRenderer::binSegment(
+    const Segment& segment, uint32_t index,
+    std::vector<std::vector<uint32_t>>& bins) const {
+  float left = std::min(segment.x0, segment.x1) - half_width_;
+  float right = std::max(segment.x0, segment.x1) + half_width_;
+  float top = std::min(segment.y0, segment.y1) - half_width_;
+  float bottom = std::max(segment.y0, segment.y1) + half_width_;
+  int tx0 = std::max(0, (int)std::floor(left / kTile));
+  int ty0 = std::max(0, (int)std::floor(top / kTile));
+  int tx1 = std::min(tiles_x_ - 1, (int)std::floor(right / kTile));
+  int ty1 = std::min(tiles_y_ - 1, (int)std::floor(bottom / kTile));
+  if (tx0 > tx1 || ty0 > ty1) return;
+
+  float dx = segment.x1 - segment.x0, dy = segment.y1 - segment.y0;
+  float length = std::sqrt(dx * dx + dy * dy);
+  // diagonal lines skip tiles of their bounding box which they miss
+  float reach = half_width_ + kTile * 0.70711f;
+  for (int ty = ty0; ty <= ty1; ++ty) {
+    for (int tx = tx0; tx <= tx1; ++tx) {
+      if (length > 1.0f) {
+        float cx = (tx + 0.5f) * kTile - segment.x0;
+        float cy = (ty + 0.5f) * kTile - segment.y0;
+        if (std::fabs(cx * dy - cy * dx) > reach * length) continue;
+      }
+      bins[ty * tiles_x_ + tx].push_back(index);
+    }
+  }
+}
+
+void SoftwareRenderer::drawTile(int tile, TileBuffer& buffer) {
+  int tile_x = (tile % tiles_x_) * kTile;
+  int tile_y = (tile / tiles_x_) * kTile;
+  int tile_width = std::min(kTile, width_ - tile_x);
+  int tile_height = std::min(kTile, height_ - tile_y);
+
+  std::fill(buffer.r, buffer.r + kTile * kTile, style_.background_color.r());
+  std::fill(buffer.g, buffer.g + kTile * kTile, style_.background_color.g());
+  std::fill(buffer.b, buffer.b + kTile * kTile, style_.background_color.b());
+  for (int t = 0; t < threads_count_; ++t) {
+    for (uint32_t index : segment_bins_[t][tile]) {
+      drawSegment(segments_[t][index], tile_x, tile_y, tile_width,
+                  tile_height, buffer);
+    }
+  }
+  // vertices are drawn over the lines, as points after edges in GL
+  for (int t = 0; t < threads_count_; ++t) {
+    for (uint32_t index : marker_bins_[t][tile]) {
+      drawMarker(markers_[t][index], tile_x, tile_y, tile_width, tile_height,
+                 buffer);
+    }
+  }
+
+  for (int row = 0; row < tile_height; ++row) {
+    unsigned char* out =
+        pixels_.data() + ((size_t)(tile_y + row) * width_ + tile_x) * 3;
+    for (int col = 0; col < tile_width; ++col) {
+      int index = row * kTile + col;
+      // rounding to nearest, like conversion to unsigned normalized in GL
+      out[col * 3] =
+          (unsigned char)(saturate(buffer.r[index]) * 255.0f + 0.5f);
+      out[col * 3 + 1] =
+          (unsigned char)(saturate(buffer.g[index]) * 255.0f + 0.5f);
+      out[col * 3 + 2] =
+          (unsigned char)(saturate(buffer.b[index]) * 255.0f + 0.5f);
+    }
+  }
+}
+
+void SoftwareRenderer::drawSegment(const Segment& segment, int tile_x,
+                                   int tile_y, int tile_width, int tile_height,
+                                   TileBuffer& buffer) const {
+  float dx = segment.x1 - segment.x0, dy = segment.y1 - segment.y0;
+  float length = std::sqrt(dx * dx + dy * dy);
+  float ux = 1.0f, uy = 0.0f;
+  if (length > 1e-6f) {
+    ux = dx / length;
+    uy = dy / length;
+  }
+  float left = std::min(segment.x0, segment.x1) - half_width_;
+  float right = std::max(segment.x0, segment.x1) + half_width_;
+  float top = std::min(segment.y0, segment.y1) - half_width_;
+  float bottom = std::max(segment.y0, segment.y1) + half_width_;
+  if (std::fabs(dx) > std::fabs(dy)) {
+    // shallow lines cross the tile within a band of few rows
+    float slope = dy / dx;
+    float y_left = segment.y0 + (tile_x - half_width_ - segment.x0) * slope;
+    float y_right = segment.y0 +
+                    (tile_x + tile_width + half_width_ - segment.x0) * slope;
+    float margin = half_width_ * length / std::fabs(dx);
+    top = std::max(top, std::min(y_left, y_right) - margin);
+    bottom = std::min(bottom, std::max(y_left, y_right) + margin);
+  }
+  int row_first = std::max(tile_y, ceilToInt(top - 0.5f));
+  int row_last =
+      std::min(tile_y + tile_height - 1, floorToInt(bottom - 0.5f));
+  // components are read once, accessors of Vector3 are not inline
+  Vector3 line_color = style_.line_color;
+  const float color[3] = {line_color.r(), line_color.g(), line_color.b()};
+  unsigned int pattern = style_.stipple_pattern & 0xFFFF;
+  // steep lines cover few pixels per row, so the row setup avoids divisions
+  bool has_uy = std::fabs(uy) > 1e-6f, has_ux = std::fabs(ux) > 1e-6f;
+  float inv_uy = has_uy ? 1.0f / uy : 0.0f;
+  float inv_ux = has_ux ? 1.0f / ux : 0.0f;
+
+  for (int row = row_first; row <= row_last; ++row) {
+    float ry = row + 0.5f - segment.y0;
+    // columns where the pixel is within half width across and along the line
+    float lo = left, hi = right;
+    if (has_uy) {
+      float a = (ux * ry - half_width_) * inv_uy;
+      float b = (ux * ry + half_width_) * inv_uy;
+      lo = std::max(lo, std::min(a, b) + segment.x0);
+      hi = std::min(hi, std::max(a, b) + segment.x0);
+    }
+    if (has_ux) {
+      float a = (-0.5f - uy * ry) * inv_ux;
+      float b = (length + 0.5f - uy * ry) * inv_ux;
+      lo = std::max(lo, std::min(a, b) + segment.x0);
+      hi = std::min(hi, std::max(a, b) + segment.x0);
+    }
+    lo = std::max(lo, tile_x - 1.0f);
+    hi = std::min(hi, tile_x + tile_width + 1.0f);
+    int col = std::max(tile_x, ceilToInt(lo - 0.5f));
+    int col_last = std::min(tile_x + tile_width - 1, floorToInt(hi - 0.5f));
+    int base = (row - tile_y) * kTile - tile_x;
+
+#if defined(__SSE2__)
+    const __m128 lane = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+    const __m128 vux = _mm_set1_ps(ux), vuy = _mm_set1_ps(uy);
+    const __m128 across_ry = _mm_set1_ps(ux * ry);
+    const __m128 along_ry = _mm_set1_ps(uy * ry);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 width = _mm_set1_ps(half_width_);
+    const __m128 end = _mm_set1_ps(length + 0.5f);
+    // rows of steep lines are a few pixels wide, so the last group of four
+    // is masked instead of being drawn by the scalar loop
+    for (; col <= col_last; col += 4) {
+      __m128 px = _mm_add_ps(_mm_set1_ps(col + 0.5f - segment.x0), lane);
+      __m128 along = _mm_add_ps(_mm_mul_ps(vux, px), along_ry);
+      __m128 across = absolute(_mm_sub_ps(across_ry, _mm_mul_ps(vuy, px)));
+      __m128 coverage = _mm_mul_ps(
+          saturate(_mm_sub_ps(width, across)),
+          _mm_mul_ps(saturate(_mm_add_ps(along, half)),
+                     saturate(_mm_sub_ps(end, along))));
+      if (col + 3 > col_last) {
+        coverage = _mm_and_ps(
+            coverage, _mm_cmple_ps(lane, _mm_set1_ps(col_last - col)));
+      }
+      if (pattern) {
+        alignas(16) float values[4], distances[4];
+        _mm_store_ps(values, coverage);
+        _mm_store_ps(distances, along);
+        for (int i = 0; i < 4; ++i) {
+          if (stippled(pattern, segment.distance + distances[i])) {
+            values[i] = 0.0f;
+          }
+        }
+        coverage = _mm_load_ps(values);
+      }
+      blend(buffer.r, base + col, color[0], coverage);
+      blend(buffer.g, base + col, color[1], coverage);
+      blend(buffer.b, base + col, color[2], coverage);
+    }
+#endif
+    for (; col <= col_last; ++col) {
+      float px = col + 0.5f - segment.x0;
+      float along = ux * px + uy * ry;
+      float across = std::fabs(ux * ry - uy * px);
+      float coverage = saturate(half_width_ - across) *
+                       saturate(along + 0.5f) *
+                       saturate(length + 0.5f - along);
+      if (stippled(pattern, segment.distance + along)) coverage = 0.0f;
+      blend(buffer.r, buffer.g, buffer.b, base + col, color, coverage);
+    }
+  }
+}
+
+void SoftwareRenderer::drawMarker(const Marker& marker, int tile_x,
+                                  int tile_y, int tile_width, int tile_height,
+                                  TileBuffer& buffer) const {
+  float radius = std::max(style_.point_size, 1.0f) * 0.5f + 0.5f;
+  int row_first = std::max(tile_y, (int)std::ceil(marker.y - radius - 0.5f));
+  int row_last = std::min(tile_y + tile_height - 1,
+                          (int)std::floor(marker.y + radius - 0.5f));
+  int col_first = std::max(tile_x, (int)std::ceil(marker.x - radius - 0.5f));
+  int col_last = std::min(tile_x + tile_width - 1,
+                          (int)std::floor(marker.x + radius - 0.5f));
+  Vector3 vertex_color = style_.vertex_color;
+  const float color[3] = {vertex_color.r(), vertex_color.g(),
+                          vertex_color.b()};
+
+  for (int row = row_first; row <= row_last; ++row) {
+    float ry = row + 0.5f - marker.y;
+    int base = (row - tile_y) * kTile - tile_x;
+    int col = col_first;
+#if defined(__SSE2__)
+    const __m128 lane = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+    const __m128 vradius = _mm_set1_ps(radius);
+    const __m128 vry = _mm_set1_ps(ry);
+    for (; col + 3 <= col_last; col += 4) {
+      __m128 px = _mm_add_ps(_mm_set1_ps(col + 0.5f - marker.x), lane);
+      __m128 coverage;
+      if (style_.round_points) {
+        __m128 distance = _mm_sqrt_ps(
+            _mm_add_ps(_mm_mul_ps(px, px), _mm_mul_ps(vry, vry)));
+        coverage = saturate(_mm_sub_ps(vradius, distance));
+      } else {
+        coverage = _mm_mul_ps(saturate(_mm_sub_ps(vradius, absolute(px))),
+                              saturate(_mm_sub_ps(vradius, absolute(vry))));
+      }
+      blend(buffer.r, base + col, color[0], coverage);
+      blend(buffer.g, base + col, color[1], coverage);
+      blend(buffer.b, base + col, color[2], coverage);
+    }
+#endif
+    for (; col <= col_last; ++col) {
+      float px = col + 0.5f - marker.x;
+      float coverage =
+          style_.round_points
+              ? saturate(radius - std::sqrt(px * px + ry * ry))
+              : saturate(radius - std::fabs(px)) *
+                    saturate(radius - std::fabs(ry));
+      blend(buffer.r, buffer.g, buffer.b, base + col, color, coverage);
+    }
+  }
+}
@@ -0,0 +1,271 @@
+#include "task_scheduler.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+
+#include "profiler.h"
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+// index of the deque of the current thread, the last one for non-workers
+thread_local size_t current_queue = SIZE_MAX;
+
+// cgroup of the process in the unified hierarchy, empty if unknown
+std::string cgroupPath() {
+  std::ifstream file("/proc/self/cgroup");
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.compare(0, 3, "0::") == 0) return line.substr(3);
+  }
+  return std::string();
+}
+
+#if defined(__linux__)
+// CPUs of the list, or all CPUs of the process for an empty list
+bool makeCpuSet(const std::vector<int>& cpus, cpu_set_t* set) {
+  CPU_ZERO(set);
+  if (cpus.empty()) return sched_getaffinity(0, sizeof(*set), set) == 0;
+  for (int cpu : cpus) {
+    if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, set);
+  }
+  return CPU_COUNT(set) > 0;
+}
+#endif
+}  // namespace
+
+TaskScheduler::TaskScheduler() {
+  size_t threads_count = 0;
+  const char* value = getenv(TASK_SCHEDULER_THREADS_ENV);
+  if (value != nullptr) threads_count = strtoul(value, nullptr, 10);
+  start(threads_count);
+}
+
+TaskScheduler::~TaskScheduler() { stop(); }
+
+TaskScheduler& TaskScheduler::instance() {
+  static TaskScheduler scheduler;
+  return scheduler;
+}
+
+void TaskScheduler::setThreadsCount(size_t threads_count) {
+  {
+    // queues are rebuilt only when no group may touch them
+    std::unique_lock<std::mutex> lock(groups_mutex_);
+    groups_idle_.wait(lock, [this]() { return groups_ == 0 && !resizing_; });
+    resizing_ = true;
+  }
+  stop();
+  start(threads_count);
+  {
+    std::lock_guard<std::mutex> lock(groups_mutex_);
+    resizing_ = false;
+  }
+  groups_idle_.notify_all();
+}
+
+size_t TaskScheduler::getThreadsCount() const { return threads_count_; }
+
+void TaskScheduler::start(size_t threads_count) {
+  if (threads_count == 0) threads_count = availableConcurrency();
+  threads_count_ = threads_count;
+  stop_ = false;
+  queues_.clear();
+  for (size_t i = 0; i < threads_count_; ++i) {
+    queues_.emplace_back(new Queue);
+  }
+  for (size_t i = 0; i + 1 < threads_count_; ++i) {
+    workers_.emplace_back(&TaskScheduler::workerLoop, this, i);
+    applyAffinity(workers_.back());
+  }
+}
+
+void TaskScheduler::stop() {
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    stop_ = true;
+  }
+  wake_.notify_all();
+  for (std::thread& worker : workers_) worker.join();
+  workers_.clear();
+}
+
+bool TaskScheduler::setAffinity(const std::vector<int>& cpus) {
+  cpus_ = cpus;
+  bool ok = true;
+  for (std::thread& worker : workers_) ok = applyAffinity(worker) && ok;
+  return ok;
+}
+
+bool TaskScheduler::applyAffinity(std::thread& thread) {
+#if defined(__linux__)
+  cpu_set_t set;
+  return makeCpuSet(cpus_, &set) &&
+         pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set) ==
+             0;
+#else
+  (void)thread;
+  return cpus_.empty();
+#endif
+}
+
+size_t TaskScheduler::availableConcurrency() {
+  size_t count = std::max(1u, std::thread::hardware_concurrency());
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) == 0 && CPU_COUNT(&set) > 0) {
+    count = std::min(count, (size_t)CPU_COUNT(&set));
+  }
+  // containers limit CPU time by quota, not by visible CPUs
+  double quota = 0.0;
+  std::string path = cgroupPath();
+  if (!path.empty()) quota = readCgroupQuota("/sys/fs/cgroup" + path);
+  if (quota <= 0.0) quota = readCgroupQuota("/sys/fs/cgroup");
+  if (quota <= 0.0) quota = readCgroupQuota("/sys/fs/cgroup/cpu");
+  if (quota > 0.0) {
+    count = std::min(count, std::max<size_t>(1, (size_t)std::ceil(quota)));
+  }
+#endif
+  return count;
+}
+
+double TaskScheduler::readCgroupQuota(const std::string& cgroup_dir) {
+  double quota = 0.0, period = 0.0;
+  std::ifstream max_file(cgroup_dir + "/cpu.max");
+  std::string value;
+  if (max_file >> value >> period) {
+    // "max PERIOD" means no quota
+    if (value != "max") quota = strtod(value.c_str(), nullptr);
+  } else {
+    std::ifstream quota_file(cgroup_dir + "/cpu.cfs_quota_us");
+    std::ifstream period_file(cgroup_dir + "/cpu.cfs_period_us");
+    // quota of -1 means no quota
+    if (!(quota_file >> quota) || !(period_file >> period)) quota = 0.0;
+  }
+  return quota > 0.0 && period > 0.0 ? quota / period : 0.0;
+}
+
+TaskSchedulerCounters TaskScheduler::getCounters() const {
+  TaskSchedulerCounters counters;
+  counters.tasks = tasks_;
+  counters.steals = steals_;
+  counters.queue_depth = pending_;
+  counters.max_queue_depth = max_pending_;
+  return counters;
+}
+
+void TaskScheduler::resetCounters() {
+  tasks_ = 0;
+  steals_ = 0;
+  max_pending_ = pending_.load();
+}
+
+void TaskScheduler::submit(Item item) {
+  size_t index = current_queue < queues_.size() - 1 ? current_queue
+                                                    : queues_.size() - 1;
+  {
+    std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+    queues_[index]->items.push_back(std::move(item));
+  }
+  size_t pending = ++pending_;
+  size_t max_pending = max_pending_;
+  while (pending > max_pending &&
+         !max_pending_.compare_exchange_weak(max_pending, pending)) {
+  }
+  // the lock orders the new task before a worker's check of pending_
+  { std::lock_guard<std::mutex> lock(sleep_mutex_); }
+  wake_.notify_one();
+}
+
+bool TaskScheduler::runOne() {
+  size_t count = queues_.size();
+  size_t own = current_queue < count - 1 ? current_queue : count - 1;
+  Item item;
+  bool found = false;
+  {
+    std::lock_guard<std::mutex> lock(queues_[own]->mutex);
+    if (!queues_[own]->items.empty()) {
+      item = std::move(queues_[own]->items.back());
+      queues_[own]->items.pop_back();
+      found = true;
+    }
+  }
+  for (size_t i = 1; !found && i < count; ++i) {
+    Queue& victim = *queues_[(own + i) % count];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.items.empty()) {
+      item = std::move(victim.items.front());
+      victim.items.pop_front();
+      found = true;
+      ++steals_;
+    }
+  }
+  if (!found) return false;
+  --pending_;
+  item.task();
+  ++tasks_;
+  item.group->finish();
+  return true;
+}
+
+void TaskScheduler::workerLoop(size_t index) {
+  current_queue = index;
+  while (true) {
+    if (runOne()) continue;
+    std::unique_lock<std::mutex> lock(sleep_mutex_);
+    wake_.wait(lock, [this]() { return stop_ || pending_ > 0; });
+    if (stop_ && pending_ == 0) break;
+  }
+  current_queue = SIZE_MAX;
+}
+
+TaskGroup::TaskGroup(TaskScheduler& scheduler) : scheduler_(scheduler) {
+  std::unique_lock<std::mutex> lock(scheduler_.groups_mutex_);
+  scheduler_.groups_idle_.wait(lock,
+                               [this]() { return !scheduler_.resizing_; });
+  ++scheduler_.groups_;
+}
+
+TaskGroup::~TaskGroup() {
+  wait();
+  std::lock_guard<std::mutex> lock(scheduler_.groups_mutex_);
+  if (--scheduler_.groups_ == 0) scheduler_.groups_idle_.notify_all();
+}
+
+void TaskGroup::run(TaskScheduler::Task task) {
+  if (scheduler_.workers_.empty()) {
+    task();
+    ++scheduler_.tasks_;
+    return;
+  }
+  ++pending_;
+  scheduler_.submit({std::move(task), this});
+}
+
+void TaskGroup::wait() {
+  while (pending_ > 0) {
+    if (scheduler_.runOne()) continue;
+    // the rest of the tasks runs on other threads
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait_for(lock, std::chrono::milliseconds(1),
+                   [this]() { return pending_ == 0; });
+  }
+  {
+    // the thread of the last task may still hold the mutex
+    std::lock_guard<std::mutex> lock(mutex_);
+  }
+  TaskSchedulerCounters counters = scheduler_.getCounters();
+  Profiler::instance().setCounter(v_profiler_task_queue_depth,
+                                  counters.max_queue_depth);
+  Profiler::instance().setCounter(v_profiler_task_steals, counters.steals);
+}
+
+void TaskGroup::finish() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (--pending_ == 0) done_.notify_all();
+}
@@ -0,0 +1,89 @@
+#include "tracer.h"
+
+#include <fstream>
+
+Tracer::Tracer() : enabled_(false), epoch_(Clock::now()) {}
+
+Tracer &Tracer::instance() {
+  static Tracer tracer;
+  return tracer;
+}
+
+void Tracer::setEnabled(bool enabled) {
+  enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+int64_t Tracer::now() const {
+  return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() -
+                                                               epoch_)
+      .count();
+}
+
+TraceBuffer &Tracer::threadBuffer() {
+  // buffer is shared with tracer so it outlives a finished thread
+  thread_local std::shared_ptr<TraceBuffer> buffer;
+  if (!buffer) {
+    buffer = std::make_shared<TraceBuffer>();
+    buffer->events.resize(TRACER_BUFFER_CAPACITY);
+    std::lock_guard<std::mutex> lock(buffers_mutex_);
+    buffer->thread_id = buffers_.size() + 1;
+    buffers_.push_back(buffer);
+  }
+  return *buffer;
+}
+
+void Tracer::record(const char *name, int64_t start_us, int64_t duration_us) {
+  TraceBuffer &buffer = threadBuffer();
+  std::lock_guard<std::mutex> lock(buffer.mutex);
+  buffer.events[buffer.next] = {name, start_us, duration_us};
+  buffer.next = (buffer.next + 1) % buffer.events.size();
+  if (buffer.next == 0) buffer.wrapped = true;
+}
+
+void Tracer::clear() {
+  std::lock_guard<std::mutex> lock(buffers_mutex_);
+  for (std::shared_ptr<TraceBuffer> &buffer : buffers_) {
+    std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+    buffer->next = 0;
+    buffer->wrapped = false;
+  }
+}
+
+size_t Tracer::eventsCount() {
+  size_t count = 0;
+  std::lock_guard<std::mutex> lock(buffers_mutex_);
+  for (std::shared_ptr<TraceBuffer> &buffer : buffers_) {
+    std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+    count += buffer->wrapped ? buffer->events.size() : buffer->next;
+  }
+  return count;
+}
+
+bool Tracer::dump(const std::string &file_path) {
+  std::ofstream file(file_path);
+  if (!file.is_open()) return false;
+
+  file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+  std::lock_guard<std::mutex> lock(buffers_mutex_);
+  for (std::shared_ptr<TraceBuffer> &buffer : buffers_) {
+    std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+    if (!first) file << ",";
+    first = false;
+    file << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+         << buffer->thread_id << ",\"args\":{\"name\":\"thread "
+         << buffer->thread_id << "\"}}";
+    size_t count = buffer->wrapped ? buffer->events.size() : buffer->next;
+    size_t start = buffer->wrapped ? buffer->next : 0;
+    for (size_t i = 0; i < count; ++i) {
+      const TraceEvent &event =
+          buffer->events[(start + i) % buffer->events.size()];
+      file << ",\n{\"name\":\"" << event.name
+           << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->thread_id
+           << ",\"ts\":" << event.start_us << ",\"dur\":" << event.duration_us
+           << "}";
+    }
+  }
+  file << "\n]}\n";
+  return file.good();
+}
@@ -1,10 +1,27 @@
 #include <gtest/gtest.h>
 
+#include <clocale>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <thread>
+
+#include "capture_sequence.h"
+#include "decompress_buffer.h"
+#include "input_file.h"
+#include "interaction_trace.h"
 #include "matrix_generator.h"
+#include "mesh_pager.h"
 #include "model.h"
 #include "parser.h"
+#include "profiler.h"
+#include "progressive_mesh.h"
 #include "settings.h"
 #include "settings_path.h"
+#include "settings_store.h"
+#include "software_renderer.h"
+#include "task_scheduler.h"
+#include "tracer.h"
 
 #define EPSILON 1e-6
 
@@ -82,17 +99,16 @@ TEST(ParserTest, TestParce2) {
   Model model(&parser);
   model.uploadModel(path);
   model.initModel();
-  Vector4 real_result[] = {{0.475f, -0.475f, -0.475f, 1.0f},
-                                {-0.475f, 0.475f, -0.475f, 1.0f},
-                                {-0.475f, -0.475f, 0.475f, 1.0f}};
+  Vector3 real_result[] = {{0.475f, -0.475f, -0.475f},
+                           {-0.475f, 0.475f, -0.475f},
+                           {-0.475f, -0.475f, 0.475f}};
 
   int error = model.getErrorCode();
   EXPECT_EQ(error, OK);
   for (int i = 0; i < 3; ++i) {
-    EXPECT_NEAR(model.getVertices4d()[i].x(), real_result[i].x(), EPSILON);
-    EXPECT_NEAR(model.getVertices4d()[i].y(), real_result[i].y(), EPSILON);
-    EXPECT_NEAR(model.getVertices4d()[i].z(), real_result[i].z(), EPSILON);
-    EXPECT_NEAR(model.getVertices4d()[i].w(), real_result[i].w(), EPSILON);
+    EXPECT_NEAR(model.getVertices3d()[i].x(), real_result[i].x(), EPSILON);
+    EXPECT_NEAR(model.getVertices3d()[i].y(), real_result[i].y(), EPSILON);
+    EXPECT_NEAR(model.getVertices3d()[i].z(), real_result[i].z(), EPSILON);
   }
 }
 
@@ -194,6 +210,749 @@ TEST(ParserTest, TestParce7) {
   }
 }
 
+TEST(ParserTest, TestParce8) {
+  Vector3 a[] = {{1.0f, 0.0f, -1.5f}, {0.0f, 1.0f, -0.5f}, {0.0f, 0.0f, -1.0f}};
+  Vector4 a4[] = {{1.0f, 0.0f, -1.5f, 1.0f},
+                  {0.0f, 1.0f, -0.5f, 1.0f},
+                  {0.0f, 0.0f, -1.0f, 1.0f}};
+  Matrix4x4 matrix = MatrixGenerator().matrix_mult_4x4(
+      MatrixGenerator().generate_frustrum_matrix(-0.065, 0.065, -0.065, 0.065,
+                                                 0.1, 2.0),
+      MatrixGenerator().generate_XYZaxis_rotation_matrix(0.3f, 0.2f, 0.1f));
+  Vector3 b[3];
+  Vector4 b4[3];
+  MatrixGenerator().f3d_vertex_array_processing(a, b, 3, matrix);
+  MatrixGenerator().f4d_vertex_array_processing(a4, b4, 3, matrix);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_NEAR(b[i].x(), b4[i].x(), EPSILON);
+    EXPECT_NEAR(b[i].y(), b4[i].y(), EPSILON);
+    EXPECT_NEAR(b[i].z(), b4[i].z(), EPSILON);
+  }
+}
+
+TEST(ParserTest, TestParce9) {
+  std::string path = OBJECTS_PATH;
+  path += "/cow.obj";
+  Parser parser;
+  Model model(&parser);
+  // a cancelled load stops with an error
+  model.setLoadCancelled(true);
+  model.uploadModel(path);
+  EXPECT_EQ(model.getErrorCode(), ERROR);
+  EXPECT_EQ(model.getVerticesCount(), 0u);
+  model.setLoadCancelled(false);
+  model.uploadModel(path);
+  EXPECT_EQ(model.getErrorCode(), OK);
+  EXPECT_GT(model.getVerticesCount(), 0u);
+}
+
+TEST(ParserTest, TestParce10) {
+  // loads in background must not change the locale of the process
+  const char* locales[] = {"de_DE.UTF-8", "de_DE", "C.UTF-8"};
+  std::string previous = setlocale(LC_ALL, nullptr);
+  const char* locale = nullptr;
+  for (const char* name : locales) {
+    if (!locale) locale = setlocale(LC_ALL, name);
+  }
+  if (!locale) GTEST_SKIP();
+  std::string current = locale;
+  std::string path =
+      (std::filesystem::temp_directory_path() / "parser_locale.obj").string();
+  std::ofstream(path) << "v 0.5 +1.25 -2.5\nv 1 0 0\nv 0 1 0\nf 1 2 3\n";
+  Parser parser;
+  Model model(&parser);
+  model.uploadModel(path);
+  EXPECT_EQ(setlocale(LC_ALL, nullptr), current);
+  setlocale(LC_ALL, previous.c_str());
+  std::filesystem::remove(path);
+  ASSERT_EQ(model.getErrorCode(), OK);
+  ASSERT_EQ(model.getVerticesCount(), 3u);
+  EXPECT_FLOAT_EQ(model.getVertices3d()[0].x(), 0.5f);
+  EXPECT_FLOAT_EQ(model.getVertices3d()[0].y(), 1.25f);
+  EXPECT_FLOAT_EQ(model.getVertices3d()[0].z(), -2.5f);
+}
+
+TEST(MeshletTest, TestMeshlets1) {
+  std::string path = OBJECTS_PATH;
+  path += "/cow.obj";
+  Parser parser;
+  Model model(&parser);
+  model.uploadModel(path);
+  model.initModel();
+  EXPECT_EQ(model.getErrorCode(), OK);
+
+  const std::vector<Meshlet>& meshlets = model.getMeshlets();
+  ASSERT_FALSE(meshlets.empty());
+  unsigned int next_offset = 0;
+  for (const Meshlet& meshlet : meshlets) {
+    EXPECT_EQ(meshlet.index_offset, next_offset);
+    EXPECT_LE(meshlet.vertex_count, (unsigned int)MESHLET_MAX_VERTICES);
+    EXPECT_LE(meshlet.index_count / 3, (unsigned int)MESHLET_MAX_TRIANGLES);
+    next_offset += meshlet.index_count;
+    for (unsigned int i = 0; i < meshlet.index_count; ++i) {
+      Vector3 v = model.getVertices3d()[model.getIndices()[next_offset -
+                                                           meshlet.index_count +
+                                                           i]];
+      float dx = v.x() - meshlet.center.x();
+      float dy = v.y() - meshlet.center.y();
+      float dz = v.z() - meshlet.center.z();
+      EXPECT_LE(sqrtf(dx * dx + dy * dy + dz * dz), meshlet.radius + EPSILON);
+    }
+  }
+  EXPECT_EQ(next_offset, model.getIndicesCount());
+}
+
+TEST(MeshletTest, TestMeshlets2) {
+  std::string path = OBJECTS_PATH;
+  path += "/cow.obj";
+  Parser parser;
+  Model model(&parser);
+  model.uploadModel(path);
+  model.initModel();
+
+  Matrix4x4 identity = MatrixGenerator().generate_identity();
+  std::vector<IndexRange> ranges =
+      MeshletBuilder::visibleRanges(model.getMeshlets(), identity);
+  ASSERT_EQ(ranges.size(), 1u);
+  EXPECT_EQ(ranges[0].offset, 0u);
+  EXPECT_EQ(ranges[0].count, model.getIndicesCount());
+
+  Matrix4x4 away =
+      MatrixGenerator().generate_translation_matrix({5.0f, 0.0f, 0.0f});
+  EXPECT_TRUE(MeshletBuilder::visibleRanges(model.getMeshlets(), away).empty());
+
+  Matrix4x4 half =
+      MatrixGenerator().generate_translation_matrix({1.0f, 0.0f, 0.0f});
+  std::vector<IndexRange> half_ranges =
+      MeshletBuilder::visibleRanges(model.getMeshlets(), half);
+  EXPECT_FALSE(half_ranges.empty());
+  unsigned int visible = 0;
+  for (const IndexRange& range : half_ranges) visible += range.count;
+  EXPECT_LT(visible, model.getIndicesCount());
+}
+
+TEST(QuantizationTest, TestQuantization1) {
+  std::string path = OBJECTS_PATH;
+  path += "/cow.obj";
+  Parser parser;
+  Model model(&parser);
+  model.uploadModel(path);
+  model.initModel();
+
+  QuantizedPositions positions = model.quantizePositions();
+  ASSERT_EQ(positions.data.size(), model.getVerticesCount() * 3);
+  EXPECT_LE(positions.max_error, 0.5f / QUANTIZATION_MAX_VALUE + EPSILON);
+
+  float max_extent = std::max(
+      std::max(positions.extent.x(), positions.extent.y()),
+      positions.extent.z());
+  Matrix4x4 unpack = PositionQuantizer::dequantizationMatrix(positions);
+  for (size_t i = 0; i < model.getVerticesCount(); ++i) {
+    Vector3 restored = PositionQuantizer::dequantize(positions, i);
+    Vector3 original = model.getVertices3d()[i];
+    EXPECT_NEAR(restored.x(), original.x(), positions.max_error * max_extent);
+    EXPECT_NEAR(restored.y(), original.y(), positions.max_error * max_extent);
+    EXPECT_NEAR(restored.z(), original.z(), positions.max_error * max_extent);
+
+    Vector4 normalized(positions.data[i * 3] / QUANTIZATION_MAX_VALUE,
+                       positions.data[i * 3 + 1] / QUANTIZATION_MAX_VALUE,
+                       positions.data[i * 3 + 2] / QUANTIZATION_MAX_VALUE,
+                       1.0f);
+    Vector4 unpacked =
+        MatrixGenerator().single_f4d_vertex_processing(normalized, unpack);
+    EXPECT_NEAR(unpacked.x(), restored.x(), EPSILON);
+    EXPECT_NEAR(unpacked.y(), restored.y(), EPSILON);
+    EXPECT_NEAR(unpacked.z(), restored.z(), EPSILON);
+  }
+}
+
+TEST(ProfilerTest, TestProfiler1) {
+  Profiler& profiler = Profiler::instance();
+  profiler.reset();
+  for (int i = 1; i <= 100; ++i) profiler.addSample(v_profiler_draw, i);
+  ProfilerStats stats = profiler.getStats(v_profiler_draw);
+  EXPECT_EQ(stats.samples, 100u);
+  EXPECT_NEAR(stats.last, 100.0, EPSILON);
+  EXPECT_NEAR(stats.average, 50.5, EPSILON);
+  EXPECT_NEAR(stats.p50, 50.0, EPSILON);
+  EXPECT_NEAR(stats.p95, 95.0, EPSILON);
+  EXPECT_NEAR(stats.p99, 99.0, EPSILON);
+  EXPECT_EQ(profiler.getStats(v_profiler_gpu).samples, 0u);
+  profiler.setCounter(v_profiler_upload_bandwidth, 512.0);
+  EXPECT_NEAR(profiler.getCounter(v_profiler_upload_bandwidth), 512.0, EPSILON);
+  profiler.reset();
+  EXPECT_NEAR(profiler.getCounter(v_profiler_upload_bandwidth), 0.0, EPSILON);
+}
+
+TEST(ProfilerTest, TestProfiler2) {
+  Profiler& profiler = Profiler::instance();
+  profiler.reset();
+  std::string path = OBJECTS_PATH;
+  path += "/cow.obj";
+  Parser parser;
+  Model model(&parser);
+  model.uploadModel(path);
+  model.initModel();
+  EXPECT_EQ(profiler.getStats(v_profiler_parse).samples, 1u);
+  EXPECT_EQ(profiler.getStats(v_profiler_normalize).samples, 1u);
+  EXPECT_GT(profiler.getStats(v_profiler_parse).last, 0.0);
+}
+
+TEST(CaptureTest, TestCapture1) {
+  CaptureSequence sequence(v_capture_axis_y, 8, Vector3(0.1f, 0.2f, 0.3f));
+  EXPECT_EQ(sequence.getFramesCount(), 8);
+  Vector3 angles = sequence.anglesAt(2);
+  EXPECT_NEAR(angles.x(), 0.1f, EPSILON);
+  EXPECT_NEAR(angles.y(), 0.2f + M_PI / 2.0, 1e-5);
+  EXPECT_NEAR(angles.z(), 0.3f, EPSILON);
+  EXPECT_NEAR(sequence.anglesAt(8).y(), 0.2f, EPSILON);
+  EXPECT_NEAR(sequence.getStartAngles().y(), 0.2f, EPSILON);
+}
+
+TEST(SettingsTest, TestSettings1) {
+  Settings settings;
+  settings.setLineWidth(4.5f);
+  settings.setDisplayType(v_settings_vertex_display_square);
+  settings.setBackgroundColorG(0.25f);
+  std::string text = settings.serialize();
+
+  Settings loaded;
+  ASSERT_TRUE(loaded.deserialize(text));
+  EXPECT_EQ(loaded.serialize(), text);
+  EXPECT_EQ(loaded.getLineWidth(), 4.5f);
+  EXPECT_EQ(loaded.getDisplayType(), v_settings_vertex_display_square);
+  EXPECT_EQ(loaded.getBackgroundColor().g(), 0.25f);
+
+  std::string bad_version = text;
+  bad_version.replace(bad_version.find(' '), 2, " 99");
+  std::string bad_value = text + "line_type 7\n";
+  Settings unchanged;
+  EXPECT_FALSE(unchanged.deserialize(bad_version));
+  EXPECT_FALSE(unchanged.deserialize(bad_value));
+  EXPECT_FALSE(unchanged.deserialize(""));
+  EXPECT_EQ(unchanged.serialize(), Settings().serialize());
+}
+
+TEST(SettingsTest, TestSettings2) {
+  std::string path = SETTINGS_PATH;
+  path += ".store_test";
+  remove(path.c_str());
+  Settings settings;
+  {
+    SettingsStore store(path, 50, 10000);
+    for (int i = 1; i <= 100; ++i) {
+      settings.setVertexSize(i * 0.5f + 1.0f);
+      store.save(settings);
+    }
+    store.flush();
+    EXPECT_EQ(store.getWritesCount(), 1u);
+    EXPECT_EQ(store.getError(), v_settings_OK);
+
+    settings.setLineType(v_settings_line_dotted);
+    store.save(settings);
+  }
+  Settings loaded;
+  loaded.uploadSettings(path);
+  EXPECT_EQ(loaded.getVertexSize(), 51.0f);
+  EXPECT_EQ(loaded.getLineType(), v_settings_line_dotted);
+
+  SettingsStore failing(path + ".missing/settings.conf", 0);
+  failing.save(settings);
+  failing.flush();
+  EXPECT_EQ(failing.getError(), v_settings_CANT_WRITE);
+  remove(path.c_str());
+}
+
+TEST(SoftwareRendererTest, TestSoftwareRenderer1) {
+  SoftwareRenderStyle style;
+  style.background_color = Vector3(0.0f, 0.0f, 0.0f);
+  style.line_color = Vector3(1.0f, 1.0f, 1.0f);
+  SoftwareRenderer renderer(64, 32, 1);
+  renderer.setStyle(style);
+  // the line goes through centers of row 15, its end beyond far plane
+  float y = 1.0f - 15.5f / 16.0f;
+  Vector3 vertices[2] = {Vector3(-1.0f, y, 0.0f), Vector3(1.0f, y, 3.0f)};
+  unsigned int indices[2] = {0, 1};
+  renderer.render(vertices, 2, indices, 2, v_software_lines,
+                  MatrixGenerator().generate_identity());
+  const std::vector<unsigned char>& pixels = renderer.getPixels();
+  auto red = [&](int row, int col) { return pixels[(row * 64 + col) * 3]; };
+  EXPECT_EQ(renderer.getLinesCount(), 1u);
+  EXPECT_EQ(red(15, 10), 255);
+  EXPECT_EQ(red(14, 10), 0);
+  EXPECT_EQ(red(16, 10), 0);
+  // clipped where z reaches w, at a third of the line
+  EXPECT_EQ(red(15, 18), 255);
+  EXPECT_EQ(red(15, 24), 0);
+}
+
+TEST(SoftwareRendererTest, TestSoftwareRenderer2) {
+  std::string path = OBJECTS_PATH;
+  path += "/cow.obj";
+  Parser parser;
+  Model model(&parser);
+  model.uploadModel(path);
+  model.initModel();
+  ASSERT_EQ(model.getErrorCode(), 0);
+
+  SoftwareRenderStyle style;
+  style.line_color = Vector3(1.0f, 0.5f, 0.0f);
+  style.vertex_color = Vector3(0.0f, 1.0f, 0.0f);
+  style.line_width = 2.0f;
+  style.point_size = 3.0f;
+  style.stipple_pattern = 0x0F0F;
+  std::vector<unsigned char> images[2];
+  for (int threads = 1; threads <= 2; ++threads) {
+    SoftwareRenderer renderer(200, 150, threads);
+    renderer.setStyle(style);
+    renderer.render(model.getVertices3d(), model.getVerticesCount(),
+                    model.getIndices(), model.getIndicesCount(),
+                    v_software_triangles,
+                    MatrixGenerator().generate_identity());
+    EXPECT_EQ(renderer.getLinesCount(), model.getIndicesCount());
+    images[threads - 1] = renderer.takePixels();
+  }
+  EXPECT_EQ(images[0], images[1]);
+  size_t drawn = 0;
+  for (unsigned char channel : images[0]) drawn += channel != 0;
+  EXPECT_GT(drawn, 1000u);
+}
+
+TEST(InteractionTraceTest, TestInteractionTrace1) {
+  InteractionTrace trace;
+  trace.setModelPath("models/cow and bull.obj");
+  trace.add({0, v_interaction_state, 6, {1.0f, 0.0f, 0.0f}});
+  trace.add({1200, v_interaction_group_begin, 0, {}});
+  trace.add({1500, v_interaction_command, 12, {0.1f, 0.2f, 1.0f / 3.0f}});
+  trace.add({16700, v_interaction_frame, 0, {}});
+  trace.add({17000, v_interaction_group_end, 0, {}});
+  trace.add({2500000, v_interaction_undo, 0, {}});
+  trace.add({2516700, v_interaction_frame, 0, {}});
+  std::string path = SETTINGS_PATH;
+  path += ".interactions";
+  ASSERT_TRUE(trace.save(path));
+
+  InteractionTrace loaded;
+  ASSERT_TRUE(loaded.load(path));
+  EXPECT_EQ(loaded.getModelPath(), trace.getModelPath());
+  ASSERT_EQ(loaded.getEvents().size(), trace.getEvents().size());
+  EXPECT_EQ(loaded.getFramesCount(), 2u);
+  for (size_t i = 0; i < trace.getEvents().size(); ++i) {
+    const InteractionEvent& expected = trace.getEvents()[i];
+    const InteractionEvent& event = loaded.getEvents()[i];
+    EXPECT_EQ(event.time_us, expected.time_us);
+    EXPECT_EQ(event.type, expected.type);
+    if (event.type == v_interaction_command) {
+      EXPECT_EQ(event.command, expected.command);
+      for (int k = 0; k < 3; ++k) {
+        EXPECT_EQ(event.values[k], expected.values[k]);
+      }
+    }
+  }
+
+  std::ofstream(path) << INTERACTION_TRACE_NAME << " 1\nmodel a.obj\n"
+                      << "20 frame\n10 frame\n";
+  EXPECT_FALSE(loaded.load(path));
+  EXPECT_TRUE(loaded.getEvents().empty());
+  std::ofstream(path) << INTERACTION_TRACE_NAME << " 1\nmodel a.obj\n"
+                      << "10 command 1 nan 0 0\n";
+  EXPECT_FALSE(loaded.load(path));
+  remove(path.c_str());
+}
+
+TEST(InteractionTraceTest, TestInteractionTrace2) {
+  std::vector<double> frame_ms;
+  for (int i = 0; i < 98; ++i) frame_ms.push_back(10.0);
+  frame_ms.push_back(20.0);
+  frame_ms.push_back(50.0);
+  ReplayReport report = InteractionTrace::makeReport(frame_ms, 10.0);
+  EXPECT_EQ(report.frame.samples, 100u);
+  EXPECT_DOUBLE_EQ(report.frame.p50, 10.0);
+  EXPECT_DOUBLE_EQ(report.frame.p95, 10.0);
+  EXPECT_DOUBLE_EQ(report.frame.p99, 20.0);
+  EXPECT_DOUBLE_EQ(report.frame.last, 50.0);
+  EXPECT_DOUBLE_EQ(report.frame.average, 10.5);
+  EXPECT_EQ(report.dropped_frames, 5u);
+  EXPECT_NEAR(report.seconds, 1.05, 1e-9);
+  EXPECT_NE(report.toString().find("dropped frames: 5"), std::string::npos);
+}
+
+TEST(TaskSchedulerTest, TestTaskScheduler1) {
+  TaskScheduler& scheduler = TaskScheduler::instance();
+  size_t threads_count = scheduler.getThreadsCount();
+  scheduler.setThreadsCount(4);
+  EXPECT_EQ(scheduler.getThreadsCount(), 4u);
+  scheduler.resetCounters();
+
+  std::vector<int> visits(10000, 0);
+  std::atomic<size_t> inner(0);
+  scheduler.parallelFor(0, visits.size(), 100, [&](size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) ++visits[i];
+    // nested loops are run by the waiting threads
+    scheduler.parallelFor(0, 8, 1, [&](size_t a, size_t b) { inner += b - a; });
+  });
+  for (int count : visits) EXPECT_EQ(count, 1);
+  EXPECT_EQ(inner % 8, 0u);
+  EXPECT_GT(inner.load(), 0u);
+
+  auto sum = [&](size_t first, size_t last) {
+    double value = 0.0;
+    for (size_t i = first; i < last; ++i) value += 1.0 / (i + 1);
+    return value;
+  };
+  auto add = [](double a, double b) { return a + b; };
+  double parallel = scheduler.parallelReduce(0, 100000, 1000, 0.0, sum, add);
+  scheduler.setThreadsCount(1);
+  double serial = scheduler.parallelReduce(0, 100000, 1000, 0.0, sum, add);
+  EXPECT_EQ(parallel, serial);
+
+  TaskSchedulerCounters counters = scheduler.getCounters();
+  EXPECT_GT(counters.tasks, 0u);
+  EXPECT_EQ(counters.queue_depth, 0u);
+  EXPECT_GT(counters.max_queue_depth, 0u);
+  scheduler.setThreadsCount(threads_count);
+}
+
+TEST(TaskSchedulerTest, TestTaskScheduler3) {
+  TaskScheduler& scheduler = TaskScheduler::instance();
+  size_t threads_count = scheduler.getThreadsCount();
+  scheduler.setThreadsCount(4);
+
+  std::vector<int> visits(64, 0);
+  std::atomic<bool> started(false);
+  auto visit = [&](size_t first, size_t last) {
+    started = true;
+    for (size_t i = first; i < last; ++i) ++visits[i];
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  };
+  std::thread loop(
+      [&]() { scheduler.parallelFor(0, visits.size(), 1, visit); });
+  while (!started) std::this_thread::yield();
+  // the resize waits for the running loop instead of dropping its tasks
+  scheduler.setThreadsCount(3);
+  loop.join();
+  for (int count : visits) EXPECT_EQ(count, 1);
+  EXPECT_EQ(scheduler.getThreadsCount(), 3u);
+  EXPECT_EQ(scheduler.getCounters().queue_depth, 0u);
+
+  std::atomic<size_t> items(0);
+  auto count = [&](size_t first, size_t last) { items += last - first; };
+  scheduler.parallelFor(0, 1000, 10, count);
+  EXPECT_EQ(items.load(), 1000u);
+  scheduler.setThreadsCount(threads_count);
+}
+
+TEST(TaskSchedulerTest, TestTaskScheduler2) {
+  std::string dir = SETTINGS_PATH;
+  dir += ".cgroup";
+  std::filesystem::create_directories(dir);
+  EXPECT_EQ(TaskScheduler::readCgroupQuota(dir), 0.0);
+  std::ofstream(dir + "/cpu.max") << "max 100000\n";
+  EXPECT_EQ(TaskScheduler::readCgroupQuota(dir), 0.0);
+  std::ofstream(dir + "/cpu.max") << "150000 100000\n";
+  EXPECT_DOUBLE_EQ(TaskScheduler::readCgroupQuota(dir), 1.5);
+  std::filesystem::remove(dir + "/cpu.max");
+  std::ofstream(dir + "/cpu.cfs_quota_us") << "-1\n";
+  std::ofstream(dir + "/cpu.cfs_period_us") << "100000\n";
+  EXPECT_EQ(TaskScheduler::readCgroupQuota(dir), 0.0);
+  std::ofstream(dir + "/cpu.cfs_quota_us") << "300000\n";
+  EXPECT_DOUBLE_EQ(TaskScheduler::readCgroupQuota(dir), 3.0);
+  std::filesystem::remove_all(dir);
+  EXPECT_GE(TaskScheduler::availableConcurrency(), 1u);
+}
+
+TEST(ProgressiveMeshTest, TestProgressiveMesh1) {
+  std::string path = OBJECTS_PATH;
+  path += "/cow.obj";
+  Parser parser;
+  Model model(&parser);
+  ProgressiveMesh mesh;
+  int batches = 0;
+  mesh.setBatchHandler([&batches]() { ++batches; });
+  model.setProgressiveMesh(&mesh);
+  model.uploadModel(path);
+  model.initModel();
+  ASSERT_EQ(model.getErrorCode(), OK);
+  EXPECT_GE(batches, 2);
+
+  ProgressiveBatch batch = mesh.getBatch(0, 0);
+  EXPECT_TRUE(batch.finished);
+  ASSERT_EQ(batch.vertices.size(), model.getVerticesCount());
+  EXPECT_EQ(batch.indices.size(), model.getIndicesCount());
+  // the matrix of the whole bounding box normalizes as the model does
+  std::vector<Vector3> normalized(batch.vertices.size());
+  MatrixGenerator().f3d_vertex_array_processing(
+      batch.vertices.data(), normalized.data(), normalized.size(),
+      mesh.getNormalizationMatrix());
+  for (size_t i = 0; i < normalized.size(); ++i) {
+    for (int axis = 0; axis < 3; ++axis) {
+      EXPECT_NEAR(normalized[i](axis), model.getVertices3d()[i](axis), 1e-4);
+    }
+  }
+  for (size_t i = 0; i < batch.indices.size(); ++i) {
+    EXPECT_EQ(batch.indices[i], model.getIndices()[i]);
+  }
+  EXPECT_EQ(mesh.getBatch(batch.vertices.size(), 3).indices.size(),
+            batch.indices.size() - 3);
+}
+
+TEST(ProgressiveMeshTest, TestProgressiveMesh2) {
+  ProgressiveMesh mesh;
+  mesh.reset(PROGRESSIVE_MESH_BYTES_PER_VERTEX * 10);
+  size_t vertices_count = 0, indices_count = 0;
+  mesh.getExpectedCounts(&vertices_count, &indices_count);
+  EXPECT_GE(vertices_count, 10u);
+  EXPECT_GE(indices_count, 10u * PROGRESSIVE_MESH_INDICES_PER_VERTEX);
+
+  mesh.append({Vector3(-2, 0, 0), Vector3(2, 0, 0)}, {});
+  mesh.append({Vector3(0, 4, 0)}, {0, 1, 2});
+  ProgressiveBatch batch = mesh.getBatch(2, 0);
+  EXPECT_FALSE(batch.finished);
+  ASSERT_EQ(batch.vertices.size(), 1u);
+  EXPECT_EQ(batch.first_vertex, 2u);
+  EXPECT_EQ(batch.indices.size(), 3u);
+  EXPECT_FLOAT_EQ(batch.min.x(), -2.0f);
+  EXPECT_FLOAT_EQ(batch.max.y(), 4.0f);
+
+  // the provisional box grows with the batches
+  Vector3 top;
+  Vector3 vertex(0, 4, 0);
+  MatrixGenerator().f3d_vertex_array_processing(
+      &vertex, &top, 1, mesh.getNormalizationMatrix());
+  EXPECT_NEAR(top.y(), 2.0f / 4.0f * 0.95f, EPSILON);
+  mesh.append({Vector3(0, -4, 0)}, {});
+  MatrixGenerator().f3d_vertex_array_processing(
+      &vertex, &top, 1, mesh.getNormalizationMatrix());
+  EXPECT_NEAR(top.y(), 0.95f, EPSILON);
+  EXPECT_EQ(mesh.getVerticesCount(), 4u);
+
+  mesh.finish();
+  EXPECT_TRUE(mesh.getBatch(0, 0).finished);
+  mesh.clear();
+  EXPECT_EQ(mesh.getVerticesCount(), 0u);
+  EXPECT_EQ(mesh.getIndicesCount(), 0u);
+}
+
+TEST(OutOfCoreTest, TestOutOfCore1) {
+  std::string path = OBJECTS_PATH;
+  path += "/cow.obj";
+  Parser parser;
+  Model model(&parser);
+  model.uploadModel(path);
+  model.initModel();
+  Parser scratch_parser;
+  Model scratch_model(&scratch_parser);
+  scratch_model.setScratchDir(std::filesystem::temp_directory_path());
+  scratch_model.uploadModel(path);
+  scratch_model.initModel();
+  ASSERT_EQ(scratch_model.getErrorCode(), OK);
+  EXPECT_TRUE(scratch_model.isOutOfCore());
+  EXPECT_FALSE(model.isOutOfCore());
+
+  ASSERT_EQ(scratch_model.getVerticesCount(), model.getVerticesCount());
+  ASSERT_EQ(scratch_model.getIndicesCount(), model.getIndicesCount());
+  for (size_t i = 0; i < model.getVerticesCount(); ++i) {
+    for (int axis = 0; axis < 3; ++axis) {
+      EXPECT_FLOAT_EQ(scratch_model.getVertices3d()[i](axis),
+                      model.getVertices3d()[i](axis));
+    }
+  }
+  for (size_t i = 0; i < model.getIndicesCount(); ++i) {
+    EXPECT_EQ(scratch_model.getIndices()[i], model.getIndices()[i]);
+  }
+  EXPECT_EQ(scratch_model.getMeshlets().size(), model.getMeshlets().size());
+  scratch_model.deleteModel();
+  EXPECT_FALSE(scratch_model.isOutOfCore());
+}
+
+TEST(OutOfCoreTest, TestOutOfCore2) {
+  std::string path = OBJECTS_PATH;
+  path += "/cow.obj";
+  Parser parser;
+  Model model(&parser);
+  model.setScratchDir(std::filesystem::temp_directory_path());
+  model.uploadModel(path);
+  model.initModel();
+  const std::vector<Meshlet>& meshlets = model.getMeshlets();
+  ASSERT_GT(meshlets.size(), 4u);
+
+  MeshPager pager;
+  pager.reset(&model.getVerticesFile(), &model.getIndicesFile(), meshlets);
+  // two meshlets fit into the budget, all meshlets do not
+  size_t budget = 2 * (model.getVerticesFile().size() +
+                       sizeof(unsigned int) * 3 * MESHLET_MAX_TRIANGLES);
+  pager.setBudget(budget);
+  std::vector<size_t> visible(meshlets.size());
+  for (size_t i = 0; i < visible.size(); ++i) visible[i] = i;
+  std::vector<size_t> resident, missing;
+  pager.update(visible, &resident, &missing);
+  EXPECT_LE(pager.getResidentBytes(), budget);
+  EXPECT_EQ(resident.size() + missing.size(), meshlets.size());
+  EXPECT_FALSE(missing.empty());
+
+  // meshlets out of view give their memory to the visible ones
+  std::vector<size_t> last_ones(visible.end() - 2, visible.end());
+  bool loaded = false;
+  for (int frame = 0; frame < 1000 && !loaded; ++frame) {
+    resident.clear();
+    missing.clear();
+    pager.update(last_ones, &resident, &missing);
+    loaded = resident.size() == last_ones.size();
+    if (!loaded) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_TRUE(loaded);
+  EXPECT_LE(pager.getResidentBytes(), budget);
+  EXPECT_EQ(pager.getRequestedCount(), 0u);
+  std::vector<VertexSpan> spans = pager.getSpans(resident);
+  ASSERT_FALSE(spans.empty());
+  for (size_t i = 1; i < spans.size(); ++i) {
+    EXPECT_GT(spans[i].first, spans[i - 1].last);
+  }
+  EXPECT_LE(spans.back().last, model.getVerticesCount());
+  // spans hold the vertices the meshlets reference and no others
+  std::set<unsigned int> used;
+  for (size_t i : resident) {
+    const unsigned int* first = model.getIndices() + meshlets[i].index_offset;
+    used.insert(first, first + meshlets[i].index_count);
+  }
+  size_t covered = 0;
+  for (const VertexSpan& span : spans) {
+    covered += span.last - span.first;
+    for (size_t vertex = span.first; vertex < span.last; ++vertex) {
+      EXPECT_EQ(used.count(vertex), 1u) << vertex;
+    }
+  }
+  EXPECT_EQ(covered, used.size());
+  EXPECT_LE(pager.getVertexCapacity(), budget / (2 * sizeof(Vector3)));
+}
+
+TEST(CompressedTest, TestCompressed1) {
+  if (!DecompressBuffer::isSupported(v_compression_gzip)) GTEST_SKIP();
+  std::string path = OBJECTS_PATH;
+  path += "/cow.obj";
+  Parser parser;
+  Model model(&parser);
+  model.uploadModel(path);
+  Parser gzip_parser;
+  Model gzip_model(&gzip_parser);
+  gzip_model.uploadModel(path + ".gz");
+  ASSERT_EQ(gzip_model.getErrorCode(), OK);
+
+  ASSERT_EQ(gzip_model.getVerticesCount(), model.getVerticesCount());
+  ASSERT_EQ(gzip_model.getIndicesCount(), model.getIndicesCount());
+  for (size_t i = 0; i < model.getVerticesCount(); ++i) {
+    for (int axis = 0; axis < 3; ++axis) {
+      EXPECT_FLOAT_EQ(gzip_model.getVertices3d()[i](axis),
+                      model.getVertices3d()[i](axis));
+    }
+  }
+  for (size_t i = 0; i < model.getIndicesCount(); ++i) {
+    EXPECT_EQ(gzip_model.getIndices()[i], model.getIndices()[i]);
+  }
+}
+
+TEST(CompressedTest, TestCompressed2) {
+  const char zstd_magic[] = {0x28, (char)0xb5, 0x2f, (char)0xfd};
+  EXPECT_EQ(DecompressBuffer::detect(zstd_magic, 4), v_compression_zstd);
+  EXPECT_EQ(DecompressBuffer::detect("v 1", 3), v_compression_none);
+  if (!DecompressBuffer::isSupported(v_compression_gzip)) GTEST_SKIP();
+  std::string path = OBJECTS_PATH;
+  path += "/cow.obj.gz";
+  std::ifstream compressed(path, std::ios::binary);
+  std::string data((std::istreambuf_iterator<char>(compressed)),
+                   std::istreambuf_iterator<char>());
+  EXPECT_EQ(DecompressBuffer::detect(data.data(), data.size()),
+            v_compression_gzip);
+
+  // truncated file is an error, not a shorter model
+  std::string broken_path =
+      std::filesystem::temp_directory_path() / "s21_3DViewer_broken.obj.gz";
+  std::ofstream(broken_path, std::ios::binary)
+      .write(data.data(), data.size() / 2);
+  Parser parser;
+  Model model(&parser);
+  model.uploadModel(broken_path);
+  EXPECT_EQ(model.getErrorCode(), ERROR);
+  std::filesystem::remove(broken_path);
+}
+
+TEST(InputFileTest, TestInputFile1) {
+  std::string path = OBJECTS_PATH;
+  path += "/cow.obj";
+  std::ifstream stream(path, std::ios::binary);
+  std::string expected((std::istreambuf_iterator<char>(stream)),
+                       std::istreambuf_iterator<char>());
+  for (bool direct : {false, true}) {
+    InputFile file;
+    ASSERT_TRUE(file.open(path, direct));
+    EXPECT_EQ(file.size(), expected.size());
+    char magic[4] = {};
+    ASSERT_EQ(file.peek(magic, sizeof(magic)), sizeof(magic));
+    EXPECT_EQ(std::string(magic, sizeof(magic)), expected.substr(0, 4));
+    std::string data((std::istreambuf_iterator<char>(&file)),
+                     std::istreambuf_iterator<char>());
+    EXPECT_EQ(data, expected);
+    EXPECT_EQ(file.peek(magic, sizeof(magic)), 0u);
+  }
+  InputFile directory;
+  EXPECT_FALSE(directory.open(OBJECTS_PATH));
+  EXPECT_FALSE(directory.isOpen());
+}
+
+TEST(InputFileTest, TestInputFile2) {
+  std::string path = OBJECTS_PATH;
+  path += "/cow.obj";
+  Parser parser;
+  Model model(&parser);
+  model.uploadModel(path);
+  Parser direct_parser;
+  Model direct_model(&direct_parser);
+  direct_model.setDirectRead(true);
+  direct_model.uploadModel(path);
+  ASSERT_EQ(direct_model.getErrorCode(), OK);
+  ASSERT_EQ(direct_model.getVerticesCount(), model.getVerticesCount());
+  ASSERT_EQ(direct_model.getIndicesCount(), model.getIndicesCount());
+  for (size_t i = 0; i < model.getIndicesCount(); ++i) {
+    EXPECT_EQ(direct_model.getIndices()[i], model.getIndices()[i]);
+  }
+
+  Parser directory_parser;
+  Model directory_model(&directory_parser);
+  directory_model.uploadModel(OBJECTS_PATH);
+  EXPECT_EQ(directory_model.getErrorCode(), ERROR_FILE);
+}
+
+#if !defined(VIEWER_DISABLE_TRACING)
+TEST(TracerTest, TestTracer1) {
+  Tracer& tracer = Tracer::instance();
+  tracer.clear();
+  tracer.setEnabled(true);
+  std::string path = OBJECTS_PATH;
+  path += "/test_triangle.obj";
+  Parser parser;
+  Model model(&parser);
+  model.uploadModel(path);
+  model.initModel();
+  tracer.setEnabled(false);
+  size_t count = tracer.eventsCount();
+  EXPECT_GE(count, 5u);
+
+  model.uploadModel(path);
+  EXPECT_EQ(tracer.eventsCount(), count);
+
+  std::string trace_path = SETTINGS_PATH;
+  trace_path += ".trace.json";
+  ASSERT_TRUE(tracer.dump(trace_path));
+  std::ifstream file(trace_path);
+  std::stringstream content;
+  content << file.rdbuf();
+  EXPECT_NE(content.str().find("\"traceEvents\""), std::string::npos);
+  EXPECT_NE(content.str().find("\"Parser::parseFile\""), std::string::npos);
+  EXPECT_NE(content.str().find("\"Model::initModel\""), std::string::npos);
+  remove(trace_path.c_str());
+}
+#endif
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
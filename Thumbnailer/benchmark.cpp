@@ -0,0 +1,204 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "controller.h"
+#include "interaction_trace.h"
+#include "software_renderer.h"
+#include "task_scheduler.h"
+
+#define BENCHMARK_DEFAULT_SIZE 1024
+#define BENCHMARK_DEFAULT_REPEATS 20
+
+static void printUsage(const char *name) {
+  fprintf(stderr,
+          "usage: %s [-s WIDTHxHEIGHT] [-j THREADS] [-n REPEATS] "
+          "[-w LINE_WIDTH] MODEL.obj|LINES_COUNT\n"
+          "       %s [-s WIDTHxHEIGHT] [-j THREADS] [-t] -r TRACE [MODEL.obj]\n"
+          "renders the model, or random lines, and reports lines per second,\n"
+          "or replays recorded interactions, at their original pace with -t,\n"
+          "and reports frame times\n",
+          name, name);
+}
+
+// random lines spread over the view volume and slightly beyond it
+static void makeRandomLines(size_t lines_count, std::vector<Vector3> *vertices,
+                            std::vector<unsigned int> *indices) {
+  std::mt19937 generator(21);
+  std::uniform_real_distribution<float> coordinate(-1.2f, 1.2f);
+  for (size_t i = 0; i < 2 * lines_count; ++i) {
+    Vector3 vertex;
+    vertex.x() = coordinate(generator);
+    vertex.y() = coordinate(generator);
+    vertex.z() = coordinate(generator) * 0.5f;
+    vertices->push_back(vertex);
+    indices->push_back(i);
+  }
+}
+
+// frames of the trace drawn the way the viewer draws them: vertices are
+// transformed by the controller when the transform changed, then rendered
+static int replayTrace(const std::string &trace_path, std::string model_path,
+                       int width, int height, int threads_count,
+                       bool keep_pace) {
+  InteractionTrace trace;
+  if (!trace.load(trace_path)) {
+    fprintf(stderr, "failed: %s\n", trace_path.c_str());
+    return 2;
+  }
+  if (model_path.empty()) model_path = trace.getModelPath();
+  Settings settings;
+  Parser parser;
+  Model model(&parser);
+  Controller controller(&model, &settings);
+  if (controller.uploadModel(model_path)) {
+    fprintf(stderr, "failed: %s\n", model_path.c_str());
+    return 2;
+  }
+  controller.setModel();
+  controller.resetState();
+  controller.setModelMatrixes();
+
+  SoftwareRenderer renderer(width, height, threads_count);
+  Matrix4x4 identity = MatrixGenerator().generate_identity();
+  std::vector<double> frame_ms;
+  auto start = std::chrono::steady_clock::now();
+  auto frame_start = start;
+  for (const InteractionEvent &event : trace.getEvents()) {
+    if (keep_pace) {
+      auto event_time = start + std::chrono::microseconds(event.time_us);
+      if (event_time > frame_start) {
+        std::this_thread::sleep_until(event_time);
+        frame_start = std::chrono::steady_clock::now();
+      }
+    }
+    if (event.type != v_interaction_frame) {
+      controller.replayEvent(event);
+      continue;
+    }
+    if (controller.isTransformChanged()) controller.updateModel();
+    SoftwareRenderStyle style;
+    style.background_color = controller.getBackgroundColor();
+    style.line_color = controller.getLineColor();
+    style.vertex_color = controller.getVerticesColor();
+    style.line_width = controller.getLineWidth();
+    if (controller.toColor()) style.point_size = controller.getVertexSize();
+    renderer.setStyle(style);
+    renderer.render(controller.getVerticesCopy(),
+                    controller.getVerticesCount(), controller.getIndices(),
+                    controller.getIndicesCount(), v_software_triangles,
+                    identity);
+    controller.endCommandFrame();
+    auto now = std::chrono::steady_clock::now();
+    frame_ms.push_back(
+        std::chrono::duration<double, std::milli>(now - frame_start).count());
+    frame_start = now;
+  }
+
+  ReplayReport report = InteractionTrace::makeReport(frame_ms);
+  printf("%zu events of %s at %dx%d\n%s", trace.getEvents().size(),
+         model_path.c_str(), width, height, report.toString().c_str());
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  int width = BENCHMARK_DEFAULT_SIZE, height = BENCHMARK_DEFAULT_SIZE;
+  int threads_count = 0, repeats = BENCHMARK_DEFAULT_REPEATS;
+  float line_width = 1.0f;
+  bool keep_pace = false;
+  std::string input, trace_path;
+
+  for (int i = 1; i < argc; ++i) {
+    bool has_value = i + 1 < argc;
+    if (!strcmp(argv[i], "-s") && has_value) {
+      if (sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width <= 0 ||
+          height <= 0) {
+        printUsage(argv[0]);
+        return 1;
+      }
+    } else if (!strcmp(argv[i], "-j") && has_value) {
+      threads_count = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "-n") && has_value) {
+      repeats = std::max(1, atoi(argv[++i]));
+    } else if (!strcmp(argv[i], "-w") && has_value) {
+      line_width = atof(argv[++i]);
+    } else if (!strcmp(argv[i], "-r") && has_value) {
+      trace_path = argv[++i];
+    } else if (!strcmp(argv[i], "-t")) {
+      keep_pace = true;
+    } else if (argv[i][0] == '-' || !input.empty()) {
+      printUsage(argv[0]);
+      return 1;
+    } else {
+      input = argv[i];
+    }
+  }
+  if (threads_count > 0) {
+    TaskScheduler::instance().setThreadsCount(threads_count);
+  }
+  if (!trace_path.empty()) {
+    return replayTrace(trace_path, input, width, height, threads_count,
+                       keep_pace);
+  }
+  if (input.empty()) {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  std::vector<Vector3> vertices;
+  std::vector<unsigned int> indices;
+  v_software_primitives primitive = v_software_triangles;
+  Matrix4x4 mvp = MatrixGenerator().generate_identity();
+  Settings settings;
+  Parser parser;
+  Model model(&parser);
+  Controller controller(&model, &settings);
+  char *end = nullptr;
+  unsigned long lines_count = strtoul(input.c_str(), &end, 10);
+  if (*end == '\0' && lines_count > 0) {
+    makeRandomLines(lines_count, &vertices, &indices);
+    primitive = v_software_lines;
+  } else if (!controller.uploadModel(input)) {
+    controller.setModel();
+    controller.resetState();
+    controller.setModelMatrixes();
+    Vector3 *model_vertices = controller.getModelVertices();
+    vertices.assign(model_vertices,
+                    model_vertices + controller.getVerticesCount());
+    unsigned int *model_indices = controller.getIndices();
+    indices.assign(model_indices,
+                   model_indices + controller.getIndicesCount());
+    mvp = controller.getMvpMatrix();
+  } else {
+    fprintf(stderr, "failed: %s\n", input.c_str());
+    return 2;
+  }
+
+  SoftwareRenderStyle style;
+  style.line_color.r() = 1.0f;
+  style.line_width = line_width;
+  SoftwareRenderer renderer(width, height, threads_count);
+  renderer.setStyle(style);
+  // the first frame allocates bins and is not measured
+  renderer.render(vertices.data(), vertices.size(), indices.data(),
+                  indices.size(), primitive, mvp);
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < repeats; ++i) {
+    renderer.render(vertices.data(), vertices.size(), indices.data(),
+                    indices.size(), primitive, mvp);
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  double lines = (double)renderer.getLinesCount() * repeats;
+  printf("%zu lines at %dx%d, %.3f ms per frame (%.2f M lines/s)\n",
+         renderer.getLinesCount(), width, height, seconds * 1000.0 / repeats,
+         seconds > 0.0 ? lines / seconds / 1e6 : 0.0);
+  return 0;
+}
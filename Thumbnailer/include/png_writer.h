@@ -0,0 +1,38 @@
+#ifndef SRC_THUMBNAILER_INCLUDE_PNG_WRITER_H
+#define SRC_THUMBNAILER_INCLUDE_PNG_WRITER_H
+
+/**
+ * @file png_writer.h
+ * @author SevenStreams
+ * @brief This file handles saving thumbnails as PNG
+ * @version 0.1
+ * @date 2024-03-15
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief Writer of RGB images to PNG files
+ *
+ */
+class PngWriter {
+ public:
+  /**
+   * @brief The function writes the image to the file
+   *
+   * @param path Path of the file
+   * @param width Width of the image
+   * @param height Height of the image
+   * @param pixels Rows of RGB pixels, top first
+   * @return true File is written
+   * @return false File can not be opened or written
+   */
+  static bool write(const std::string &path, int width, int height,
+                    const std::vector<unsigned char> &pixels);
+};
+
+#endif  // SRC_THUMBNAILER_INCLUDE_PNG_WRITER_H
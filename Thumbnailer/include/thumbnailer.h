@@ -0,0 +1,97 @@
+#ifndef SRC_THUMBNAILER_INCLUDE_THUMBNAILER_H
+#define SRC_THUMBNAILER_INCLUDE_THUMBNAILER_H
+
+/**
+ * @file thumbnailer.h
+ * @author SevenStreams
+ * @brief This file handles rendering thumbnails of many models
+ * @version 0.1
+ * @date 2024-03-15
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <string>
+#include <vector>
+
+#include "matrix.h"
+#include "software_renderer.h"
+
+class Controller;
+
+/**
+ * @brief Result of a thumbnailer run
+ *
+ */
+struct ThumbnailerReport {
+  size_t files_count = 0;           // files given to the run
+  size_t written_count = 0;         // thumbnails written
+  std::vector<std::string> failed;  // files which could not be processed
+  double seconds = 0.0;             // wall time of the run
+
+  /**
+   * @brief The function returns throughput of the run
+   *
+   * @return double Processed files per second
+   */
+  double getFilesPerSecond() const;
+};
+
+/**
+ * @brief Headless renderer of wireframe thumbnails
+ *
+ * Every file is loaded with Model and Controller, drawn with
+ * SoftwareRenderer and encoded with PngWriter by one thread of
+ * TaskScheduler, files are processed in parallel.
+ */
+class Thumbnailer {
+ public:
+  /**
+   * @brief The function handles initializing thumbnailer
+   *
+   * @param width Width of thumbnails
+   * @param height Height of thumbnails
+   * @return Thumbnailer
+   */
+  Thumbnailer(int width, int height);
+
+  /**
+   * @brief The function renders thumbnails of the files
+   *
+   * The thumbnail of root/dir/name.obj is written to
+   * output_dir/dir/name.png, where root is the deepest directory holding all
+   * the files, so files of one name in different directories do not
+   * overwrite each other. Compressed name.obj.gz and name.obj.zst share the
+   * thumbnail with name.obj, all but the first of them fail.
+   *
+   * @param files Paths of .obj files
+   * @param output_dir Directory of thumbnails
+   * @return ThumbnailerReport Result of the run
+   */
+  ThumbnailerReport run(const std::vector<std::string> &files,
+                        const std::string &output_dir);
+
+  /**
+   * @brief The function expands the input into paths of .obj files
+   *
+   * @param input Directory searched recursively, .obj file or text file
+   * with one path per line
+   * @return std::vector<std::string> Paths of files
+   */
+  static std::vector<std::string> collectFiles(const std::string &input);
+
+ private:
+  /**
+   * @brief The function returns look of the wireframe from the settings
+   *
+   * @param controller Controller with loaded settings
+   * @return SoftwareRenderStyle Style for SoftwareRenderer
+   */
+  static SoftwareRenderStyle getStyle(Controller &controller);
+
+  int width_;
+  int height_;
+};
+
+#endif  // SRC_THUMBNAILER_INCLUDE_THUMBNAILER_H
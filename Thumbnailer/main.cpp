@@ -0,0 +1,63 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "task_scheduler.h"
+#include "thumbnailer.h"
+
+#define THUMBNAIL_DEFAULT_WIDTH 256
+#define THUMBNAIL_DEFAULT_HEIGHT 256
+
+static void printUsage(const char *name) {
+  fprintf(stderr,
+          "usage: %s [-s WIDTHxHEIGHT] [-j THREADS] -o OUTPUT_DIR INPUT...\n"
+          "INPUT is a directory searched for .obj files, an .obj file or a\n"
+          "text file with one path per line\n",
+          name);
+}
+
+int main(int argc, char *argv[]) {
+  int width = THUMBNAIL_DEFAULT_WIDTH, height = THUMBNAIL_DEFAULT_HEIGHT;
+  int threads_count = 0;
+  std::string output_dir;
+  std::vector<std::string> files;
+
+  for (int i = 1; i < argc; ++i) {
+    bool has_value = i + 1 < argc;
+    if (!strcmp(argv[i], "-s") && has_value) {
+      if (sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width <= 0 ||
+          height <= 0) {
+        printUsage(argv[0]);
+        return 1;
+      }
+    } else if (!strcmp(argv[i], "-j") && has_value) {
+      threads_count = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "-o") && has_value) {
+      output_dir = argv[++i];
+    } else if (argv[i][0] == '-') {
+      printUsage(argv[0]);
+      return 1;
+    } else {
+      std::vector<std::string> found = Thumbnailer::collectFiles(argv[i]);
+      files.insert(files.end(), found.begin(), found.end());
+    }
+  }
+  if (output_dir.empty() || files.empty()) {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  if (threads_count > 0) {
+    TaskScheduler::instance().setThreadsCount(threads_count);
+  }
+  ThumbnailerReport report = Thumbnailer(width, height).run(files, output_dir);
+  for (const std::string &file : report.failed) {
+    fprintf(stderr, "failed: %s\n", file.c_str());
+  }
+  printf("%zu thumbnails, %zu failed in %.2f s (%.1f files/s)\n",
+         report.written_count, report.failed.size(), report.seconds,
+         report.getFilesPerSecond());
+  return report.failed.empty() ? 0 : 2;
+}
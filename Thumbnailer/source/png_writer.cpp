@@ -0,0 +1,37 @@
+#include "png_writer.h"
+
+#include <png.h>
+
+#include <cstdio>
+
+bool PngWriter::write(const std::string &path, int width, int height,
+                      const std::vector<unsigned char> &pixels) {
+  if (pixels.size() < (size_t)width * height * 3) return false;
+  FILE *file = fopen(path.c_str(), "wb");
+  if (!file) return false;
+
+  png_structp png =
+      png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+  png_infop info = png ? png_create_info_struct(png) : nullptr;
+  if (!info || setjmp(png_jmpbuf(png))) {
+    png_destroy_write_struct(&png, info ? &info : nullptr);
+    fclose(file);
+    remove(path.c_str());
+    return false;
+  }
+
+  png_init_io(png, file);
+  // thumbnails are many and small, fast compression keeps encoding cheap
+  png_set_compression_level(png, 3);
+  png_set_filter(png, 0, PNG_FILTER_SUB);
+  png_set_IHDR(png, info, width, height, 8, PNG_COLOR_TYPE_RGB,
+               PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT,
+               PNG_FILTER_TYPE_DEFAULT);
+  png_write_info(png, info);
+  for (int row = 0; row < height; ++row) {
+    png_write_row(png, pixels.data() + (size_t)row * width * 3);
+  }
+  png_write_end(png, nullptr);
+  png_destroy_write_struct(&png, &info);
+  return fclose(file) == 0;
+}
@@ -0,0 +1,174 @@
+#include "thumbnailer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+
+#include "controller.h"
+#include "png_writer.h"
+#include "task_scheduler.h"
+
+namespace fs = std::filesystem;
+
+static std::string lowerExtension(const fs::path &path) {
+  std::string extension = path.extension().string();
+  std::transform(extension.begin(), extension.end(), extension.begin(),
+                 ::tolower);
+  return extension;
+}
+
+// name.obj.gz and name.obj.zst are read as name.obj
+static fs::path modelPath(fs::path path) {
+  std::string extension = lowerExtension(path);
+  if (extension == ".gz" || extension == ".zst") path.replace_extension();
+  return path;
+}
+
+// the deepest directory which holds all the files
+static fs::path commonDirectory(const std::vector<fs::path> &paths) {
+  fs::path common = paths.empty() ? fs::path() : paths[0].parent_path();
+  for (const fs::path &path : paths) {
+    fs::path parent = path.parent_path();
+    auto mismatch = std::mismatch(common.begin(), common.end(),
+                                  parent.begin(), parent.end());
+    fs::path prefix;
+    for (auto it = common.begin(); it != mismatch.first; ++it) prefix /= *it;
+    common = prefix;
+  }
+  return common;
+}
+
+double ThumbnailerReport::getFilesPerSecond() const {
+  return seconds > 0.0 ? files_count / seconds : 0.0;
+}
+
+Thumbnailer::Thumbnailer(int width, int height)
+    : width_(width), height_(height) {}
+
+ThumbnailerReport Thumbnailer::run(const std::vector<std::string> &files,
+                                   const std::string &output_dir) {
+  TRACE_SCOPE("Thumbnailer::run");
+  auto start = std::chrono::steady_clock::now();
+  ThumbnailerReport report;
+  report.files_count = files.size();
+  std::mutex report_mutex;
+  auto fail = [&](size_t index) {
+    std::lock_guard<std::mutex> lock(report_mutex);
+    report.failed.push_back(files[index]);
+  };
+
+  // thumbnails mirror the directories of the files below their common one
+  std::vector<fs::path> inputs;
+  for (const std::string &file : files) {
+    inputs.push_back(fs::absolute(modelPath(file)).lexically_normal());
+  }
+  fs::path root = commonDirectory(inputs);
+  std::vector<fs::path> outputs(files.size());
+  std::map<fs::path, size_t> owners;
+  std::error_code error;
+  for (size_t index = 0; index < files.size(); ++index) {
+    fs::path relative = inputs[index].lexically_relative(root);
+    fs::path path = fs::path(output_dir) / relative.parent_path() /
+                    relative.stem().concat(".png");
+    // name.obj and name.obj.gz of one directory would write one thumbnail
+    if (owners.emplace(path, index).second) {
+      outputs[index] = path;
+      fs::create_directories(path.parent_path(), error);
+    } else {
+      fail(index);
+    }
+  }
+  std::atomic<size_t> written(0);
+
+  auto process = [&](size_t first, size_t last) {
+    Settings settings;
+    Parser parser;
+    Model model(&parser);
+    Controller controller(&model, &settings);
+    // files are already drawn in parallel, so one renderer is one part
+    SoftwareRenderer renderer(width_, height_, 1);
+    for (size_t index = first; index < last; ++index) {
+      if (outputs[index].empty()) continue;
+      {
+        TRACE_SCOPE("Thumbnailer::load");
+        if (controller.uploadModel(files[index])) {
+          fail(index);
+          continue;
+        }
+        controller.setModel();
+        controller.resetState();
+        controller.setModelMatrixes();
+      }
+      {
+        TRACE_SCOPE("Thumbnailer::render");
+        renderer.setStyle(getStyle(controller));
+        renderer.render(controller.getModelVertices(),
+                        controller.getVerticesCount(), controller.getIndices(),
+                        controller.getIndicesCount(),
+                        v_software_triangles, controller.getMvpMatrix());
+      }
+      TRACE_SCOPE("Thumbnailer::encode");
+      if (PngWriter::write(outputs[index].string(), width_, height_,
+                           renderer.getPixels())) {
+        ++written;
+      } else {
+        fail(index);
+      }
+    }
+  };
+  // chunks of files are stolen by idle threads, so a large model does not
+  // hold back the files after it
+  TaskScheduler::instance().parallelFor(0, files.size(), 1, process);
+
+  report.written_count = written;
+  report.seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  return report;
+}
+
+SoftwareRenderStyle Thumbnailer::getStyle(Controller &controller) {
+  SoftwareRenderStyle style;
+  style.background_color = controller.getBackgroundColor();
+  style.line_color = controller.getLineColor();
+  style.vertex_color = controller.getVerticesColor();
+  style.line_width = controller.getLineWidth();
+  if (controller.toColor()) style.point_size = controller.getVertexSize();
+  if (controller.toStipple()) {
+    style.stipple_pattern = SOFTWARE_RENDERER_STIPPLE_PATTERN;
+  }
+  style.round_points = controller.toSmooth();
+  return style;
+}
+
+std::vector<std::string> Thumbnailer::collectFiles(const std::string &input) {
+  std::vector<std::string> files;
+  std::error_code error;
+  auto is_obj = [](const fs::path &path) {
+    return lowerExtension(modelPath(path)) == ".obj";
+  };
+
+  if (fs::is_directory(input, error)) {
+    for (fs::recursive_directory_iterator it(input, error), end;
+         !error && it != end; it.increment(error)) {
+      if (it->is_regular_file(error) && is_obj(it->path())) {
+        files.push_back(it->path().string());
+      }
+    }
+    std::sort(files.begin(), files.end());
+  } else if (is_obj(input)) {
+    files.push_back(input);
+  } else {
+    std::ifstream list(input);
+    std::string line;
+    while (std::getline(list, line)) {
+      if (!line.empty() && line.back() == '\r') line.pop_back();
+      if (!line.empty()) files.push_back(line);
+    }
+  }
+  return files;
+}
@@ -0,0 +1,118 @@
+#ifndef SRC_VIEW_INCLUDE_GIF_CAPTURE_H
+#define SRC_VIEW_INCLUDE_GIF_CAPTURE_H
+#define GIF_WIDTH 640
+#define GIF_HEIGHT 480
+#define GIF_FRAMES_COUNT 50
+#define GIF_FRAME_DELAY 100
+#define GIF_QUEUE_CAPACITY 4
+
+/**
+ * @file gif_capture.h
+ * @author SevenStreams
+ * @brief This file handles capturing turntable gifs without blocking the
+ * window
+ * @version 0.1
+ * @date 2024-03-15
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "controller.h"
+#include "qgifstreamwriter.h"
+#include "viewer_widget.h"
+
+/**
+ * @brief Turntable gif capture driven by the event loop
+ *
+ * One frame is rendered per turn of the event loop and handed to the
+ * stream writer, so the window keeps handling events during the capture.
+ * The encoded file is finished on a worker thread.
+ */
+class GifCapture : public QObject {
+  Q_OBJECT
+
+ public:
+  /**
+   * @brief The function handles initializing gif capture
+   *
+   * @param viewer Widget which renders the frames
+   * @param controller The controller
+   * @param parent The parent object
+   * @return GifCapture
+   */
+  GifCapture(viewer_widget *viewer, Controller *controller,
+             QObject *parent = nullptr);
+
+  /**
+   * @brief The function stops the capture and waits for the file
+   *
+   */
+  ~GifCapture();
+
+  /**
+   * @brief The function starts capture of the turntable into the file
+   *
+   * @param axis Axis of rotation
+   * @param file_name Path of the file
+   * @return bool False if the file can not be opened or a capture runs
+   */
+  bool start(v_capture_axis axis, const QString &file_name);
+
+  /**
+   * @brief The function returns if frames are rendered or the file is
+   * being finished
+   *
+   * @return bool True until finished() is emitted
+   */
+  bool isRunning() const;
+
+ signals:
+  /**
+   * @brief The signal is emitted when the last frame is rendered
+   *
+   */
+  void framesCaptured();
+
+  /**
+   * @brief The signal is emitted from the worker when the file is written
+   *
+   * @param file_name Path of the file
+   * @param ok True if the gif is written
+   */
+  void finished(QString file_name, bool ok);
+
+ private slots:
+  /**
+   * @brief The function renders the next frame and finishes the file
+   * after the last one
+   *
+   */
+  void captureFrame();
+
+ private:
+  /**
+   * @brief The function restores rotation and closes the file on the
+   * worker thread
+   *
+   */
+  void finish();
+
+  viewer_widget *viewer_;
+  Controller *controller_;
+  QTimer timer_;
+  std::unique_ptr<QGifStreamWriter> writer_;
+  std::thread closer_;
+  QString file_name_;
+  int frame_;
+  std::atomic<bool> running_;  // cleared by the worker
+};
+
+#endif  // SRC_VIEW_INCLUDE_GIF_CAPTURE_H
@@ -0,0 +1,65 @@
+#ifndef SRC_VIEW_INCLUDE_IMAGE_WRITER_H
+#define SRC_VIEW_INCLUDE_IMAGE_WRITER_H
+
+/**
+ * @file image_writer.h
+ * @author SevenStreams
+ * @brief This file handles encoding and writing of images in background
+ * @version 0.1
+ * @date 2024-03-15
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <QImage>
+#include <QObject>
+#include <QString>
+#include <thread>
+
+/**
+ * @brief Writer which encodes images on a worker thread
+ */
+class ImageWriter : public QObject {
+  Q_OBJECT
+
+ public:
+  /**
+   * @brief The function handles initializing image writer
+   *
+   * @param parent The parent object
+   * @return ImageWriter
+   */
+  explicit ImageWriter(QObject *parent = nullptr);
+
+  /**
+   * @brief The function waits for the last image and destroys writer
+   *
+   */
+  ~ImageWriter();
+
+  /**
+   * @brief The function starts writing of the image
+   *
+   * Format is chosen by extension of the file. The previous image is
+   * finished first.
+   *
+   * @param image The image
+   * @param file_name Path of the file
+   */
+  void write(const QImage &image, const QString &file_name);
+
+ signals:
+  /**
+   * @brief The signal is emitted from the worker when the image is written
+   *
+   * @param file_name Path of the file
+   * @param ok True if the image is written
+   */
+  void written(QString file_name, bool ok);
+
+ private:
+  std::thread worker_;
+};
+
+#endif  // SRC_VIEW_INCLUDE_IMAGE_WRITER_H
@@ -0,0 +1,95 @@
+#ifndef SRC_VIEW_INCLUDE_INTERACTION_REPLAYER_H
+#define SRC_VIEW_INCLUDE_INTERACTION_REPLAYER_H
+
+/**
+ * @file interaction_replayer.h
+ * @author SevenStreams
+ * @brief This file handles replaying recorded interactions in the viewer
+ * @version 0.1
+ * @date 2024-03-15
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QString>
+#include <vector>
+
+#include "interaction_trace.h"
+#include "viewer_widget.h"
+
+/**
+ * @brief Replayer which feeds recorded events to the viewer frame by frame
+ *
+ * Events up to a frame event are applied, then the viewer is repainted and
+ * the next frame waits for the buffer swap. Time of a frame is measured
+ * from its first event to its swap, so waiting for the original pace of
+ * the trace is not counted.
+ */
+class InteractionReplayer : public QObject {
+  Q_OBJECT
+
+ public:
+  /**
+   * @brief The function handles initializing replayer
+   *
+   * @param viewer The viewer the trace is replayed in
+   * @param parent The parent object
+   * @return InteractionReplayer
+   */
+  explicit InteractionReplayer(viewer_widget *viewer,
+                               QObject *parent = nullptr);
+
+  /**
+   * @brief The function starts replaying the trace
+   *
+   * @param trace The trace, its model must be already opened
+   * @param max_speed True to draw frames one after another, false to keep
+   * time of recorded events
+   * @param report_path File for the report, may be empty
+   */
+  void start(const InteractionTrace &trace, bool max_speed,
+             const QString &report_path);
+
+ signals:
+  /**
+   * @brief The signal is emitted when all events are replayed
+   *
+   * @param ok True if the report is written
+   */
+  void finished(bool ok);
+
+ private slots:
+  /**
+   * @brief The function applies events until the next frame event
+   *
+   */
+  void step();
+
+  /**
+   * @brief The function ends the frame drawn by the viewer
+   *
+   */
+  void frameSwapped();
+
+ private:
+  /**
+   * @brief The function prints and writes the report
+   *
+   */
+  void finish();
+
+  viewer_widget *viewer_;
+  std::vector<InteractionEvent> events_;
+  size_t position_ = 0;
+  bool max_speed_ = true;
+  bool frame_pending_ = false;  // a frame event waits for the swap
+  QString report_path_;
+  QElapsedTimer clock_;        // time since the start of the replay
+  qint64 frame_start_ns_ = 0;  // time of the first event of the frame
+  std::vector<double> frame_ms_;
+};
+
+#endif  // SRC_VIEW_INCLUDE_INTERACTION_REPLAYER_H
@@ -0,0 +1,145 @@
+#ifndef SRC_VIEW_INCLUDE_OFFSCREEN_RENDERER_H
+#define SRC_VIEW_INCLUDE_OFFSCREEN_RENDERER_H
+
+/**
+ * @file offscreen_renderer.h
+ * @author SevenStreams
+ * @brief This file handles rendering of images larger than the window
+ * @version 0.1
+ * @date 2024-03-15
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <QImage>
+#include <QOpenGLExtraFunctions>
+#include <QSize>
+#include <QtGlobal>
+#include <functional>
+
+#include "matrix.h"
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+#include <QOpenGLFramebufferObject>
+#else
+#include <QtOpenGL/QOpenGLFramebufferObject>
+#endif
+
+#define OFFSCREEN_MAX_SIZE 16384
+#define OFFSCREEN_MAX_TILE 4096
+#define OFFSCREEN_READ_BUFFERS 2
+
+/**
+ * @brief Renderer of the scene into an image of any size up to
+ * OFFSCREEN_MAX_SIZE
+ *
+ * The image is split into tiles no larger than the framebuffer object. Each
+ * tile is drawn with a matrix which maps its part of the clip space to the
+ * whole viewport, then read into a pixel buffer object. The buffer of tile N
+ * is copied to the image while GPU draws tile N + 1.
+ */
+class OffscreenRenderer : protected QOpenGLExtraFunctions {
+ public:
+  /**
+   * @brief Draws the scene with the given tile matrix applied to clip space
+   *
+   * Viewport is the size of the tile in pixels, sizes in pixels like line
+   * width are measured in it.
+   */
+  typedef std::function<void(const Matrix4x4 &tile, QSize viewport)>
+      DrawFunction;
+
+  /**
+   * @brief The function handles initializing offscreen renderer
+   *
+   * @return OffscreenRenderer
+   */
+  OffscreenRenderer();
+
+  /**
+   * @brief The function resolves GL functions of current context
+   *
+   */
+  void init();
+
+  /**
+   * @brief The function frees framebuffer and pixel buffers
+   *
+   */
+  void destroy();
+
+  /**
+   * @brief The function renders the scene into an image
+   *
+   * @param size Size of the image, clamped to OFFSCREEN_MAX_SIZE
+   * @param draw Function which draws the scene
+   * @return QImage The image, null if it can not be allocated
+   */
+  QImage render(QSize size, const DrawFunction &draw);
+
+ private:
+  /**
+   * @brief Part of the image drawn in one pass
+   *
+   */
+  struct Tile {
+    int x;       // left column in the image
+    int y;       // top row in the image
+    int width;   // pixels
+    int height;  // pixels
+  };
+
+  /**
+   * @brief The function recreates framebuffer and pixel buffers for tiles
+   *
+   * @param width Width of a tile
+   * @param height Height of a tile
+   */
+  void resize(int width, int height);
+
+  /**
+   * @brief The function returns matrix which maps the tile to clip space
+   *
+   * @param tile The tile
+   * @param size Size of the image
+   * @return Matrix4x4 The matrix
+   */
+  Matrix4x4 tileMatrix(const Tile &tile, QSize size);
+
+  /**
+   * @brief The function starts reading of the drawn tile
+   *
+   * Without pixel buffers the tile is read and stored at once.
+   *
+   * @param tile The tile
+   * @param slot Index of pixel buffer
+   * @param image The image
+   */
+  void readTile(const Tile &tile, int slot, QImage *image);
+
+  /**
+   * @brief The function copies read tile into the image
+   *
+   * @param tile The tile
+   * @param slot Index of pixel buffer
+   * @param image The image
+   */
+  void copyTile(const Tile &tile, int slot, QImage *image);
+
+  /**
+   * @brief The function copies rows of the tile flipped to image rows
+   *
+   * @param pixels Rows from bottom to top
+   * @param tile The tile
+   * @param image The image
+   */
+  void storeRows(const uchar *pixels, const Tile &tile, QImage *image);
+
+  QOpenGLFramebufferObject *fbo_;
+  GLuint read_buffers_[OFFSCREEN_READ_BUFFERS];
+  GLsync read_fences_[OFFSCREEN_READ_BUFFERS];
+  bool async_read_;
+  int max_tile_;
+};
+
+#endif  // SRC_VIEW_INCLUDE_OFFSCREEN_RENDERER_H
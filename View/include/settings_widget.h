@@ -109,6 +109,12 @@ class Settings_widget : public QWidget {
    */
   void EdgesThicknessChanged(double value);
 
+  /**
+   * @brief The function shows settings changed by undo or redo
+   *
+   */
+  void SettingsChangedOutside();
+
  signals:
   void SettingsChanged();
 
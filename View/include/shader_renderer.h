@@ -0,0 +1,171 @@
+#ifndef SRC_VIEW_INCLUDE_SHADER_RENDERER_H
+#define SRC_VIEW_INCLUDE_SHADER_RENDERER_H
+
+/**
+ * @file shader_renderer.h
+ * @author SevenStreams
+ * @brief This file handles drawing of model with core-profile shaders
+ * @version 0.1
+ * @date 2024-03-15
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLShaderProgram>
+#include <vector>
+
+#include "matrix.h"
+#include "meshlet.h"
+
+#define SHADER_RENDERER_STYLE_BINDING 0
+#define SHADER_RENDERER_STIPPLE_PATTERN 0x0101
+
+/**
+ * @brief Appearance of model, the content of the Style uniform block
+ *
+ * Layout matches std140 block of the shaders.
+ */
+struct RenderStyle {
+  float line_color[4];
+  float vertex_color[4];
+  float line_width;     // pixels
+  float point_size;     // pixels
+  int stipple_pattern;  // 16-bit pattern like glLineStipple, 0 for solid
+  int round_points;     // 1 for round markers, 0 for square
+};
+
+/**
+ * @brief Renderer of edges and vertices for core-profile contexts
+ *
+ * Edges are drawn as GL_LINES expanded to quads of line_width pixels by a
+ * geometry shader, stipple is applied in the fragment shader. Vertices are
+ * drawn as point sprites. Appearance is held in one uniform buffer which is
+ * only written by setStyle.
+ */
+class ShaderRenderer : protected QOpenGLExtraFunctions {
+ public:
+  /**
+   * @brief The function handles initializing renderer
+   *
+   * @return ShaderRenderer
+   */
+  ShaderRenderer();
+
+  /**
+   * @brief The function compiles programs and creates buffers in current
+   * context
+   *
+   * @return bool True if programs are compiled and linked
+   */
+  bool init();
+
+  /**
+   * @brief The function frees programs and buffers
+   *
+   */
+  void destroy();
+
+  /**
+   * @brief The function writes the style to the uniform buffer
+   *
+   * @param style The style
+   */
+  void setStyle(const RenderStyle &style);
+
+  /**
+   * @brief The function builds GL_LINES index buffer from triangles
+   *
+   * Every triangle gives three edges, so edge range of triangle index range
+   * (offset, count) is (2 * offset, 2 * count).
+   *
+   * @param indices Triangle indices
+   * @param count Number of indices
+   */
+  void setEdges(const unsigned int *indices, int count);
+
+  /**
+   * @brief The function allocates edges of triangle indices without data
+   *
+   * @param count Number of triangle indices
+   */
+  void reserveEdges(int count);
+
+  /**
+   * @brief The function writes edges of triangles into reserved buffer
+   *
+   * @param indices Triangle indices
+   * @param first Index of indices[0] among all triangle indices
+   * @param count Number of indices
+   */
+  void appendEdges(const unsigned int *indices, int first, int count);
+
+  /**
+   * @brief The function sets buffer with positions of vertices
+   *
+   * @param buffer GL buffer
+   * @param offset Byte offset of the first position
+   * @param quantized True for normalized 16-bit positions, false for floats
+   */
+  void setPositions(GLuint buffer, size_t offset, bool quantized);
+
+  /**
+   * @brief The function sets transform of positions to clip space
+   *
+   * @param mvp Row-major matrix
+   */
+  void setTransform(const Matrix4x4 &mvp);
+
+  /**
+   * @brief The function sets size of viewport for line expansion
+   *
+   * @param width Width in pixels
+   * @param height Height in pixels
+   */
+  void setViewport(int width, int height);
+
+  /**
+   * @brief The function draws edges of visible triangle ranges
+   *
+   * @param ranges Ranges of triangle indices
+   */
+  void drawEdges(const std::vector<IndexRange> &ranges);
+
+  /**
+   * @brief The function draws vertex markers
+   *
+   * @param count Number of vertices
+   */
+  void drawPoints(int count);
+
+ private:
+  /**
+   * @brief The function compiles and links program and binds Style block
+   *
+   * @param program The program
+   * @param vertex Vertex shader source
+   * @param geometry Geometry shader source, may be nullptr
+   * @param fragment Fragment shader source
+   * @return bool True on success
+   */
+  bool buildProgram(QOpenGLShaderProgram *program, const char *vertex,
+                    const char *geometry, const char *fragment);
+
+  /**
+   * @brief The function binds program with current transform and viewport
+   *
+   * @param program The program
+   */
+  void bindProgram(QOpenGLShaderProgram *program);
+
+  QOpenGLShaderProgram *edges_program_;
+  QOpenGLShaderProgram *points_program_;
+  GLuint vao_;
+  GLuint style_buffer_;
+  GLuint edges_buffer_;
+  float mvp_[16];
+  float viewport_[2];
+};
+
+#endif  // SRC_VIEW_INCLUDE_SHADER_RENDERER_H
@@ -0,0 +1,124 @@
+#ifndef SRC_VIEW_INCLUDE_VERTEX_STREAM_H
+#define SRC_VIEW_INCLUDE_VERTEX_STREAM_H
+
+/**
+ * @file vertex_stream.h
+ * @author SevenStreams
+ * @brief This file handles streaming of transformed vertices to GPU
+ * @version 0.1
+ * @date 2024-03-15
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <QOpenGLExtraFunctions>
+
+#include "profiler.h"
+
+#define VERTEX_STREAM_SEGMENTS 3
+#define VERTEX_STREAM_WAIT_TIMEOUT 1000000000
+
+/**
+ * @brief Ring of vertex buffer segments written by CPU and read by GPU
+ *
+ * Storage is allocated once per model. Every frame takes the next of
+ * VERTEX_STREAM_SEGMENTS segments, so CPU writes frame N + 1 while GPU still
+ * reads frame N. A fence after each draw guards the segment from being
+ * overwritten too early. With ARB_buffer_storage the ring is persistently
+ * mapped and written in place, otherwise glBufferSubData is used.
+ */
+class VertexStream : protected QOpenGLExtraFunctions {
+ public:
+  /**
+   * @brief The function handles initializing vertex stream
+   *
+   * @return VertexStream
+   */
+  VertexStream();
+
+  /**
+   * @brief The function resolves GL functions of current context
+   *
+   */
+  void init();
+
+  /**
+   * @brief The function frees buffer and fences
+   *
+   */
+  void destroy();
+
+  /**
+   * @brief The function allocates ring for frames of given size
+   *
+   * @param frame_bytes Size of one frame in bytes
+   */
+  void resize(size_t frame_bytes);
+
+  /**
+   * @brief The function takes the next segment and waits until GPU is done
+   * with it
+   *
+   * @return void* Pointer to write the frame to if the ring is persistently
+   * mapped, nullptr if the frame has to be passed to endWrite
+   */
+  void *beginWrite();
+
+  /**
+   * @brief The function finishes writing of the frame
+   *
+   * @param data Frame to copy when the ring is not mapped, ignored otherwise
+   * @param bytes Written part of the frame
+   */
+  void endWrite(const void *data, size_t bytes);
+
+  /**
+   * @brief The function puts fence after the draw which reads current segment
+   *
+   */
+  void fence();
+
+  /**
+   * @brief The function returns GL buffer of the ring
+   *
+   * @return GLuint The buffer
+   */
+  GLuint buffer() const;
+
+  /**
+   * @brief The function returns byte offset of the last written frame
+   *
+   * @return size_t The offset
+   */
+  size_t offset() const;
+
+  /**
+   * @brief The function returns if the ring is persistently mapped
+   *
+   * @return bool True for persistent mapping
+   */
+  bool persistent() const;
+
+ private:
+  typedef void (*BufferStorageFunction)(GLenum target, GLsizeiptr size,
+                                        const void *data, GLbitfield flags);
+
+  /**
+   * @brief The function waits for the fence of the segment and deletes it
+   *
+   * @param segment Index of segment
+   */
+  void waitSegment(int segment);
+
+  GLuint buffer_;
+  size_t frame_bytes_;
+  int segment_;
+  GLsync fences_[VERTEX_STREAM_SEGMENTS];
+  void *mapped_;
+  bool fences_available_;
+  BufferStorageFunction buffer_storage_;
+  Profiler::Clock::time_point write_start_;
+};
+
+#endif  // SRC_VIEW_INCLUDE_VERTEX_STREAM_H
@@ -14,12 +14,15 @@
  */
 
 #include <QFileDialog>
+#include <QInputDialog>
 #include <QMainWindow>
 #include <QMessageBox>
 #include <QMovie>
 
 #include "controller.h"
-#include "qgifimage.h"
+#include "gif_capture.h"
+#include "image_writer.h"
+#include "interaction_replayer.h"
 #include "settings_path.h"
 #include "settings_widget.h"
 
@@ -57,6 +60,18 @@ class View : public QMainWindow {
    */
   void startEventLoop();
 
+  /**
+   * @brief The function opens the model of the trace and replays the trace
+   *
+   * @param trace_path Path of the trace saved by the record action
+   * @param max_speed True to draw frames without waiting for recorded time
+   * @param report_path File for the frame time report, may be empty
+   * @return true if the replay is started, finished() of the replayer
+   * quits the application
+   */
+  bool replay(const QString &trace_path, bool max_speed,
+              const QString &report_path);
+
  private slots:
   /**
    * @brief The function handles opening settings
@@ -70,6 +85,13 @@ class View : public QMainWindow {
    */
   void FileOpenClicked();
 
+  /**
+   * @brief The function shows the model loaded in background or its error
+   *
+   * @param error The error code of the model
+   */
+  void ModelSwapped(int error);
+
   /**
    * @brief The function saving image
    *
@@ -83,11 +105,58 @@ class View : public QMainWindow {
   void SaveAsGifClicked();
 
   /**
-   * @brief The function handles timer for gif
+   * @brief The function reports result of background image writing
+   *
+   * @param file_name Path of the file
+   * @param ok True if the image is written
+   */
+  void ImageWritten(QString file_name, bool ok);
+
+  /**
+   * @brief The function starts rendering turntable frames into gif
+   *
+   * Controls which change the model are disabled until all frames are
+   * rendered.
+   *
+   * @param axis Axis of rotation
+   * @param fileName Path of the file
+   */
+  void captureGif(v_capture_axis axis, QString fileName);
+
+  /**
+   * @brief The function enables controls after the last frame of the gif
+   *
+   */
+  void GifFramesCaptured();
+
+  /**
+   * @brief The function reports result of background gif writing
+   *
+   * @param file_name Path of the file
+   * @param ok True if the gif is written
+   */
+  void GifWritten(QString file_name, bool ok);
+
+  /**
+   * @brief The function starts recording of trace spans or stops it and
+   * saves them as Chrome trace JSON
    *
-   * @param event The timer event
    */
-  void timerEvent(QTimerEvent *event) override;
+  void TraceClicked();
+
+  /**
+   * @brief The function sets if models are drawn while they are loaded
+   *
+   * @param enabled True to draw loaded batches
+   */
+  void ProgressiveToggled(bool enabled);
+
+  /**
+   * @brief The function starts recording of interactions or stops it and
+   * saves them for replay
+   *
+   */
+  void RecordClicked();
 
   /**
    * @brief The function rotates model
@@ -128,6 +197,18 @@ class View : public QMainWindow {
    */
   void translationSliderZHandler(int value);
 
+  /**
+   * @brief The function starts the step of a slider drag
+   *
+   */
+  void SliderPressed();
+
+  /**
+   * @brief The function ends the step of a slider drag
+   *
+   */
+  void SliderReleased();
+
   /**
    * @brief The function resets values
    *
@@ -143,8 +224,11 @@ class View : public QMainWindow {
   Controller *controller;
   Ui::View *ui;
   Settings_widget *settings_widget;
-  QGifImage *gif_;
-  int gif_iterator_;
+  QAction *trace_action_;
+  QAction *record_action_;
+  ImageWriter *image_writer_;
+  GifCapture *gif_capture_;
+  InteractionTrace interactions_;
 
  protected:
   /**
@@ -161,6 +245,20 @@ class View : public QMainWindow {
    */
   void ErrorMessage(Controller::string error);
 
+  /**
+   * @brief The function opens the model and shows its numbers
+   *
+   * @param fileName Path of the model
+   * @return bool True if the model is opened
+   */
+  bool openFile(const QString &fileName);
+
+  /**
+   * @brief The function shows name and numbers of the drawn model
+   *
+   */
+  void showModelInfo();
+
   /**
    * @brief The function sets number of vertices
    *
@@ -1,6 +1,7 @@
 #ifndef SRC_VIEW_INCLUDE_VIEWER_WIDGET_H
 #define SRC_VIEW_INCLUDE_VIEWER_WIDGET_H
 #define GL_SILENCE_DEPRECATION
+#define TIMER_QUERIES_COUNT 3
 
 /**
  * @file viewer_widget.h
@@ -19,27 +20,24 @@
 #include <QtGlobal>
 
 #include "controller.h"
+#include "offscreen_renderer.h"
+#include "shader_renderer.h"
 #include "strategies.h"
+#include "vertex_stream.h"
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
-#include <QOpenGLFunctions_3_3_Compatibility>
 #include <QOpenGLWidget>
 #else
-#include <QOpenGLFunctions>
 #include <QtOpenGLWidgets/QOpenGLWidget>
 #endif
 #include <QOpenGLBuffer>
+#include <QOpenGLExtraFunctions>
 #include <QOpenGLShaderProgram>
+#include <QOpenGLTimerQuery>
 
 /**
  * @brief The viewer widget class
  */
-class viewer_widget : public QOpenGLWidget,
-#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
-                      protected QOpenGLFunctions_3_3_Compatibility
-#else
-                      protected QOpenGLFunctions
-#endif
-{
+class viewer_widget : public QOpenGLWidget, protected QOpenGLExtraFunctions {
   Q_OBJECT
 
  public:
@@ -81,10 +79,50 @@ class viewer_widget : public QOpenGLWidget,
    */
   void changeModel();
 
+  /**
+   * @brief The function shows or hides the performance overlay
+   *
+   * @param visible True to show overlay
+   */
+  void setOverlayVisible(bool visible);
+
+  /**
+   * @brief The function returns if the performance overlay is shown
+   *
+   * @return bool True if overlay is shown
+   */
+  bool getOverlayVisible();
+
+  /**
+   * @brief The function renders current scene into an image of given size
+   *
+   * @param size Size of the image, up to OFFSCREEN_MAX_SIZE
+   * @return QImage The image
+   */
+  QImage renderImage(QSize size);
+
+  /**
+   * @brief The function applies the recorded event and shows its values
+   *
+   * Settings are not saved, the replay leaves them as they were.
+   *
+   * @param event The event
+   */
+  void replayEvent(const InteractionEvent &event);
+
  signals:
   void changeRotationAngles();
   void changeScaling();
   void changeTranslation();
+  void changeSettings();
+
+  /**
+   * @brief The signal is emitted when a model loaded in background is
+   * swapped in, or failed to load
+   *
+   * @param error The error code of the model
+   */
+  void modelSwapped(int error);
 
  private slots:
   /**
@@ -149,12 +187,72 @@ class viewer_widget : public QOpenGLWidget,
    */
   void initializeGL();
 
+  /**
+   * @brief The function handles resizing of GL surface
+   *
+   * @param w The width
+   * @param h The height
+   */
+  void resizeGL(int w, int h);
+
   /**
    * @brief The function paints model
    *
    */
   void paintGL();
 
+  /**
+   * @brief The function draws edges and vertices of model
+   *
+   */
+  void drawModel();
+
+  /**
+   * @brief The function appends batches of the loading model to the
+   * reserved buffers
+   *
+   * @param mesh Batches of the model
+   */
+  void uploadProgressiveBatch(ProgressiveMesh *mesh);
+
+  /**
+   * @brief The function draws the part of the model loaded so far
+   *
+   */
+  void drawProgressive();
+
+  /**
+   * @brief The function frees buffers of the loaded model
+   *
+   */
+  void resetProgressiveBuffers();
+
+  /**
+   * @brief The function draws points for visible meshlets which are not in
+   * memory
+   *
+   */
+  void drawProxies();
+
+  /**
+   * @brief The function draws model with fixed-function state
+   *
+   * It is used when the context is not a core profile.
+   */
+  void drawLegacy();
+
+  /**
+   * @brief The function draws model with shader renderer
+   *
+   */
+  void drawShaded();
+
+  /**
+   * @brief The function writes settings to the style of shader renderer
+   *
+   */
+  void applyStyle();
+
   /**
    * @brief The function handles wheeling model
    *
@@ -191,13 +289,72 @@ class viewer_widget : public QOpenGLWidget,
   void keyPressEvent(QKeyEvent *event);
 
   /**
-   * @brief The function updates buffers
+   * @brief The function transforms vertices into the next segment of stream
    *
+   * It is called once per frame from paintGL, event handlers only request
+   * repaint.
    */
   void updateVertexBuffer();
 
   /**
-   * @brief The function enables settings
+   * @brief The function makes the model loaded in background the drawn one
+   *
+   */
+  void applyStagedModel();
+
+  /**
+   * @brief The function uploads edges and resizes buffers for new model
+   *
+   */
+  void uploadModelBuffers();
+
+  /**
+   * @brief The function uploads indices of the transformed vertices
+   *
+   * Out of core model uploads them whenever its drawn meshlets change.
+   */
+  void uploadIndices();
+
+  /**
+   * @brief The function uploads 16-bit positions of model once
+   *
+   */
+  void uploadQuantizedBuffer();
+
+  /**
+   * @brief The function loads row-major matrix into GL modelview matrix
+   *
+   * @param matrix The matrix
+   */
+  void loadGLMatrix(const Matrix4x4 &matrix);
+
+  /**
+   * @brief The function creates GL timer queries for GPU time
+   *
+   */
+  void initTimerQueries();
+
+  /**
+   * @brief The function starts GPU timing of the frame
+   *
+   * The result of the query is read a few frames later to avoid stalls.
+   */
+  void beginGpuTimer();
+
+  /**
+   * @brief The function stops GPU timing of the frame
+   *
+   */
+  void endGpuTimer();
+
+  /**
+   * @brief The function paints FPS and stage timings over the model
+   *
+   */
+  void paintOverlay();
+
+  /**
+   * @brief The function enables settings in fixed-function state
    *
    */
   void enableSettings();
@@ -208,11 +365,41 @@ class viewer_widget : public QOpenGLWidget,
    */
   void ResetState();
 
+  /**
+   * @brief The function shows values restored by undo or redo
+   *
+   */
+  void historyChanged();
+
+  /**
+   * @brief The function shows values changed not by this widget
+   *
+   */
+  void showValues();
+
  private:
   Controller *controller;
   ContextStrategy context;
   bool dragging = false;
   int last_x, last_y;
+  bool overlay_visible_ = false;
+  QOpenGLTimerQuery *gpu_queries_[TIMER_QUERIES_COUNT] = {};
+  bool gpu_query_pending_[TIMER_QUERIES_COUNT] = {};
+  int gpu_query_index_ = 0;
+  VertexStream stream_;
+  ShaderRenderer renderer_;
+  OffscreenRenderer offscreen_;
+  Matrix4x4 tile_matrix_;  // maps part of clip space to offscreen tile
+  bool core_profile_ = false;
+  bool style_dirty_ = true;
+  GLuint progressive_vbo_ = 0;  // positions of the loading model
+  GLuint progressive_ebo_ = 0;  // triangles of the legacy profile
+  GLuint proxy_vbo_ = 0;        // centers of meshlets out of memory
+  size_t progressive_vertices_ = 0;  // uploaded to the buffers
+  size_t progressive_indices_ = 0;
+  size_t progressive_vertices_capacity_ = 0;
+  size_t progressive_indices_capacity_ = 0;
+  uint64_t progressive_generation_ = 0;  // of the uploaded batches
 };
 
 #endif  // SRC_VIEW_INCLUDE_VIEWER_WIDGET_H
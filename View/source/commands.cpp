@@ -1,31 +1,39 @@
 #include "commands.h"
 
 void ProjectionTypeChange::execute() {
-  controller_->setProjectionType(index);
+  controller_->execute(v_command_projection_type, index);
 }
 
-void EdgesTypeChange::execute() { controller_->setLineType(index); }
+void EdgesTypeChange::execute() {
+  controller_->execute(v_command_line_type, index);
+}
 
-void DisplayTypeChange::execute() { controller_->setDisplayType(index); }
+void DisplayTypeChange::execute() {
+  controller_->execute(v_command_display_type, index);
+}
 
-void VerticesSizeChange::execute() { controller_->setVertexSize(value); }
+void VerticesSizeChange::execute() {
+  controller_->execute(v_command_vertex_size, value);
+}
 
-void EdgesThicknessChange::execute() { controller_->setLineWidth(value); }
+void EdgesThicknessChange::execute() {
+  controller_->execute(v_command_line_width, value);
+}
 
 void BackgroundColorChange::execute() {
-  controller_->setBackgroundColorR(color.red() / 255.0f);
-  controller_->setBackgroundColorG(color.green() / 255.0f);
-  controller_->setBackgroundColorB(color.blue() / 255.0f);
+  controller_->execute(v_command_background_color,
+                       Vector3(color.red() / 255.0f, color.green() / 255.0f,
+                               color.blue() / 255.0f));
 }
 
 void EdgesColorChange::execute() {
-  controller_->setLineColorR(color.red() / 255.0f);
-  controller_->setLineColorG(color.green() / 255.0f);
-  controller_->setLineColorB(color.blue() / 255.0f);
+  controller_->execute(v_command_line_color,
+                       Vector3(color.red() / 255.0f, color.green() / 255.0f,
+                               color.blue() / 255.0f));
 }
 
 void VerticesColorChange::execute() {
-  controller_->setVerticesColorR(color.red() / 255.0f);
-  controller_->setVerticesColorG(color.green() / 255.0f);
-  controller_->setVerticesColorB(color.blue() / 255.0f);
+  controller_->execute(v_command_vertices_color,
+                       Vector3(color.red() / 255.0f, color.green() / 255.0f,
+                               color.blue() / 255.0f));
 }
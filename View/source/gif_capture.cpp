@@ -0,0 +1,70 @@
+#include "gif_capture.h"
+
+#include "tracer.h"
+
+GifCapture::GifCapture(viewer_widget *viewer, Controller *controller,
+                       QObject *parent)
+    : QObject(parent),
+      viewer_(viewer),
+      controller_(controller),
+      frame_(0),
+      running_(false) {
+  // zero interval runs the slot once per turn of the event loop
+  timer_.setInterval(0);
+  connect(&timer_, SIGNAL(timeout()), SLOT(captureFrame()));
+}
+
+GifCapture::~GifCapture() {
+  if (timer_.isActive()) {
+    timer_.stop();
+    controller_->endCapture();
+    writer_->close();
+  }
+  if (closer_.joinable()) closer_.join();
+}
+
+bool GifCapture::start(v_capture_axis axis, const QString &file_name) {
+  if (running_) return false;
+  if (closer_.joinable()) closer_.join();
+  writer_.reset(
+      new QGifStreamWriter(QSize(GIF_WIDTH, GIF_HEIGHT), GIF_QUEUE_CAPACITY));
+  writer_->setDefaultDelay(GIF_FRAME_DELAY);
+  if (!writer_->open(file_name)) {
+    writer_.reset();
+    return false;
+  }
+  file_name_ = file_name;
+  frame_ = 0;
+  running_ = true;
+  controller_->beginCapture(axis, GIF_FRAMES_COUNT);
+  timer_.start();
+  return true;
+}
+
+bool GifCapture::isRunning() const { return running_; }
+
+void GifCapture::captureFrame() {
+  TRACE_SCOPE("GifCapture::captureFrame");
+  // frames are rendered at exact angles, the writer thread encodes one
+  // while the next one is rendered
+  controller_->setCaptureFrame(frame_);
+  writer_->addFrame(viewer_->renderImage(QSize(GIF_WIDTH, GIF_HEIGHT)));
+  viewer_->update();
+  if (++frame_ >= controller_->getCaptureFramesCount()) finish();
+}
+
+void GifCapture::finish() {
+  timer_.stop();
+  controller_->endCapture();
+  viewer_->update();
+  emit framesCaptured();
+  QGifStreamWriter *writer = writer_.get();
+  QString file_name = file_name_;
+  // the writer waits for the encoder of the last frames
+  closer_ = std::thread([this, writer, file_name]() {
+    TRACE_SCOPE("GifCapture::close");
+    bool ok = writer->close();
+    running_ = false;
+    emit finished(file_name, ok);
+  });
+}
@@ -0,0 +1,18 @@
+#include "image_writer.h"
+
+#include "tracer.h"
+
+ImageWriter::ImageWriter(QObject *parent) : QObject(parent) {}
+
+ImageWriter::~ImageWriter() {
+  if (worker_.joinable()) worker_.join();
+}
+
+void ImageWriter::write(const QImage &image, const QString &file_name) {
+  if (worker_.joinable()) worker_.join();
+  worker_ = std::thread([this, image, file_name]() {
+    TRACE_SCOPE("ImageWriter::write");
+    bool ok = image.save(file_name);
+    emit written(file_name, ok);
+  });
+}
@@ -0,0 +1,71 @@
+#include "interaction_replayer.h"
+
+#include <QFile>
+#include <QTimer>
+#include <cstdio>
+
+InteractionReplayer::InteractionReplayer(viewer_widget *viewer,
+                                         QObject *parent)
+    : QObject(parent), viewer_(viewer) {
+  connect(viewer_, SIGNAL(frameSwapped()), SLOT(frameSwapped()));
+}
+
+void InteractionReplayer::start(const InteractionTrace &trace, bool max_speed,
+                                const QString &report_path) {
+  events_ = trace.getEvents();
+  position_ = 0;
+  max_speed_ = max_speed;
+  frame_pending_ = false;
+  report_path_ = report_path;
+  frame_ms_.clear();
+  frame_ms_.reserve(trace.getFramesCount());
+  clock_.start();
+  frame_start_ns_ = -1;
+  step();
+}
+
+void InteractionReplayer::step() {
+  while (position_ < events_.size()) {
+    const InteractionEvent &event = events_[position_];
+    if (!max_speed_) {
+      qint64 wait_ms = event.time_us / 1000 - clock_.elapsed();
+      if (wait_ms > 0) {
+        QTimer::singleShot((int)wait_ms, this, SLOT(step()));
+        return;
+      }
+    }
+    if (frame_start_ns_ < 0) frame_start_ns_ = clock_.nsecsElapsed();
+    ++position_;
+    if (event.type == v_interaction_frame) {
+      frame_pending_ = true;
+      viewer_->update();
+      return;
+    }
+    viewer_->replayEvent(event);
+  }
+  finish();
+}
+
+void InteractionReplayer::frameSwapped() {
+  if (!frame_pending_) return;
+  frame_pending_ = false;
+  frame_ms_.push_back((clock_.nsecsElapsed() - frame_start_ns_) / 1e6);
+  frame_start_ns_ = -1;
+  // the next frame starts from the event loop, so input and timers of
+  // the window are handled as during recording
+  QTimer::singleShot(0, this, SLOT(step()));
+}
+
+void InteractionReplayer::finish() {
+  ReplayReport report = InteractionTrace::makeReport(frame_ms_);
+  std::string text = report.toString();
+  fputs(text.c_str(), stdout);
+  fflush(stdout);
+  bool ok = true;
+  if (!report_path_.isEmpty()) {
+    QFile file(report_path_);
+    ok = file.open(QIODevice::WriteOnly | QIODevice::Text) &&
+         file.write(text.c_str(), text.size()) == (qint64)text.size();
+  }
+  emit finished(ok);
+}
@@ -0,0 +1,147 @@
+#include "offscreen_renderer.h"
+
+#include <QOpenGLContext>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "matrix_generator.h"
+#include "tracer.h"
+
+OffscreenRenderer::OffscreenRenderer()
+    : fbo_(nullptr),
+      read_buffers_(),
+      read_fences_(),
+      async_read_(false),
+      max_tile_(OFFSCREEN_MAX_TILE) {}
+
+void OffscreenRenderer::init() {
+  initializeOpenGLFunctions();
+  QSurfaceFormat format = QOpenGLContext::currentContext()->format();
+  // fences for asynchronous reading are GL 3.2+ / ES 3.0+
+  async_read_ = format.version() >= qMakePair(3, 2) ||
+                (format.renderableType() == QSurfaceFormat::OpenGLES &&
+                 format.majorVersion() >= 3);
+  GLint renderbuffer_size = 0, viewport_dims[2] = {0, 0};
+  glGetIntegerv(GL_MAX_RENDERBUFFER_SIZE, &renderbuffer_size);
+  glGetIntegerv(GL_MAX_VIEWPORT_DIMS, viewport_dims);
+  max_tile_ = std::min({OFFSCREEN_MAX_TILE, (int)renderbuffer_size,
+                        (int)viewport_dims[0], (int)viewport_dims[1]});
+  if (max_tile_ <= 0) max_tile_ = 512;
+}
+
+void OffscreenRenderer::destroy() {
+  delete fbo_;
+  fbo_ = nullptr;
+  for (int i = 0; i < OFFSCREEN_READ_BUFFERS; ++i) {
+    if (read_fences_[i]) glDeleteSync(read_fences_[i]);
+    read_fences_[i] = nullptr;
+  }
+  if (read_buffers_[0]) glDeleteBuffers(OFFSCREEN_READ_BUFFERS, read_buffers_);
+  std::fill(read_buffers_, read_buffers_ + OFFSCREEN_READ_BUFFERS, 0);
+}
+
+void OffscreenRenderer::resize(int width, int height) {
+  if (fbo_ && fbo_->width() == width && fbo_->height() == height) return;
+  destroy();
+  fbo_ = new QOpenGLFramebufferObject(width, height);
+  if (async_read_) {
+    glGenBuffers(OFFSCREEN_READ_BUFFERS, read_buffers_);
+    for (int i = 0; i < OFFSCREEN_READ_BUFFERS; ++i) {
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, read_buffers_[i]);
+      glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)width * height * 4,
+                   nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  }
+}
+
+QImage OffscreenRenderer::render(QSize size, const DrawFunction &draw) {
+  TRACE_SCOPE("OffscreenRenderer::render");
+  size = size.boundedTo(QSize(OFFSCREEN_MAX_SIZE, OFFSCREEN_MAX_SIZE))
+             .expandedTo(QSize(1, 1));
+  QImage image(size, QImage::Format_RGBA8888);
+  if (image.isNull()) return image;
+
+  std::vector<Tile> tiles;
+  int tile_width = std::min(size.width(), max_tile_);
+  int tile_height = std::min(size.height(), max_tile_);
+  for (int y = 0; y < size.height(); y += tile_height) {
+    for (int x = 0; x < size.width(); x += tile_width) {
+      tiles.push_back({x, y, std::min(tile_width, size.width() - x),
+                       std::min(tile_height, size.height() - y)});
+    }
+  }
+
+  GLint viewport[4];
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  resize(tile_width, tile_height);
+  fbo_->bind();
+  for (size_t i = 0; i < tiles.size(); ++i) {
+    glViewport(0, 0, tiles[i].width, tiles[i].height);
+    draw(tileMatrix(tiles[i], size), QSize(tiles[i].width, tiles[i].height));
+    readTile(tiles[i], i % OFFSCREEN_READ_BUFFERS, &image);
+    // the previous tile is copied while GPU works on this one
+    if (i > 0) copyTile(tiles[i - 1], (i - 1) % OFFSCREEN_READ_BUFFERS, &image);
+  }
+  copyTile(tiles.back(), (tiles.size() - 1) % OFFSCREEN_READ_BUFFERS, &image);
+  fbo_->release();
+  glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+  return image;
+}
+
+Matrix4x4 OffscreenRenderer::tileMatrix(const Tile &tile, QSize size) {
+  float width = size.width(), height = size.height();
+  // GL rows go from the bottom of the image
+  float bottom = height - tile.y - tile.height;
+  Matrix4x4 matrix = MatrixGenerator().generate_identity();
+  matrix(0, 0) = width / tile.width;
+  matrix(0, 3) = (width - 2.0f * tile.x - tile.width) / tile.width;
+  matrix(1, 1) = height / tile.height;
+  matrix(1, 3) = (height - 2.0f * bottom - tile.height) / tile.height;
+  return matrix;
+}
+
+void OffscreenRenderer::readTile(const Tile &tile, int slot, QImage *image) {
+  if (!async_read_) {
+    std::vector<uchar> pixels((size_t)tile.width * tile.height * 4);
+    glReadPixels(0, 0, tile.width, tile.height, GL_RGBA, GL_UNSIGNED_BYTE,
+                 pixels.data());
+    storeRows(pixels.data(), tile, image);
+    return;
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, read_buffers_[slot]);
+  glReadPixels(0, 0, tile.width, tile.height, GL_RGBA, GL_UNSIGNED_BYTE,
+               nullptr);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  read_fences_[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void OffscreenRenderer::copyTile(const Tile &tile, int slot, QImage *image) {
+  if (!async_read_ || !read_fences_[slot]) return;
+  TRACE_SCOPE("OffscreenRenderer::copyTile");
+  glClientWaitSync(read_fences_[slot], GL_SYNC_FLUSH_COMMANDS_BIT,
+                   GL_TIMEOUT_IGNORED);
+  glDeleteSync(read_fences_[slot]);
+  read_fences_[slot] = nullptr;
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, read_buffers_[slot]);
+  const uchar *pixels = static_cast<const uchar *>(
+      glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+                       (GLsizeiptr)tile.width * tile.height * 4,
+                       GL_MAP_READ_BIT));
+  if (pixels) {
+    storeRows(pixels, tile, image);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void OffscreenRenderer::storeRows(const uchar *pixels, const Tile &tile,
+                                  QImage *image) {
+  size_t row_bytes = (size_t)tile.width * 4;
+  for (int row = 0; row < tile.height; ++row) {
+    uchar *line = image->scanLine(tile.y + tile.height - 1 - row);
+    std::memcpy(line + (size_t)tile.x * 4, pixels + row * row_bytes,
+                row_bytes);
+  }
+}
@@ -38,6 +38,8 @@ Settings_widget::Settings_widget(viewer_widget *view_field,
   connect(ui->size_vertices_box, SIGNAL(valueChanged(double)),
           SLOT(VerticesSizeChanged(double)));
   connect(this, SIGNAL(SettingsChanged()), view_field_, SLOT(updateSettings()));
+  connect(view_field_, SIGNAL(changeSettings()),
+          SLOT(SettingsChangedOutside()));
 }
 
 Settings_widget::~Settings_widget() {
@@ -109,6 +111,16 @@ void Settings_widget::ChangeFrameColor(QFrame *frame, int red, int green,
   frame->setStyleSheet(str);
 }
 
+void Settings_widget::SettingsChangedOutside() {
+  // restored values must not be recorded as new commands
+  QList<QWidget *> boxes = {ui->thickness_edges_box, ui->size_vertices_box,
+                            ui->Type_edg_box, ui->Display_edg_box,
+                            ui->Type_proj_box};
+  for (QWidget *box : boxes) box->blockSignals(true);
+  InitializeElements();
+  for (QWidget *box : boxes) box->blockSignals(false);
+}
+
 void Settings_widget::InitializeElements() {
   ChangeFrameColor(ui->background_color_frame,
                    controller_->getBackgroundColor().r() * 255,
@@ -0,0 +1,237 @@
+#include "shader_renderer.h"
+
+#include <QMatrix4x4>
+#include <QVector2D>
+
+#ifndef GL_PROGRAM_POINT_SIZE
+#define GL_PROGRAM_POINT_SIZE 0x8642
+#endif
+
+#define SHADER_STYLE_BLOCK           \
+  "layout(std140) uniform Style {\n" \
+  "  vec4 line_color;\n"             \
+  "  vec4 vertex_color;\n"           \
+  "  float line_width;\n"            \
+  "  float point_size;\n"            \
+  "  int stipple_pattern;\n"         \
+  "  int round_points;\n"            \
+  "};\n"
+
+static const char *vertex_source =
+    "#version 330 core\n" SHADER_STYLE_BLOCK
+    "layout(location = 0) in vec3 position;\n"
+    "uniform mat4 mvp;\n"
+    "void main() {\n"
+    "  gl_Position = mvp * vec4(position, 1.0);\n"
+    "  gl_PointSize = point_size;\n"
+    "}\n";
+
+// expands a line to a quad of line_width pixels in screen space
+static const char *edges_geometry_source =
+    "#version 330 core\n" SHADER_STYLE_BLOCK
+    "layout(lines) in;\n"
+    "layout(triangle_strip, max_vertices = 4) out;\n"
+    "uniform vec2 viewport;\n"
+    "noperspective out float line_distance;\n"
+    "void main() {\n"
+    "  vec4 p0 = gl_in[0].gl_Position;\n"
+    "  vec4 p1 = gl_in[1].gl_Position;\n"
+    "  if (p0.w <= 0.0 || p1.w <= 0.0) return;\n"
+    "  vec2 s0 = p0.xy / p0.w * 0.5 * viewport;\n"
+    "  vec2 s1 = p1.xy / p1.w * 0.5 * viewport;\n"
+    "  float len = length(s1 - s0);\n"
+    "  vec2 normal = len > 0.0 ? vec2(s0.y - s1.y, s1.x - s0.x) / len\n"
+    "                          : vec2(0.0, 1.0);\n"
+    "  vec2 offset = normal * max(line_width, 1.0) / viewport;\n"
+    "  line_distance = 0.0;\n"
+    "  gl_Position = vec4(p0.xy + offset * p0.w, p0.zw);\n"
+    "  EmitVertex();\n"
+    "  gl_Position = vec4(p0.xy - offset * p0.w, p0.zw);\n"
+    "  EmitVertex();\n"
+    "  line_distance = len;\n"
+    "  gl_Position = vec4(p1.xy + offset * p1.w, p1.zw);\n"
+    "  EmitVertex();\n"
+    "  gl_Position = vec4(p1.xy - offset * p1.w, p1.zw);\n"
+    "  EmitVertex();\n"
+    "  EndPrimitive();\n"
+    "}\n";
+
+// one bit of the pattern per pixel along the line, like glLineStipple(1, p)
+static const char *edges_fragment_source =
+    "#version 330 core\n" SHADER_STYLE_BLOCK
+    "noperspective in float line_distance;\n"
+    "out vec4 color;\n"
+    "void main() {\n"
+    "  if (stipple_pattern != 0) {\n"
+    "    int bit = int(mod(line_distance, 16.0));\n"
+    "    if (((stipple_pattern >> bit) & 1) == 0) discard;\n"
+    "  }\n"
+    "  color = line_color;\n"
+    "}\n";
+
+static const char *points_fragment_source =
+    "#version 330 core\n" SHADER_STYLE_BLOCK
+    "out vec4 color;\n"
+    "void main() {\n"
+    "  if (round_points != 0 && length(gl_PointCoord - vec2(0.5)) > 0.5)\n"
+    "    discard;\n"
+    "  color = vertex_color;\n"
+    "}\n";
+
+ShaderRenderer::ShaderRenderer()
+    : edges_program_(nullptr),
+      points_program_(nullptr),
+      vao_(0),
+      style_buffer_(0),
+      edges_buffer_(0),
+      mvp_{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1},
+      viewport_{1, 1} {}
+
+bool ShaderRenderer::init() {
+  initializeOpenGLFunctions();
+  edges_program_ = new QOpenGLShaderProgram();
+  points_program_ = new QOpenGLShaderProgram();
+  if (!buildProgram(edges_program_, vertex_source, edges_geometry_source,
+                    edges_fragment_source) ||
+      !buildProgram(points_program_, vertex_source, nullptr,
+                    points_fragment_source)) {
+    destroy();
+    return false;
+  }
+
+  glGenVertexArrays(1, &vao_);
+  glGenBuffers(1, &edges_buffer_);
+  glGenBuffers(1, &style_buffer_);
+  glBindBuffer(GL_UNIFORM_BUFFER, style_buffer_);
+  glBufferData(GL_UNIFORM_BUFFER, sizeof(RenderStyle), nullptr,
+               GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  return true;
+}
+
+bool ShaderRenderer::buildProgram(QOpenGLShaderProgram *program,
+                                  const char *vertex, const char *geometry,
+                                  const char *fragment) {
+  bool ok =
+      program->addShaderFromSourceCode(QOpenGLShader::Vertex, vertex) &&
+      program->addShaderFromSourceCode(QOpenGLShader::Fragment, fragment);
+  if (ok && geometry) {
+    ok = program->addShaderFromSourceCode(QOpenGLShader::Geometry, geometry);
+  }
+  if (ok) ok = program->link();
+  if (ok) {
+    GLuint block = glGetUniformBlockIndex(program->programId(), "Style");
+    if (block == GL_INVALID_INDEX) return false;
+    glUniformBlockBinding(program->programId(), block,
+                          SHADER_RENDERER_STYLE_BINDING);
+  }
+  return ok;
+}
+
+void ShaderRenderer::destroy() {
+  delete edges_program_;
+  delete points_program_;
+  edges_program_ = nullptr;
+  points_program_ = nullptr;
+  if (vao_) glDeleteVertexArrays(1, &vao_);
+  if (edges_buffer_) glDeleteBuffers(1, &edges_buffer_);
+  if (style_buffer_) glDeleteBuffers(1, &style_buffer_);
+  vao_ = edges_buffer_ = style_buffer_ = 0;
+}
+
+void ShaderRenderer::setStyle(const RenderStyle &style) {
+  glBindBuffer(GL_UNIFORM_BUFFER, style_buffer_);
+  glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(RenderStyle), &style);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+static std::vector<unsigned int> makeEdges(const unsigned int *indices,
+                                           int count) {
+  std::vector<unsigned int> edges;
+  edges.reserve(count * 2);
+  for (int i = 0; i + 2 < count; i += 3) {
+    unsigned int a = indices[i], b = indices[i + 1], c = indices[i + 2];
+    edges.insert(edges.end(), {a, b, b, c, c, a});
+  }
+  return edges;
+}
+
+void ShaderRenderer::setEdges(const unsigned int *indices, int count) {
+  std::vector<unsigned int> edges = makeEdges(indices, count);
+  glBindVertexArray(vao_);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, edges_buffer_);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * edges.size(),
+               edges.data(), GL_STATIC_DRAW);
+  glBindVertexArray(0);
+}
+
+void ShaderRenderer::reserveEdges(int count) {
+  glBindVertexArray(vao_);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, edges_buffer_);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * count * 2,
+               nullptr, GL_STATIC_DRAW);
+  glBindVertexArray(0);
+}
+
+void ShaderRenderer::appendEdges(const unsigned int *indices, int first,
+                                 int count) {
+  std::vector<unsigned int> edges = makeEdges(indices, count);
+  glBindVertexArray(vao_);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, edges_buffer_);
+  glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * first * 2,
+                  sizeof(unsigned int) * edges.size(), edges.data());
+  glBindVertexArray(0);
+}
+
+void ShaderRenderer::setPositions(GLuint buffer, size_t offset,
+                                  bool quantized) {
+  glBindVertexArray(vao_);
+  glBindBuffer(GL_ARRAY_BUFFER, buffer);
+  glEnableVertexAttribArray(0);
+  if (quantized) {
+    glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, 0,
+                          (const void *)offset);
+  } else {
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (const void *)offset);
+  }
+  glBindVertexArray(0);
+}
+
+void ShaderRenderer::setTransform(const Matrix4x4 &mvp) {
+  for (int row = 0; row < 4; ++row) {
+    for (int col = 0; col < 4; ++col) mvp_[row * 4 + col] = mvp(row, col);
+  }
+}
+
+void ShaderRenderer::setViewport(int width, int height) {
+  viewport_[0] = width > 0 ? width : 1;
+  viewport_[1] = height > 0 ? height : 1;
+}
+
+void ShaderRenderer::bindProgram(QOpenGLShaderProgram *program) {
+  program->bind();
+  program->setUniformValue("mvp", QMatrix4x4(mvp_));
+  program->setUniformValue("viewport", QVector2D(viewport_[0], viewport_[1]));
+  glBindBufferBase(GL_UNIFORM_BUFFER, SHADER_RENDERER_STYLE_BINDING,
+                   style_buffer_);
+  glBindVertexArray(vao_);
+}
+
+void ShaderRenderer::drawEdges(const std::vector<IndexRange> &ranges) {
+  bindProgram(edges_program_);
+  for (const IndexRange &range : ranges) {
+    glDrawElements(GL_LINES, range.count * 2, GL_UNSIGNED_INT,
+                   (const void *)(sizeof(unsigned int) * range.offset * 2));
+  }
+  glBindVertexArray(0);
+  edges_program_->release();
+}
+
+void ShaderRenderer::drawPoints(int count) {
+  bindProgram(points_program_);
+  glEnable(GL_PROGRAM_POINT_SIZE);
+  glDrawArrays(GL_POINTS, 0, count);
+  glDisable(GL_PROGRAM_POINT_SIZE);
+  glBindVertexArray(0);
+  points_program_->release();
+}
@@ -1,29 +1,29 @@
 #include "strategies.h"
 
 void RotateX::transform(float value) {
-  controller->setRotationAnglesX(value * M_PI / 180.0f);
+  controller->execute(v_command_rotation_x, value * M_PI / 180.0f);
 }
 
 void RotateY::transform(float value) {
-  controller->setRotationAnglesY(value * M_PI / 180.0f);
+  controller->execute(v_command_rotation_y, value * M_PI / 180.0f);
 }
 
 void RotateZ::transform(float value) {
-  controller->setRotationAnglesZ(value * M_PI / 180.0f);
+  controller->execute(v_command_rotation_z, value * M_PI / 180.0f);
 }
 
 void Scale::transform(float value) {
-  controller->setScale(value / FACTOR_SCALE_SLIDER);
+  controller->execute(v_command_scale, value / FACTOR_SCALE_SLIDER);
 }
 
 void TranslationX::transform(float value) {
-  controller->setTranslationVectorX(value);
+  controller->execute(v_command_translation_x, value);
 }
 
 void TranslationY::transform(float value) {
-  controller->setTranslationVectorY(value);
+  controller->execute(v_command_translation_y, value);
 }
 
 void TranslationZ::transform(float value) {
-  controller->setTranslationVectorZ(value);
+  controller->execute(v_command_translation_z, value);
 }
@@ -0,0 +1,119 @@
+#include "vertex_stream.h"
+
+#include <QOpenGLContext>
+#include <algorithm>
+
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+VertexStream::VertexStream()
+    : buffer_(0),
+      frame_bytes_(0),
+      segment_(0),
+      fences_(),
+      mapped_(nullptr),
+      fences_available_(false),
+      buffer_storage_(nullptr) {}
+
+void VertexStream::init() {
+  QOpenGLContext *context = QOpenGLContext::currentContext();
+  initializeOpenGLFunctions();
+  QSurfaceFormat format = context->format();
+  fences_available_ = format.version() >= qMakePair(3, 2) ||
+                      context->hasExtension("GL_ARB_sync");
+  if (fences_available_ && context->hasExtension("GL_ARB_buffer_storage")) {
+    buffer_storage_ = reinterpret_cast<BufferStorageFunction>(
+        context->getProcAddress("glBufferStorage"));
+  }
+}
+
+void VertexStream::destroy() {
+  for (int i = 0; i < VERTEX_STREAM_SEGMENTS; ++i) {
+    if (fences_[i]) glDeleteSync(fences_[i]);
+    fences_[i] = nullptr;
+  }
+  if (buffer_) {
+    if (mapped_) {
+      glBindBuffer(GL_ARRAY_BUFFER, buffer_);
+      glUnmapBuffer(GL_ARRAY_BUFFER);
+      mapped_ = nullptr;
+    }
+    glDeleteBuffers(1, &buffer_);
+    buffer_ = 0;
+  }
+  frame_bytes_ = 0;
+}
+
+void VertexStream::resize(size_t frame_bytes) {
+  if (frame_bytes == frame_bytes_ && buffer_) return;
+  destroy();
+  frame_bytes_ = frame_bytes;
+  segment_ = 0;
+  size_t total = frame_bytes_ * VERTEX_STREAM_SEGMENTS;
+  glGenBuffers(1, &buffer_);
+  glBindBuffer(GL_ARRAY_BUFFER, buffer_);
+  if (buffer_storage_ && total > 0) {
+    GLbitfield flags =
+        GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    buffer_storage_(GL_ARRAY_BUFFER, total, nullptr, flags);
+    mapped_ = glMapBufferRange(GL_ARRAY_BUFFER, 0, total, flags);
+  }
+  if (!mapped_) {
+    glBufferData(GL_ARRAY_BUFFER, total, nullptr, GL_STREAM_DRAW);
+  }
+}
+
+void VertexStream::waitSegment(int segment) {
+  if (!fences_[segment]) return;
+  Profiler::Clock::time_point start = Profiler::Clock::now();
+  GLenum status = GL_TIMEOUT_EXPIRED;
+  GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+  while (status == GL_TIMEOUT_EXPIRED) {
+    status =
+        glClientWaitSync(fences_[segment], flags, VERTEX_STREAM_WAIT_TIMEOUT);
+    flags = 0;
+  }
+  glDeleteSync(fences_[segment]);
+  fences_[segment] = nullptr;
+  std::chrono::duration<double, std::milli> stall =
+      Profiler::Clock::now() - start;
+  Profiler::instance().addSample(v_profiler_stall, stall.count());
+}
+
+void *VertexStream::beginWrite() {
+  segment_ = (segment_ + 1) % VERTEX_STREAM_SEGMENTS;
+  waitSegment(segment_);
+  write_start_ = Profiler::Clock::now();
+  return mapped_ ? static_cast<char *>(mapped_) + offset() : nullptr;
+}
+
+void VertexStream::endWrite(const void *data, size_t bytes) {
+  bytes = std::min(bytes, frame_bytes_);
+  if (!mapped_ && buffer_ && bytes > 0) {
+    glBindBuffer(GL_ARRAY_BUFFER, buffer_);
+    glBufferSubData(GL_ARRAY_BUFFER, offset(), bytes, data);
+  }
+  std::chrono::duration<double> elapsed =
+      Profiler::Clock::now() - write_start_;
+  if (elapsed.count() > 0.0) {
+    Profiler::instance().setCounter(
+        v_profiler_upload_bandwidth,
+        bytes / (1024.0 * 1024.0) / elapsed.count());
+  }
+}
+
+void VertexStream::fence() {
+  if (!fences_available_ || !buffer_) return;
+  if (fences_[segment_]) glDeleteSync(fences_[segment_]);
+  fences_[segment_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+GLuint VertexStream::buffer() const { return buffer_; }
+
+size_t VertexStream::offset() const { return frame_bytes_ * segment_; }
+
+bool VertexStream::persistent() const { return mapped_ != nullptr; }
@@ -1,5 +1,7 @@
 #include "view.h"
 
+#include <QTimer>
+
 #include "./ui_view.h"
 
 void View::startEventLoop() { (*this).show(); }
@@ -14,6 +16,14 @@ View::View(Controller *c, QWidget *parent)
   palette.setColor(QPalette::ButtonText, Qt::black);
   palette.setColor(QPalette::Text, Qt::black);
   ui->menubar->addAction("Settings", this, SLOT(SettingsClicked()));
+  trace_action_ =
+      ui->menubar->addAction("Start trace", this, SLOT(TraceClicked()));
+  record_action_ =
+      ui->menubar->addAction("Start recording", this, SLOT(RecordClicked()));
+  QAction *progressive_action = ui->menubar->addAction("Progressive loading");
+  progressive_action->setCheckable(true);
+  connect(progressive_action, SIGNAL(toggled(bool)),
+          SLOT(ProgressiveToggled(bool)));
   ui->menubar->setPalette(palette);
   ui->menubar->setStyleSheet("QMenu { color: black; }");
 
@@ -21,7 +31,17 @@ View::View(Controller *c, QWidget *parent)
   connect(ui->action_save_image, SIGNAL(triggered()),
           SLOT(SaveAsImageClicked()));
   connect(ui->action_save_gif, SIGNAL(triggered()), SLOT(SaveAsGifClicked()));
+  image_writer_ = new ImageWriter(this);
+  connect(image_writer_, SIGNAL(written(QString, bool)),
+          SLOT(ImageWritten(QString, bool)));
+  gif_capture_ = new GifCapture(ui->view_field, controller, this);
+  connect(gif_capture_, SIGNAL(framesCaptured()), SLOT(GifFramesCaptured()));
+  connect(gif_capture_, SIGNAL(finished(QString, bool)),
+          SLOT(GifWritten(QString, bool)));
 
+  // the signal is emitted while painting, message boxes wait for the loop
+  connect(ui->view_field, SIGNAL(modelSwapped(int)), SLOT(ModelSwapped(int)),
+          Qt::QueuedConnection);
   connect(ui->view_field, SIGNAL(changeRotationAngles()),
           SLOT(RotationsAnglesChanged()));
   connect(ui->rotation_slider_x, SIGNAL(valueChanged(int)), ui->view_field,
@@ -50,6 +70,15 @@ View::View(Controller *c, QWidget *parent)
   connect(this, SIGNAL(translationSliderZChanged(float)), ui->view_field,
           SLOT(TranslationZChangeOutside(float)));
 
+  // the whole drag of a slider is one step of the history
+  for (QSlider *slider :
+       {ui->rotation_slider_x, ui->rotation_slider_y, ui->rotation_slider_z,
+        ui->scaling_slider, ui->translation_slider_x, ui->translation_slider_y,
+        ui->translation_slider_z}) {
+    connect(slider, SIGNAL(sliderPressed()), SLOT(SliderPressed()));
+    connect(slider, SIGNAL(sliderReleased()), SLOT(SliderReleased()));
+  }
+
   connect(ui->reset_button, SIGNAL(clicked()), SLOT(ResetAllValues()));
   ResetAllValues();
 }
@@ -71,20 +100,44 @@ void View::closeEvent(QCloseEvent *) { settings_widget->close(); }
 
 void View::FileOpenClicked() {
   QString fileName = QFileDialog::getOpenFileName(
-      this, tr("Open Model"), OBJECTS_PATH, tr("Object files (*.obj)"));
+      this, tr("Open Model"), OBJECTS_PATH,
+      tr("Object files (*.obj *.obj.gz *.obj.zst)"));
 
   if (!fileName.isNull()) {
-    int error = controller->uploadModel(fileName.toStdString());
-    if (error) {
-      ErrorMessage(controller->errorHandler(error));
-    } else {
-      ui->view_field->changeModel();
-      setVerticesNum(controller->getVerticesCount());
-      setEdgesNum(controller->getEdgesNumber());
-      QString base = QFileInfo(fileName).baseName();
-      ui->file_name_label->setText("File name: " + base);
-    }
+    // events of the recording belong to the model it was started with
+    if (controller->isRecording()) RecordClicked();
+    // the current model is drawn until the frame after the load
+    viewer_widget *viewer = ui->view_field;
+    controller->loadModelAsync(fileName.toStdString(), [viewer]() {
+      QMetaObject::invokeMethod(viewer, "update", Qt::QueuedConnection);
+    });
+  }
+}
+
+void View::ModelSwapped(int error) {
+  if (error) {
+    ErrorMessage(controller->errorHandler(error));
+    return;
+  }
+  showModelInfo();
+}
+
+bool View::openFile(const QString &fileName) {
+  int error = controller->uploadModel(fileName.toStdString());
+  if (error) {
+    ErrorMessage(controller->errorHandler(error));
+    return false;
   }
+  ui->view_field->changeModel();
+  showModelInfo();
+  return true;
+}
+
+void View::showModelInfo() {
+  setVerticesNum(controller->getVerticesCount());
+  setEdgesNum(controller->getEdgesNumber());
+  QString path = QString::fromStdString(controller->getModelPath());
+  ui->file_name_label->setText("File name: " + QFileInfo(path).baseName());
 }
 
 void View::ErrorMessage(Controller::string error) {
@@ -103,31 +156,143 @@ void View::setEdgesNum(int number) {
 };
 
 void View::SaveAsImageClicked() {
-  QImage image = ui->view_field->grabFramebuffer();
-  QString fileName = QFileDialog::getSaveFileName(this, tr("Save File"), "./",
-                                                  tr("Images (*.bmp *.jpeg)"));
-  image.save(fileName);
+  QSize window = ui->view_field->size() * ui->view_field->devicePixelRatio();
+  QStringList sizes;
+  sizes << QString("%1x%2").arg(window.width()).arg(window.height())
+        << "1920x1080" << "3840x2160" << "7680x4320" << "16384x16384";
+  bool ok = false;
+  QString item = QInputDialog::getItem(this, tr("Save Image"), tr("Size:"),
+                                       sizes, 0, true, &ok);
+  QStringList parts = item.split('x');
+  if (!ok || parts.size() != 2) return;
+  QSize size(parts[0].toInt(), parts[1].toInt());
+  if (size.isEmpty()) {
+    ErrorMessage("Wrong image size.");
+    return;
+  }
+
+  QString fileName = QFileDialog::getSaveFileName(
+      this, tr("Save File"), "./", tr("Images (*.png *.bmp *.jpeg)"));
+  if (fileName.isNull()) return;
+  QImage image = ui->view_field->renderImage(size);
+  if (image.isNull()) {
+    ErrorMessage("Not enough memory for the image.");
+    return;
+  }
+  image_writer_->write(image, fileName);
+}
+
+void View::ImageWritten(QString file_name, bool ok) {
+  if (!ok) {
+    ErrorMessage("Error while writing " + file_name.toStdString() + ".");
+  }
 }
 
 void View::SaveAsGifClicked() {
-  gif_iterator_ = 0;
-  gif_ = new QGifImage(QSize(640, 480));
-  gif_->setDefaultDelay(100);
-  startTimer(100);
-}
-
-void View::timerEvent(QTimerEvent *event) {
-  gif_->addFrame(ui->view_field->grabFramebuffer().scaled(
-      QSize(640, 480), Qt::IgnoreAspectRatio));
-  gif_iterator_++;
-  if (gif_iterator_ == 50) {  // 10 fps 5 seconds
-    killTimer(event->timerId());
-    QString fileName = QFileDialog::getSaveFileName(this, tr("Save File"), "./",
-                                                    tr("Images (*.gif)"));
-    gif_->save(fileName);
-    delete gif_;
-    gif_ = NULL;
+  QStringList axes;
+  axes << "Y axis" << "X axis" << "Z axis";
+  bool ok = false;
+  QString axis = QInputDialog::getItem(this, tr("Save Gif"), tr("Turntable:"),
+                                       axes, 0, false, &ok);
+  if (!ok) return;
+  QString fileName = QFileDialog::getSaveFileName(this, tr("Save File"), "./",
+                                                  tr("Images (*.gif)"));
+  if (fileName.isNull()) return;
+  if (axis == axes[1]) {
+    captureGif(v_capture_axis_x, fileName);
+  } else if (axis == axes[2]) {
+    captureGif(v_capture_axis_z, fileName);
+  } else {
+    captureGif(v_capture_axis_y, fileName);
+  }
+}
+
+void View::captureGif(v_capture_axis axis, QString fileName) {
+  TRACE_SCOPE("View::captureGif");
+  if (!gif_capture_->start(axis, fileName)) {
+    ErrorMessage("Error while opening " + fileName.toStdString() + ".");
+    return;
   }
+  // frames are rendered by the event loop, changes would get into them
+  ui->centralwidget->setEnabled(false);
+  ui->actionOpen->setEnabled(false);
+  ui->action_save_gif->setEnabled(false);
+  // the settings are a window of their own, not a part of centralwidget
+  settings_widget->setEnabled(false);
+}
+
+void View::GifFramesCaptured() {
+  ui->centralwidget->setEnabled(true);
+  ui->actionOpen->setEnabled(true);
+  settings_widget->setEnabled(true);
+}
+
+void View::GifWritten(QString file_name, bool ok) {
+  ui->action_save_gif->setEnabled(true);
+  if (!ok) {
+    ErrorMessage("Error while writing " + file_name.toStdString() + ".");
+  }
+}
+
+void View::ProgressiveToggled(bool enabled) {
+  // every batch of the loading model is drawn by the next frame
+  viewer_widget *viewer = ui->view_field;
+  controller->setProgressive(enabled, [viewer]() {
+    QMetaObject::invokeMethod(viewer, "update", Qt::QueuedConnection);
+  });
+}
+
+void View::TraceClicked() {
+  Tracer &tracer = Tracer::instance();
+  if (!tracer.isEnabled()) {
+    tracer.clear();
+    tracer.setEnabled(true);
+    trace_action_->setText("Stop trace");
+  } else {
+    tracer.setEnabled(false);
+    trace_action_->setText("Start trace");
+    QString fileName = QFileDialog::getSaveFileName(
+        this, tr("Save Trace"), "./trace.json", tr("Chrome trace (*.json)"));
+    if (!fileName.isNull() && !tracer.dump(fileName.toStdString())) {
+      ErrorMessage("Error while writing trace.");
+    }
+  }
+}
+
+void View::RecordClicked() {
+  if (!controller->isRecording()) {
+    controller->startRecording(&interactions_);
+    record_action_->setText("Stop recording");
+  } else {
+    controller->stopRecording();
+    record_action_->setText("Start recording");
+    QString fileName = QFileDialog::getSaveFileName(
+        this, tr("Save Recording"), "./interactions.txt",
+        tr("Interactions (*.txt)"));
+    if (!fileName.isNull() && !interactions_.save(fileName.toStdString())) {
+      ErrorMessage("Error while writing recording.");
+    }
+  }
+}
+
+bool View::replay(const QString &trace_path, bool max_speed,
+                  const QString &report_path) {
+  if (!interactions_.load(trace_path.toStdString())) {
+    ErrorMessage("Error while reading " + trace_path.toStdString() + ".");
+    return false;
+  }
+  if (!openFile(QString::fromStdString(interactions_.getModelPath()))) {
+    return false;
+  }
+  InteractionReplayer *replayer =
+      new InteractionReplayer(ui->view_field, this);
+  connect(replayer, &InteractionReplayer::finished,
+          [](bool ok) { QCoreApplication::exit(ok ? 0 : 1); });
+  // the first frame waits for the window to be shown
+  QTimer::singleShot(0, replayer, [this, replayer, max_speed, report_path]() {
+    replayer->start(interactions_, max_speed, report_path);
+  });
+  return true;
 }
 
 void View::RotationsAnglesChanged() {
@@ -210,7 +375,13 @@ void View::translationSliderZHandler(int value) {
   emit translationSliderZChanged(real_value);
 }
 
+void View::SliderPressed() { controller->beginCommandGroup(); }
+
+void View::SliderReleased() { controller->endCommandGroup(); }
+
 void View::ResetAllValues() {
+  // sliders send a command each, undone together
+  controller->beginCommandGroup();
   ui->rotation_slider_x->setValue(0.0f);
   ui->rotation_slider_y->setValue(0.0f);
   ui->rotation_slider_z->setValue(0.0f);
@@ -218,4 +389,5 @@ void View::ResetAllValues() {
   ui->translation_slider_x->setValue(HALF_SCALE_SLIDER);
   ui->translation_slider_y->setValue(HALF_SCALE_SLIDER);
   ui->translation_slider_z->setValue(HALF_SCALE_SLIDER);
+  controller->endCommandGroup();
 }
@@ -1,28 +1,161 @@
 #include "viewer_widget.h"
 
-viewer_widget::viewer_widget(QWidget *parent) : QOpenGLWidget{parent} {
+#include <QPainter>
+#include <algorithm>
+
+viewer_widget::viewer_widget(QWidget *parent)
+    : QOpenGLWidget{parent},
+      tile_matrix_(MatrixGenerator().generate_identity()) {
   setFocusPolicy(Qt::ClickFocus);
 }
 
 void viewer_widget::setDependencies(Controller *c) { controller = c; }
 
-viewer_widget::~viewer_widget() {}
+viewer_widget::~viewer_widget() {
+  makeCurrent();
+  stream_.destroy();
+  renderer_.destroy();
+  glDeleteBuffers(1, &progressive_vbo_);
+  glDeleteBuffers(1, &progressive_ebo_);
+  glDeleteBuffers(1, &proxy_vbo_);
+  offscreen_.destroy();
+  doneCurrent();
+}
 
 void viewer_widget::changeModel() {
+  makeCurrent();
+  uploadModelBuffers();
+  doneCurrent();
+  update();
+}
+
+void viewer_widget::applyStagedModel() {
+  bool progressive = progressive_vertices_capacity_ > 0;
+  int error = controller->swapStagedModel();
+  if (!error) {
+    uploadModelBuffers();
+  } else if (progressive && core_profile_ &&
+             controller->getModelInitialized()) {
+    // the batches were written over edges of the kept model
+    uploadIndices();
+  }
+  if (progressive) resetProgressiveBuffers();
+  emit modelSwapped(error);
+}
+
+void viewer_widget::uploadModelBuffers() {
   controller->setModel();
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-               sizeof(unsigned int) * controller->getIndicesCount(),
-               controller->getIndices(), GL_DYNAMIC_DRAW);
+  uploadIndices();
   ResetState();
-  updateVertexBuffer();
-  update();
+  stream_.resize(sizeof(Vector3) * controller->getStreamVerticesCount());
+  if (controller->getQuantized()) uploadQuantizedBuffer();
+}
+
+void viewer_widget::uploadIndices() {
+  if (core_profile_) {
+    renderer_.setEdges(controller->getDrawnIndices(),
+                       controller->getDrawnIndicesCount());
+  } else {
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                 sizeof(unsigned int) * controller->getDrawnIndicesCount(),
+                 controller->getDrawnIndices(), GL_DYNAMIC_DRAW);
+  }
 }
 
 void viewer_widget::initializeGL() {
   initializeOpenGLFunctions();
   glGenBuffers(1, &VBO);
   glGenBuffers(1, &EBO);
+  glGenBuffers(1, &progressive_vbo_);
+  glGenBuffers(1, &progressive_ebo_);
+  glGenBuffers(1, &proxy_vbo_);
+  stream_.init();
+  core_profile_ =
+      context()->format().profile() == QSurfaceFormat::CoreProfile &&
+      renderer_.init();
+  style_dirty_ = true;
+  offscreen_.init();
+  initTimerQueries();
+}
+
+void viewer_widget::resizeGL(int w, int h) {
+  renderer_.setViewport(w * devicePixelRatio(), h * devicePixelRatio());
+}
+
+void viewer_widget::initTimerQueries() {
+  for (int i = 0; i < TIMER_QUERIES_COUNT; ++i) {
+    gpu_queries_[i] = new QOpenGLTimerQuery(this);
+    if (!gpu_queries_[i]->create()) {
+      for (int j = 0; j <= i; ++j) {
+        delete gpu_queries_[j];
+        gpu_queries_[j] = nullptr;
+      }
+      break;
+    }
+  }
+}
+
+void viewer_widget::beginGpuTimer() {
+  QOpenGLTimerQuery *query = gpu_queries_[gpu_query_index_];
+  if (!query) return;
+  if (gpu_query_pending_[gpu_query_index_] && query->isResultAvailable()) {
+    Profiler::instance().addSample(v_profiler_gpu,
+                                   query->waitForResult() / 1000000.0);
+  }
+  query->begin();
+}
+
+void viewer_widget::endGpuTimer() {
+  QOpenGLTimerQuery *query = gpu_queries_[gpu_query_index_];
+  if (!query) return;
+  query->end();
+  gpu_query_pending_[gpu_query_index_] = true;
+  gpu_query_index_ = (gpu_query_index_ + 1) % TIMER_QUERIES_COUNT;
+}
+
+void viewer_widget::setOverlayVisible(bool visible) {
+  overlay_visible_ = visible;
+  update();
+}
+
+bool viewer_widget::getOverlayVisible() { return overlay_visible_; }
+
+void viewer_widget::paintOverlay() {
+  Profiler &profiler = Profiler::instance();
+  ProfilerStats frame = profiler.getStats(v_profiler_frame);
+  QStringList lines;
+  lines << QString("FPS: %1").arg(profiler.getFps(), 0, 'f', 1);
+  lines << QString("frame p50 %1  p95 %2  p99 %3 ms")
+               .arg(frame.p50, 0, 'f', 2)
+               .arg(frame.p95, 0, 'f', 2)
+               .arg(frame.p99, 0, 'f', 2);
+  for (int i = 0; i < v_profiler_frame; ++i) {
+    ProfilerStats stats = profiler.getStats((v_profiler_stages)i);
+    if (stats.samples == 0) continue;
+    lines << QString("%1: %2 ms (avg %3)")
+                 .arg(Profiler::stageName((v_profiler_stages)i))
+                 .arg(stats.last, 0, 'f', 2)
+                 .arg(stats.average, 0, 'f', 2);
+  }
+  for (int i = 0; i < v_profiler_counters_count; ++i) {
+    lines << QString("%1: %2")
+                 .arg(Profiler::counterName((v_profiler_counters)i))
+                 .arg(profiler.getCounter((v_profiler_counters)i), 0, 'f', 1);
+  }
+
+  QPainter painter(this);
+  QFont font = painter.font();
+  font.setFamily("monospace");
+  painter.setFont(font);
+  int line_height = painter.fontMetrics().height();
+  painter.fillRect(QRect(5, 5, 260, line_height * lines.size() + 10),
+                   QColor(0, 0, 0, 160));
+  painter.setPen(Qt::white);
+  for (int i = 0; i < lines.size(); ++i) {
+    painter.drawText(10, 5 + line_height * (i + 1), lines[i]);
+  }
+  painter.end();
 }
 
 void viewer_widget::enableSettings() {
@@ -44,50 +177,311 @@ void viewer_widget::enableSettings() {
   } else {
     glDisable(GL_POINT_SMOOTH);
   }
+}
 
-  controller->setModelMatrixes();
+void viewer_widget::applyStyle() {
+  Vector3 line_color = controller->getLineColor();
+  Vector3 vertices_color = controller->getVerticesColor();
+  Vector3 background_color = controller->getBackgroundColor();
+  RenderStyle style = {
+      {line_color.r(), line_color.g(), line_color.b(), 1.0f},
+      {vertices_color.r(), vertices_color.g(), vertices_color.b(), 1.0f},
+      controller->getLineWidth(),
+      controller->getVertexSize(),
+      controller->toStipple() ? SHADER_RENDERER_STIPPLE_PATTERN : 0,
+      controller->toSmooth() ? 1 : 0};
+  renderer_.setStyle(style);
+  glClearColor(background_color.r(), background_color.g(),
+               background_color.b(), 1.0f);
+  style_dirty_ = false;
+}
 
-  if (controller->getModelInitialized()) {
+void viewer_widget::paintGL() {
+  TRACE_SCOPE("viewer_widget::paintGL");
+  // the loaded model replaces the drawn one between frames
+  if (controller->isStagedModelReady()) applyStagedModel();
+  ProgressiveMesh *mesh = controller->getProgressiveMesh();
+  if (mesh) uploadProgressiveBatch(mesh);
+  if (!core_profile_) {
+    enableSettings();
+  } else if (style_dirty_) {
+    applyStyle();
+  }
+  controller->setModelMatrixes();
+  if (controller->pageModel()) uploadIndices();
+  // commands since the last frame cost one transform, or none if they
+  // changed only settings
+  if (controller->getModelInitialized() && controller->isTransformChanged()) {
     updateVertexBuffer();
   }
-}
+  controller->endCommandFrame();
 
-void viewer_widget::paintGL() {
-  enableSettings();
+  beginGpuTimer();
+  {
+    TRACE_SCOPE("viewer_widget::drawModel");
+    ScopedTimer timer(v_profiler_draw);
+    drawModel();
+  }
+  endGpuTimer();
 
+  if (overlay_visible_) paintOverlay();
+  // meshlets being read replace their proxies in the next frames
+  if (controller->isPagingIn()) update();
+  Profiler::instance().markFrame();
+}
+
+void viewer_widget::drawModel() {
   glClear(GL_COLOR_BUFFER_BIT);
-  glBindBuffer(GL_ARRAY_BUFFER, VBO);
+  if (controller->getProgressiveMesh() && progressive_vertices_ > 0) {
+    drawProgressive();
+    return;
+  }
+  if (!controller->getModelInitialized()) return;
+  if (core_profile_) {
+    drawShaded();
+  } else {
+    drawLegacy();
+  }
+}
+
+QImage viewer_widget::renderImage(QSize size) {
+  makeCurrent();
+  if (!core_profile_) {
+    enableSettings();
+  } else if (style_dirty_) {
+    applyStyle();
+  }
+  controller->setModelMatrixes();
+  if (controller->pageModel()) uploadIndices();
+  if (controller->getModelInitialized()) updateVertexBuffer();
+  QImage image = offscreen_.render(
+      size, [this](const Matrix4x4 &tile, QSize viewport) {
+        // line width and stipple are pixels of the tile, not of the widget
+        renderer_.setViewport(viewport.width(), viewport.height());
+        tile_matrix_ = tile;
+        drawModel();
+      });
+  tile_matrix_ = MatrixGenerator().generate_identity();
+  renderer_.setViewport(width() * devicePixelRatio(),
+                        height() * devicePixelRatio());
+  doneCurrent();
+  return image;
+}
+
+void viewer_widget::drawShaded() {
+  if (controller->getQuantized()) {
+    renderer_.setPositions(VBO, 0, true);
+    renderer_.setTransform(MatrixGenerator().matrix_mult_4x4(
+        tile_matrix_, controller->getQuantizedTransformMatrix()));
+  } else {
+    // positions are already in clip space
+    renderer_.setPositions(stream_.buffer(), stream_.offset(), false);
+    renderer_.setTransform(tile_matrix_);
+  }
+  renderer_.drawEdges(controller->getVisibleRanges());
+  // vertices of meshlets out of memory are not transformed
+  if (controller->toColor() && !controller->isPaging()) {
+    renderer_.drawPoints(controller->getVerticesCount());
+  }
+  if (controller->isPaging()) drawProxies();
+  if (!controller->getQuantized()) stream_.fence();
+}
+
+void viewer_widget::drawLegacy() {
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+  glEnableVertexAttribArray(0);
+  if (controller->getQuantized()) {
+    // positions are unpacked and transformed by GL instead of CPU
+    loadGLMatrix(MatrixGenerator().matrix_mult_4x4(
+        tile_matrix_, controller->getQuantizedTransformMatrix()));
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, 0, 0);
+  } else {
+    // the segment of the ring written for this frame
+    loadGLMatrix(tile_matrix_);
+    glBindBuffer(GL_ARRAY_BUFFER, stream_.buffer());
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0,
+                          (const void *)stream_.offset());
+  }
+  glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+  glColor3f(controller->getLineColor().r(), controller->getLineColor().g(),
+            controller->getLineColor().b());  // color of vertices
+  for (const IndexRange &range : controller->getVisibleRanges()) {
+    glDrawElements(GL_TRIANGLES, range.count, GL_UNSIGNED_INT,
+                   (const void *)(sizeof(unsigned int) * range.offset));
+  }
+  if (controller->toColor() && !controller->isPaging()) {
+    glColor3f(controller->getVerticesColor().r(),
+              controller->getVerticesColor().g(),
+              controller->getVerticesColor().b());  // color of points
+    glDrawArrays(GL_POINTS, 0, controller->getVerticesCount());
+  }
+  glDisableVertexAttribArray(0);
+  glMatrixMode(GL_MODELVIEW);
+  glLoadIdentity();
+  if (controller->isPaging()) drawProxies();
+  if (!controller->getQuantized()) stream_.fence();
+}
 
-  if (controller->getModelInitialized()) {
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, 0);
-    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-    glColor3f(controller->getLineColor().r(), controller->getLineColor().g(),
-              controller->getLineColor().b());  // color of vertices
-    glDrawElements(GL_TRIANGLES, controller->getIndicesCount(), GL_UNSIGNED_INT,
-                   0);
-    if (controller->toColor()) {
-      glColor3f(controller->getVerticesColor().r(),
-                controller->getVerticesColor().g(),
-                controller->getVerticesColor().b());  // color of points
-      glDrawArrays(GL_POINTS, 0, controller->getVerticesCount());
+void viewer_widget::uploadProgressiveBatch(ProgressiveMesh *mesh) {
+  TRACE_SCOPE("viewer_widget::uploadProgressive");
+  ScopedTimer timer(v_profiler_upload);
+  ProgressiveBatch batch =
+      mesh->getBatch(progressive_vertices_, progressive_indices_);
+  // a superseding load started the mesh over, it is uploaded from the start
+  if (batch.generation != progressive_generation_) {
+    batch = mesh->getBatch(0, 0);
+    progressive_generation_ = batch.generation;
+  }
+  size_t vertices_count = batch.first_vertex + batch.vertices.size();
+  size_t indices_count = batch.first_index + batch.indices.size();
+  if (vertices_count > progressive_vertices_capacity_ ||
+      indices_count > progressive_indices_capacity_) {
+    // reserved once per file unless its size gave too small estimate
+    size_t expected_vertices = 0, expected_indices = 0;
+    mesh->getExpectedCounts(&expected_vertices, &expected_indices);
+    progressive_vertices_capacity_ =
+        std::max({expected_vertices, vertices_count,
+                  progressive_vertices_capacity_ * 2});
+    progressive_indices_capacity_ = std::max(
+        {expected_indices, indices_count, progressive_indices_capacity_ * 2});
+    glBindBuffer(GL_ARRAY_BUFFER, progressive_vbo_);
+    glBufferData(GL_ARRAY_BUFFER,
+                 sizeof(Vector3) * progressive_vertices_capacity_, nullptr,
+                 GL_STATIC_DRAW);
+    if (core_profile_) {
+      renderer_.reserveEdges(progressive_indices_capacity_);
+    } else {
+      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, progressive_ebo_);
+      glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                   sizeof(unsigned int) * progressive_indices_capacity_,
+                   nullptr, GL_STATIC_DRAW);
+    }
+    // the new buffers are filled from the start
+    if (batch.first_vertex > 0 || batch.first_index > 0) {
+      batch = mesh->getBatch(0, 0);
+      progressive_generation_ = batch.generation;
     }
-    glDisableVertexAttribArray(0);
   }
+  glBindBuffer(GL_ARRAY_BUFFER, progressive_vbo_);
+  glBufferSubData(GL_ARRAY_BUFFER, sizeof(Vector3) * batch.first_vertex,
+                  sizeof(Vector3) * batch.vertices.size(),
+                  batch.vertices.data());
+  if (core_profile_) {
+    renderer_.appendEdges(batch.indices.data(), batch.first_index,
+                          batch.indices.size());
+  } else {
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, progressive_ebo_);
+    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER,
+                    sizeof(unsigned int) * batch.first_index,
+                    sizeof(unsigned int) * batch.indices.size(),
+                    batch.indices.data());
+  }
+  progressive_vertices_ = batch.first_vertex + batch.vertices.size();
+  progressive_indices_ = batch.first_index + batch.indices.size();
+}
+
+void viewer_widget::drawProgressive() {
+  // the bounding box of loaded vertices normalizes them, so it is corrected
+  // every frame without uploading vertices again
+  Matrix4x4 transform = MatrixGenerator().matrix_mult_4x4(
+      tile_matrix_, controller->getProgressiveTransformMatrix());
+  if (core_profile_) {
+    renderer_.setPositions(progressive_vbo_, 0, false);
+    renderer_.setTransform(transform);
+    renderer_.drawEdges({IndexRange{0, (unsigned int)progressive_indices_}});
+    if (controller->toColor()) renderer_.drawPoints(progressive_vertices_);
+    return;
+  }
+  loadGLMatrix(transform);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, progressive_ebo_);
+  glBindBuffer(GL_ARRAY_BUFFER, progressive_vbo_);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
+  glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+  glColor3f(controller->getLineColor().r(), controller->getLineColor().g(),
+            controller->getLineColor().b());
+  glDrawElements(GL_TRIANGLES, progressive_indices_, GL_UNSIGNED_INT, 0);
+  if (controller->toColor()) {
+    glColor3f(controller->getVerticesColor().r(),
+              controller->getVerticesColor().g(),
+              controller->getVerticesColor().b());
+    glDrawArrays(GL_POINTS, 0, progressive_vertices_);
+  }
+  glDisableVertexAttribArray(0);
+  glMatrixMode(GL_MODELVIEW);
+  glLoadIdentity();
+}
+
+void viewer_widget::resetProgressiveBuffers() {
+  glBindBuffer(GL_ARRAY_BUFFER, progressive_vbo_);
+  glBufferData(GL_ARRAY_BUFFER, 0, nullptr, GL_STATIC_DRAW);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, progressive_ebo_);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, 0, nullptr, GL_STATIC_DRAW);
+  progressive_vertices_ = progressive_indices_ = 0;
+  progressive_vertices_capacity_ = progressive_indices_capacity_ = 0;
+}
+
+void viewer_widget::drawProxies() {
+  std::vector<Vector3> points = controller->getProxyPoints();
+  if (points.empty()) return;
+  glBindBuffer(GL_ARRAY_BUFFER, proxy_vbo_);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(Vector3) * points.size(),
+               points.data(), GL_STREAM_DRAW);
+  // points are in clip space as the transformed vertices
+  if (core_profile_) {
+    renderer_.setPositions(proxy_vbo_, 0, false);
+    renderer_.setTransform(tile_matrix_);
+    renderer_.drawPoints(points.size());
+    return;
+  }
+  loadGLMatrix(tile_matrix_);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
+  glColor3f(controller->getLineColor().r(), controller->getLineColor().g(),
+            controller->getLineColor().b());
+  glDrawArrays(GL_POINTS, 0, points.size());
+  glDisableVertexAttribArray(0);
+  glMatrixMode(GL_MODELVIEW);
+  glLoadIdentity();
 }
 
 void viewer_widget::updateVertexBuffer() {
-  controller->updateModel();
-  if (controller->getModelInitialized()) {
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER,
-                 sizeof(float) * 4 * controller->getVerticesCount(),
-                 controller->getVerticesCopy(), GL_DYNAMIC_DRAW);
+  if (!controller->getModelInitialized() || controller->getQuantized()) {
+    controller->updateModel();
+    return;
   }
+  // mapped ring is written by transform directly, otherwise it is copied
+  Vector3 *mapped = static_cast<Vector3 *>(stream_.beginWrite());
+  controller->updateModel(mapped ? mapped : controller->getVerticesCopy());
+  TRACE_SCOPE("viewer_widget::upload");
+  ScopedTimer timer(v_profiler_upload);
+  stream_.endWrite(controller->getVerticesCopy(),
+                   sizeof(Vector3) * controller->getDrawnVerticesCount());
+}
+
+void viewer_widget::uploadQuantizedBuffer() {
+  QuantizedPositions positions = controller->getQuantizedPositions();
+  TRACE_SCOPE("viewer_widget::uploadQuantized");
+  ScopedTimer timer(v_profiler_upload);
+  glBindBuffer(GL_ARRAY_BUFFER, VBO);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(uint16_t) * positions.data.size(),
+               positions.data.data(), GL_STATIC_DRAW);
+}
+
+void viewer_widget::loadGLMatrix(const Matrix4x4 &matrix) {
+  GLfloat column_major[16];
+  for (int row = 0; row < 4; ++row) {
+    for (int col = 0; col < 4; ++col) {
+      column_major[col * 4 + row] = matrix(row, col);
+    }
+  }
+  glMatrixMode(GL_MODELVIEW);
+  glLoadMatrixf(column_major);
 }
 
 void viewer_widget::updateSettings() {
+  style_dirty_ = true;
   controller->saveSettings();
   update();
 }
@@ -97,11 +491,10 @@ void viewer_widget::wheelEvent(QWheelEvent *event) {
   float old_scale = controller->getScale();
 
   if (numDegrees.y() >= 15) {  // Maximize
-    controller->setScale(old_scale * 1.1);
+    controller->execute(v_command_scale, old_scale * 1.1);
   } else if (numDegrees.y() <= -15) {  // Minimize
-    controller->setScale(old_scale * 0.9);
+    controller->execute(v_command_scale, old_scale * 0.9);
   }
-  updateVertexBuffer();
   update();
   emit changeScaling();
   event->accept();
@@ -109,6 +502,8 @@ void viewer_widget::wheelEvent(QWheelEvent *event) {
 
 void viewer_widget::mousePressEvent(QMouseEvent *event) {
   if (event->button() == Qt::LeftButton) {
+    // the whole drag is one step of the history
+    if (!dragging) controller->beginCommandGroup();
     dragging = true;
     last_x = event->pos().x();
     last_y = event->pos().y();
@@ -118,11 +513,12 @@ void viewer_widget::mousePressEvent(QMouseEvent *event) {
 
 void viewer_widget::mouseMoveEvent(QMouseEvent *event) {
   if ((event->buttons() & Qt::LeftButton) && dragging) {
-    controller->setRotationAnglesY(controller->getRotationAnglesY() +
-                                   ((event->pos().y() - last_y) / 100.0f));
-    controller->setRotationAnglesX(controller->getRotationAnglesX() +
-                                   ((event->pos().x() - last_x) / 100.0f));
-    updateVertexBuffer();
+    controller->execute(v_command_rotation_y,
+                        controller->getRotationAnglesY() +
+                            ((event->pos().y() - last_y) / 100.0f));
+    controller->execute(v_command_rotation_x,
+                        controller->getRotationAnglesX() +
+                            ((event->pos().x() - last_x) / 100.0f));
     update();
     last_x = event->pos().x();
     last_y = event->pos().y();
@@ -134,28 +530,46 @@ void viewer_widget::mouseMoveEvent(QMouseEvent *event) {
 void viewer_widget::mouseReleaseEvent(QMouseEvent *event) {
   if (event->button() == Qt::LeftButton && dragging) {
     dragging = false;
+    controller->endCommandGroup();
   }
   event->accept();
 }
 
 void viewer_widget::keyPressEvent(QKeyEvent *event) {
-  if (event->key() == Qt::Key_W) {
-    controller->setTranslationVectorY(controller->getTranslationVectorY() +
-                                      0.1f);
+  if (event->matches(QKeySequence::Undo)) {
+    if (controller->undo()) historyChanged();
+    return;
+  } else if (event->matches(QKeySequence::Redo)) {
+    if (controller->redo()) historyChanged();
+    return;
+  } else if (event->key() == Qt::Key_W) {
+    controller->execute(v_command_translation_y,
+                        controller->getTranslationVectorY() + 0.1f);
   } else if (event->key() == Qt::Key_S) {
-    controller->setTranslationVectorY(controller->getTranslationVectorY() -
-                                      0.1f);
+    controller->execute(v_command_translation_y,
+                        controller->getTranslationVectorY() - 0.1f);
   } else if (event->key() == Qt::Key_A) {
-    controller->setTranslationVectorX(controller->getTranslationVectorX() -
-                                      0.1f);
+    controller->execute(v_command_translation_x,
+                        controller->getTranslationVectorX() - 0.1f);
   } else if (event->key() == Qt::Key_D) {
-    controller->setTranslationVectorX(controller->getTranslationVectorX() +
-                                      0.1f);
+    controller->execute(v_command_translation_x,
+                        controller->getTranslationVectorX() + 0.1f);
+  } else if (event->key() == Qt::Key_F3) {
+    setOverlayVisible(!overlay_visible_);
+    return;
+  } else if (event->key() == Qt::Key_Q) {
+    makeCurrent();
+    controller->setQuantized(!controller->getQuantized());
+    if (controller->getModelInitialized() && controller->getQuantized()) {
+      uploadQuantizedBuffer();
+    }
+    doneCurrent();
+    update();
+    return;
   } else {
     return;
   }
   emit changeTranslation();
-  updateVertexBuffer();
   update();
 }
 
@@ -163,7 +577,6 @@ void viewer_widget::RotationXChangeOutside(int value) {
   RotateX rotateX(controller);
   context.setStrategy(&rotateX);
   context.transform(value);
-  updateVertexBuffer();
   update();
   emit changeRotationAngles();
 }
@@ -172,7 +585,6 @@ void viewer_widget::RotationYChangeOutside(int value) {
   RotateY rotateY(controller);
   context.setStrategy(&rotateY);
   context.transform(value);
-  updateVertexBuffer();
   update();
   emit changeRotationAngles();
 }
@@ -181,7 +593,6 @@ void viewer_widget::RotationZChangeOutside(int value) {
   RotateZ rotateZ(controller);
   context.setStrategy(&rotateZ);
   context.transform(value);
-  updateVertexBuffer();
   update();
   emit changeRotationAngles();
 }
@@ -190,7 +601,6 @@ void viewer_widget::ScalingChangeOutside(int value) {
   Scale scale(controller);
   context.setStrategy(&scale);
   context.transform(value);
-  updateVertexBuffer();
   update();
   emit changeScaling();
 }
@@ -199,7 +609,6 @@ void viewer_widget::TranslationXChangeOutside(float value) {
   TranslationX translationX(controller);
   context.setStrategy(&translationX);
   context.transform(value);
-  updateVertexBuffer();
   update();
   emit changeTranslation();
 }
@@ -208,7 +617,6 @@ void viewer_widget::TranslationYChangeOutside(float value) {
   TranslationY translationX(controller);
   context.setStrategy(&translationX);
   context.transform(value);
-  updateVertexBuffer();
   update();
   emit changeTranslation();
 }
@@ -217,11 +625,29 @@ void viewer_widget::TranslationZChangeOutside(float value) {
   TranslationZ translationX(controller);
   context.setStrategy(&translationX);
   context.transform(value);
-  updateVertexBuffer();
   update();
   emit changeTranslation();
 }
 
+void viewer_widget::historyChanged() {
+  controller->saveSettings();
+  showValues();
+}
+
+void viewer_widget::replayEvent(const InteractionEvent &event) {
+  controller->replayEvent(event);
+  showValues();
+}
+
+void viewer_widget::showValues() {
+  style_dirty_ = true;
+  emit changeRotationAngles();
+  emit changeScaling();
+  emit changeTranslation();
+  emit changeSettings();
+  update();
+}
+
 void viewer_widget::ResetState() {
   controller->resetState();
   emit changeRotationAngles();
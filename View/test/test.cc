@@ -0,0 +1,235 @@
+#include <gtest/gtest.h>
+
+#include <QBuffer>
+#include <QGuiApplication>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLExtraFunctions>
+#include <vector>
+
+#include "offscreen_renderer.h"
+#include "qgifquantizer.h"
+#include "qgifstreamwriter.h"
+#include "shader_renderer.h"
+
+#define LINE_WIDTH 3
+
+/**
+ * @brief The function counts lit rows of the column around the middle row
+ *
+ * @param image Rendered image
+ * @param x The column
+ * @return int Thickness of the line crossing the middle row
+ */
+static int lineThickness(const QImage &image, int x) {
+  int middle = image.height() / 2;
+  auto lit = [&](int y) { return qRed(image.pixel(x, y)) > 128; };
+  int first = middle, last = middle;
+  while (first > 0 && lit(first - 1)) --first;
+  while (last < image.height() && lit(last)) ++last;
+  return last - first;
+}
+
+TEST(OffscreenTest, TestLineWidth1) {
+  QSurfaceFormat format;
+  format.setVersion(3, 3);
+  format.setProfile(QSurfaceFormat::CoreProfile);
+  QOpenGLContext context;
+  context.setFormat(format);
+  QOffscreenSurface surface;
+  surface.setFormat(format);
+  surface.create();
+  if (!context.create() || !context.makeCurrent(&surface)) GTEST_SKIP();
+  QOpenGLExtraFunctions *gl = context.extraFunctions();
+  ShaderRenderer renderer;
+  if (context.format().profile() != QSurfaceFormat::CoreProfile ||
+      !renderer.init()) {
+    GTEST_SKIP();
+  }
+  OffscreenRenderer offscreen;
+  offscreen.init();
+
+  // horizontal edge through the middle row, the others are away from it
+  const float positions[] = {-0.9f, 0.0f, 0.0f, 0.9f, 0.0f,
+                             0.0f,  0.9f, 0.9f, 0.0f};
+  const unsigned int indices[] = {0, 1, 2};
+  GLuint buffer = 0;
+  gl->glGenBuffers(1, &buffer);
+  gl->glBindBuffer(GL_ARRAY_BUFFER, buffer);
+  gl->glBufferData(GL_ARRAY_BUFFER, sizeof(positions), positions,
+                   GL_STATIC_DRAW);
+  renderer.setPositions(buffer, 0, false);
+  renderer.setEdges(indices, 3);
+  RenderStyle style = {{1, 1, 1, 1}, {1, 1, 1, 1}, LINE_WIDTH, 1, 0, 0};
+  renderer.setStyle(style);
+
+  // the line of the last size lies on the border of two tiles
+  const QSize sizes[] = {QSize(128, 128), QSize(1024, 512),
+                         QSize(256, 2 * OFFSCREEN_MAX_TILE)};
+  for (const QSize &size : sizes) {
+    QImage image = offscreen.render(
+        size, [&](const Matrix4x4 &tile, QSize viewport) {
+          renderer.setViewport(viewport.width(), viewport.height());
+          renderer.setTransform(tile);
+          gl->glClearColor(0, 0, 0, 1);
+          gl->glClear(GL_COLOR_BUFFER_BIT);
+          renderer.drawEdges({{0, 3}});
+        });
+    ASSERT_FALSE(image.isNull());
+    for (int x : {size.width() / 4, size.width() * 2 / 3}) {
+      EXPECT_NEAR(lineThickness(image, x), LINE_WIDTH, 1)
+          << size.width() << "x" << size.height() << " at " << x;
+    }
+  }
+  gl->glDeleteBuffers(1, &buffer);
+  offscreen.destroy();
+  renderer.destroy();
+  context.doneCurrent();
+}
+
+TEST(QuantizerTest, TestQuantizer1) {
+  // the first colors share a cell of the RGB555 table, the last one is
+  // near the border of its cell
+  const QRgb colors[] = {qRgb(8, 8, 8), qRgb(12, 13, 14), qRgb(15, 15, 15),
+                         qRgb(200, 100, 7)};
+  QImage image(64, 4, QImage::Format_RGB32);
+  for (int y = 0; y < image.height(); ++y) {
+    for (int x = 0; x < image.width(); ++x) image.setPixel(x, y, colors[y]);
+  }
+  QVector<QRgb> palette = QGifQuantizer::buildPalette({image});
+  ASSERT_EQ(palette.size(), 4);
+  QGifQuantizer quantizer(palette);
+  for (bool dither : {false, true}) {
+    QImage indexed = quantizer.quantize(image, dither);
+    for (int y = 0; y < image.height(); ++y) {
+      for (int x = 0; x < image.width(); ++x) {
+        ASSERT_EQ(indexed.color(indexed.pixelIndex(x, y)), colors[y])
+            << x << " " << y << " " << dither;
+      }
+    }
+  }
+}
+
+/**
+ * @brief The function reads the gif from memory for DGifOpen
+ *
+ * @param gif Decoded gif, its user data is the QBuffer
+ * @param data Output bytes
+ * @param size Bytes to read
+ * @return int Bytes read
+ */
+static int readBuffer(GifFileType *gif, GifByteType *data, int size) {
+  return static_cast<QBuffer *>(gif->UserData)
+      ->read(reinterpret_cast<char *>(data), size);
+}
+
+/**
+ * @brief The function draws frame of the stream test
+ *
+ * @param index Index of the frame
+ * @return QImage Background of four colors with a moving square
+ */
+static QImage streamFrame(int index) {
+  const QRgb colors[] = {qRgb(250, 250, 250), qRgb(30, 30, 30),
+                         qRgb(0, 128, 255), qRgb(200, 40, 40),
+                         qRgb(90, 200, 60)};
+  QImage image(64, 48, QImage::Format_RGB32);
+  for (int y = 0; y < image.height(); ++y) {
+    for (int x = 0; x < image.width(); ++x) {
+      // the last frame changes the whole background
+      int shift = index == 5 ? 1 : 0;
+      image.setPixel(x, y, colors[(x / 8 + y / 8 + shift) % 4]);
+    }
+  }
+  // 3 is the same as 2, 4 changes only the corner pixel
+  const QPoint squares[] = {{-1, -1}, {10, 10}, {20, 12},
+                            {20, 12}, {20, 12}, {40, 30}};
+  if (squares[index].x() >= 0) {
+    for (int y = 0; y < 8; ++y) {
+      for (int x = 0; x < 8; ++x) {
+        image.setPixel(squares[index] + QPoint(x, y), colors[4]);
+      }
+    }
+  }
+  if (index == 4) image.setPixel(63, 47, colors[4]);
+  return image;
+}
+
+TEST(GifStreamTest, TestGifStream1) {
+  const int count = 6;
+  QBuffer buffer;
+  buffer.open(QIODevice::ReadWrite);
+  QGifStreamWriter writer(QSize(64, 48), 2);
+  ASSERT_TRUE(writer.open(&buffer));
+  QList<QImage> frames;
+  for (int i = 0; i < count; ++i) {
+    frames.append(streamFrame(i));
+    ASSERT_TRUE(writer.addFrame(frames.back(), 40));
+  }
+  ASSERT_TRUE(writer.close());
+
+  buffer.seek(0);
+  int error = 0;
+  GifFileType *gif = DGifOpen(&buffer, readBuffer, &error);
+  ASSERT_NE(gif, nullptr);
+  ASSERT_EQ(DGifSlurp(gif), GIF_OK);
+  ASSERT_EQ(gif->ImageCount, count);
+  ASSERT_NE(gif->SColorMap, nullptr);
+
+  // delta frames mark unchanged pixels by the entry after the palette
+  GraphicsControlBlock gcb;
+  ASSERT_EQ(DGifSavedExtensionToGCB(gif, 1, &gcb), GIF_OK);
+  ASSERT_GT(gcb.TransparentColor, 0);
+  QVector<QRgb> palette;
+  for (int i = 0; i < gcb.TransparentColor; ++i) {
+    const GifColorType &color = gif->SColorMap->Colors[i];
+    palette.append(qRgb(color.Red, color.Green, color.Blue));
+  }
+  // the square appears only from the second frame, its color is in the
+  // palette all the same
+  EXPECT_EQ(palette.size(), 5);
+  QList<QImage> expected = QGifQuantizer(palette).quantize(frames);
+
+  // frames are drawn over the previous ones, as with DISPOSE_DO_NOT
+  std::vector<int> canvas(64 * 48, -1);
+  for (int i = 0; i < count; ++i) {
+    const SavedImage &image = gif->SavedImages[i];
+    ASSERT_EQ(DGifSavedExtensionToGCB(gif, i, &gcb), GIF_OK);
+    EXPECT_EQ(gcb.DisposalMode, DISPOSE_DO_NOT);
+    EXPECT_EQ(gcb.TransparentColor == NO_TRANSPARENT_COLOR, i == 0);
+    const GifImageDesc &desc = image.ImageDesc;
+    ASSERT_LE(desc.Left + desc.Width, 64);
+    ASSERT_LE(desc.Top + desc.Height, 48);
+    for (int y = 0; y < desc.Height; ++y) {
+      for (int x = 0; x < desc.Width; ++x) {
+        int index = image.RasterBits[y * desc.Width + x];
+        if (index == gcb.TransparentColor) continue;
+        canvas[(desc.Top + y) * 64 + desc.Left + x] = index;
+      }
+    }
+    for (int y = 0; y < 48; ++y) {
+      for (int x = 0; x < 64; ++x) {
+        int index = canvas[y * 64 + x];
+        ASSERT_GE(index, 0) << i << " " << x << " " << y;
+        const GifColorType &color = gif->SColorMap->Colors[index];
+        ASSERT_EQ(qRgb(color.Red, color.Green, color.Blue),
+                  expected[i].color(expected[i].pixelIndex(x, y)))
+            << i << " " << x << " " << y;
+      }
+    }
+  }
+  // the unchanged frame is the smallest frame there is
+  EXPECT_EQ(gif->SavedImages[3].ImageDesc.Width, 1);
+  EXPECT_EQ(gif->SavedImages[3].ImageDesc.Height, 1);
+  DGifCloseFile(gif);
+}
+
+int main(int argc, char *argv[]) {
+  // no window is shown, so the test runs without a display
+  if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+  }
+  QGuiApplication application(argc, argv);
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
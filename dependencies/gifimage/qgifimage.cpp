@@ -28,10 +28,16 @@
 #include <QFile>
 #include <QImage>
 #include <QScopedPointer>
+#include <vector>
 
 #include "qgifimage_p.h"
+#include "qgifquantizer.h"
+#include "task_scheduler.h"
 
 namespace {
+// frames used to build the palette when there is no global color table
+const int paletteSamplesCount = 8;
+
 int writeToIODevice(GifFileType *gifFile, const GifByteType *data,
                     int maxSize) {
   return static_cast<QIODevice *>(gifFile->UserData)
@@ -237,9 +243,35 @@ bool QGifImagePrivate::save(QIODevice *device) const {
   gifFile->SWidth = _canvasSize.width();
   gifFile->SHeight = _canvasSize.height();
   gifFile->SColorResolution = 8;
-  if (!globalColorTable.isEmpty()) {
-    gifFile->SColorMap = colorTableToColorMapObject(globalColorTable);
-    int idx = globalColorTable.indexOf(bgColor.rgba());
+
+  // frames share one palette, built from a few of them if it is not set
+  QVector<QRgb> colorTable = globalColorTable;
+  QList<int> truecolorFrames;
+  QList<QImage> images;
+  for (int idx = 0; idx < frameInfos.size(); ++idx) {
+    images.append(frameInfos.at(idx).image);
+    if (images.last().format() != QImage::Format_Indexed8)
+      truecolorFrames.append(idx);
+  }
+  if (!truecolorFrames.isEmpty()) {
+    QList<QImage> frames;
+    foreach (int idx, truecolorFrames)
+      frames.append(images.at(idx));
+    if (colorTable.isEmpty()) {
+      QList<QImage> samples;
+      int step = qMax(1, int(frames.size()) / paletteSamplesCount);
+      for (int idx = 0; idx < frames.size(); idx += step)
+        samples.append(frames.at(idx));
+      colorTable = QGifQuantizer::buildPalette(samples);
+    }
+    frames = QGifQuantizer(colorTable).quantize(frames);
+    for (int idx = 0; idx < truecolorFrames.size(); ++idx)
+      images[truecolorFrames.at(idx)] = frames.at(idx);
+  }
+
+  if (!colorTable.isEmpty()) {
+    gifFile->SColorMap = colorTableToColorMapObject(colorTable);
+    int idx = colorTable.indexOf(bgColor.rgba());
     gifFile->SBackGroundColor = idx == -1 ? 0 : idx;
   }
 
@@ -248,14 +280,7 @@ bool QGifImagePrivate::save(QIODevice *device) const {
       (SavedImage *)calloc(frameInfos.size(), sizeof(SavedImage));
   for (int idx = 0; idx < frameInfos.size(); ++idx) {
     const QGifFrameInfoData frameInfo = frameInfos.at(idx);
-    QImage image = frameInfo.image;
-    if (image.format() != QImage::Format_Indexed8) {
-      if (!globalColorTable.isEmpty())
-        image =
-            image.convertToFormat(QImage::Format_Indexed8, globalColorTable);
-      else
-        image = image.convertToFormat(QImage::Format_Indexed8);
-    }
+    const QImage &image = images.at(idx);
 
     SavedImage *gifImage = gifFile->SavedImages + idx;
 
@@ -265,8 +290,7 @@ bool QGifImagePrivate::save(QIODevice *device) const {
     gifImage->ImageDesc.Height = image.height();
     gifImage->ImageDesc.Interlace = frameInfo.interlace;
 
-    if (!image.colorTable().isEmpty() &&
-        (image.colorTable() != globalColorTable))
+    if (!image.colorTable().isEmpty() && (image.colorTable() != colorTable))
       gifImage->ImageDesc.ColorMap =
           colorTableToColorMapObject(image.colorTable());
     else
@@ -307,8 +331,26 @@ bool QGifImagePrivate::save(QIODevice *device) const {
     EGifGCBToSavedExtension(&gcbBlock, gifFile, idx);
   }
 
-  EGifSpew(gifFile);
-  // EGifCloseFile(gifFile);
+  // frames are compressed on the shared pool, then written in order
+  std::vector<GifByteType *> data(frameInfos.size(), nullptr);
+  std::vector<size_t> dataSize(frameInfos.size(), 0);
+  auto compress = [gifFile, &data, &dataSize](size_t first, size_t last) {
+    for (size_t idx = first; idx < last; ++idx) {
+      const SavedImage *gifImage = gifFile->SavedImages + idx;
+      const ColorMapObject *colorMap = gifImage->ImageDesc.ColorMap
+                                           ? gifImage->ImageDesc.ColorMap
+                                           : gifFile->SColorMap;
+      // images without a color map fail when they are written
+      if (!colorMap) continue;
+      EGifCompressImage(gifImage->RasterBits, gifImage->ImageDesc.Width,
+                        gifImage->ImageDesc.Height, colorMap->BitsPerPixel,
+                        gifImage->ImageDesc.Interlace, &data[idx],
+                        &dataSize[idx]);
+    }
+  };
+  TaskScheduler::instance().parallelFor(0, data.size(), 1, compress);
+  EGifSpewCompressed(gifFile, data.data(), dataSize.data());
+  for (GifByteType *frameData : data) free(frameData);
 
   return true;
 }
@@ -0,0 +1,340 @@
+#include "qgifquantizer.h"
+
+#include <QSet>
+#include <algorithm>
+#include <climits>
+
+#include "task_scheduler.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+const int lookupBits = 5;
+const int lookupSize = 1 << (3 * lookupBits);
+const int octreeDepth = 6;
+const int maxSamples = 1 << 20;
+const int exactBits = 10;  // four hash slots for every palette color
+const int exactSize = 1 << exactBits;
+
+const int bayer[4][4] = {
+    {0, 8, 2, 10}, {12, 4, 14, 6}, {3, 11, 1, 9}, {15, 7, 13, 5}};
+
+// threshold of the ordered dither in [-4, 3], half of the RGB555 step
+inline int ditherBias(int row, int column) {
+  return bayer[row & 3][column & 3] / 2 - 4;
+}
+
+inline int lookupKey(int r, int g, int b) {
+  return ((r >> 3) << 10) | ((g >> 3) << 5) | (b >> 3);
+}
+
+inline int exactSlot(quint32 color) {
+  return (color * 2654435761u) >> (32 - exactBits);
+}
+
+QImage toRgb32(const QImage &image) {
+  if (image.format() == QImage::Format_RGB32 ||
+      image.format() == QImage::Format_ARGB32)
+    return image;
+  return image.convertToFormat(QImage::Format_RGB32);
+}
+
+struct OctreeNode {
+  OctreeNode() : red(0), green(0), blue(0), count(0), leaf(false) {
+    std::fill(children, children + 8, -1);
+  }
+  quint64 red, green, blue;
+  quint64 count;
+  int children[8];
+  bool leaf;
+};
+
+class Octree {
+ public:
+  Octree() : leaves(0), reducible(octreeDepth) {
+    nodes.push_back(OctreeNode());
+  }
+
+  void insert(QRgb color) {
+    int node = 0;
+    for (int level = 0; level < octreeDepth; ++level) {
+      if (nodes[node].leaf) break;
+      int shift = 7 - level;
+      int child = (((qRed(color) >> shift) & 1) << 2) |
+                  (((qGreen(color) >> shift) & 1) << 1) |
+                  ((qBlue(color) >> shift) & 1);
+      if (nodes[node].children[child] == -1) {
+        nodes[node].children[child] = nodes.size();
+        nodes.push_back(OctreeNode());
+        if (level + 1 == octreeDepth) {
+          nodes.back().leaf = true;
+          ++leaves;
+        } else {
+          reducible[level + 1].push_back(nodes.size() - 1);
+        }
+      }
+      node = nodes[node].children[child];
+    }
+    nodes[node].red += qRed(color);
+    nodes[node].green += qGreen(color);
+    nodes[node].blue += qBlue(color);
+    nodes[node].count += 1;
+  }
+
+  // merges the deepest nodes until there are at most maxColors leaves
+  void reduce(int maxColors) {
+    for (int level = octreeDepth - 1; level > 0 && leaves > maxColors;
+         --level) {
+      std::vector<int> &candidates = reducible[level];
+      // nodes with few pixels are merged first
+      std::sort(candidates.begin(), candidates.end(), [this](int a, int b) {
+        return subtreeCount(a) > subtreeCount(b);
+      });
+      while (!candidates.empty() && leaves > maxColors) {
+        merge(candidates.back());
+        candidates.pop_back();
+      }
+    }
+  }
+
+  QVector<QRgb> palette() const {
+    QVector<QRgb> colors;
+    for (const OctreeNode &node : nodes) {
+      if (!node.leaf || node.count == 0) continue;
+      colors.append(qRgb(node.red / node.count, node.green / node.count,
+                         node.blue / node.count));
+    }
+    return colors;
+  }
+
+ private:
+  quint64 subtreeCount(int index) const {
+    quint64 count = nodes[index].count;
+    for (int child : nodes[index].children) {
+      if (child != -1) count += subtreeCount(child);
+    }
+    return count;
+  }
+
+  void merge(int index) {
+    OctreeNode &node = nodes[index];
+    for (int &child : node.children) {
+      if (child == -1) continue;
+      node.red += nodes[child].red;
+      node.green += nodes[child].green;
+      node.blue += nodes[child].blue;
+      node.count += nodes[child].count;
+      nodes[child].leaf = false;
+      nodes[child].count = 0;
+      child = -1;
+      --leaves;
+    }
+    node.leaf = true;
+    ++leaves;
+  }
+
+  std::vector<OctreeNode> nodes;
+  int leaves;
+  std::vector<std::vector<int> > reducible;
+};
+}  // namespace
+
+/*!
+    \class QGifQuantizer
+    \inmodule QtGifImage
+    \brief Class used to map images to one shared palette.
+
+    Pixels of a palette color get its own entry, found in a hash of the
+    palette. Only cells of the RGB555 table which hold palette colors are
+    looked up in the hash, so an exact palette of few colors keeps all of
+    them even when they share a cell. Other pixels are mapped through the
+    table, where every RGB555 color is mapped to the nearest palette entry
+    once. With SSE2 the table keys of four pixels, and the optional 4x4
+    ordered dither, are computed at once. Pixels of palette colors are not
+    dithered.
+*/
+
+/*!
+    Constructs a quantizer for the given \a palette.
+*/
+QGifQuantizer::QGifQuantizer(const QVector<QRgb> &palette)
+    : colors(palette),
+      lookup(lookupSize, 0),
+      exactCells(lookupSize, 0),
+      exactKeys(exactSize, 0),
+      exactIndices(exactSize, 0) {
+  if (colors.isEmpty()) colors.append(qRgb(0, 0, 0));
+  for (int idx = 0; idx < colors.size(); ++idx) {
+    quint32 color = colors[idx] | 0xff000000;
+    int slot = exactSlot(color);
+    while (exactKeys[slot] != 0 && exactKeys[slot] != color)
+      slot = (slot + 1) & (exactSize - 1);
+    // the first of equal palette colors is used
+    if (exactKeys[slot] == 0) {
+      exactKeys[slot] = color;
+      exactIndices[slot] = idx;
+    }
+    exactCells[lookupKey(qRed(color), qGreen(color), qBlue(color))] = 1;
+  }
+  for (int key = 0; key < lookupSize; ++key) {
+    // center of the RGB555 cell
+    int r = ((key >> 10) << 3) | 4;
+    int g = (((key >> 5) & 31) << 3) | 4;
+    int b = ((key & 31) << 3) | 4;
+    int best = 0, bestDistance = INT_MAX;
+    for (int idx = 0; idx < colors.size(); ++idx) {
+      int dr = r - qRed(colors[idx]), dg = g - qGreen(colors[idx]),
+          db = b - qBlue(colors[idx]);
+      int distance = dr * dr + dg * dg + db * db;
+      if (distance < bestDistance) {
+        bestDistance = distance;
+        best = idx;
+      }
+    }
+    lookup[key] = best;
+  }
+}
+
+/*!
+    Builds a palette of at most \a maxColors colors from the \a samples.
+    If the samples have no more than \a maxColors distinct colors they are
+    used as they are, otherwise the palette is reduced with an octree.
+*/
+QVector<QRgb> QGifQuantizer::buildPalette(const QList<QImage> &samples,
+                                          int maxColors) {
+  maxColors = qBound(2, maxColors, 256);
+  qint64 pixels = 0;
+  foreach (const QImage &sample, samples)
+    pixels += qint64(sample.width()) * sample.height();
+  int step = qMax<qint64>(1, pixels / maxSamples);
+
+  QSet<QRgb> distinct;
+  Octree octree;
+  qint64 position = 0;
+  foreach (const QImage &sample, samples) {
+    QImage image = toRgb32(sample);
+    for (int row = 0; row < image.height(); ++row) {
+      const QRgb *line =
+          reinterpret_cast<const QRgb *>(image.constScanLine(row));
+      for (int col = 0; col < image.width(); ++col, ++position) {
+        if (position % step) continue;
+        QRgb color = line[col] | 0xff000000;
+        if (distinct.size() <= maxColors) distinct.insert(color);
+        octree.insert(color);
+      }
+    }
+  }
+
+  if (distinct.size() <= maxColors) {
+    QVector<QRgb> colors;
+    foreach (QRgb color, distinct)
+      colors.append(color);
+    std::sort(colors.begin(), colors.end());
+    return colors;
+  }
+  octree.reduce(maxColors);
+  return octree.palette();
+}
+
+/*!
+    Returns the palette of the quantizer.
+*/
+QVector<QRgb> QGifQuantizer::palette() const { return colors; }
+
+/*!
+    Converts the \a image to QImage::Format_Indexed8 with the palette,
+    applying ordered dithering if \a dither is \c true.
+*/
+QImage QGifQuantizer::quantize(const QImage &image, bool dither) const {
+  QImage source = toRgb32(image);
+  QImage result(source.size(), QImage::Format_Indexed8);
+  result.setColorTable(colors);
+  result.setOffset(image.offset());
+  for (int row = 0; row < source.height(); ++row) {
+    mapRow(reinterpret_cast<const QRgb *>(source.constScanLine(row)),
+           result.scanLine(row), source.width(), row, dither);
+  }
+  return result;
+}
+
+/*!
+    \overload
+
+    Converts the \a images on the threads of TaskScheduler.
+*/
+QList<QImage> QGifQuantizer::quantize(const QList<QImage> &images,
+                                      bool dither) const {
+  std::vector<QImage> results(images.size());
+  TaskScheduler::instance().parallelFor(
+      0, images.size(), 1, [&](size_t first, size_t last) {
+        for (size_t idx = first; idx < last; ++idx)
+          results[idx] = quantize(images[int(idx)], dither);
+      });
+
+  QList<QImage> list;
+  for (const QImage &image : results) list.append(image);
+  return list;
+}
+
+void QGifQuantizer::mapRow(const QRgb *pixels, uchar *indices, int width,
+                           int row, bool dither) const {
+  int col = 0;
+#if defined(__SSE2__)
+  // the dither pattern repeats every four pixels, so it fits one register
+  alignas(16) uchar add[16] = {0}, sub[16] = {0};
+  if (dither) {
+    for (int px = 0; px < 4; ++px) {
+      int bias = ditherBias(row, px);
+      for (int channel = 0; channel < 3; ++channel) {
+        add[px * 4 + channel] = bias > 0 ? bias : 0;
+        sub[px * 4 + channel] = bias < 0 ? -bias : 0;
+      }
+    }
+  }
+  const __m128i addBias = _mm_load_si128((const __m128i *)add);
+  const __m128i subBias = _mm_load_si128((const __m128i *)sub);
+  const __m128i mask = _mm_set1_epi32(0x1f);
+  alignas(16) quint32 keys[4];
+  for (; col + 4 <= width; col += 4) {
+    __m128i p = _mm_loadu_si128((const __m128i *)(pixels + col));
+    p = _mm_subs_epu8(_mm_adds_epu8(p, addBias), subBias);
+    __m128i r = _mm_and_si128(_mm_srli_epi32(p, 19), mask);
+    __m128i g = _mm_and_si128(_mm_srli_epi32(p, 11), mask);
+    __m128i b = _mm_and_si128(_mm_srli_epi32(p, 3), mask);
+    __m128i key = _mm_or_si128(
+        _mm_or_si128(_mm_slli_epi32(r, 10), _mm_slli_epi32(g, 5)), b);
+    _mm_store_si128((__m128i *)keys, key);
+    indices[col] = mapColor(pixels[col], keys[0]);
+    indices[col + 1] = mapColor(pixels[col + 1], keys[1]);
+    indices[col + 2] = mapColor(pixels[col + 2], keys[2]);
+    indices[col + 3] = mapColor(pixels[col + 3], keys[3]);
+  }
+#endif
+  for (; col < width; ++col) {
+    int r = qRed(pixels[col]), g = qGreen(pixels[col]), b = qBlue(pixels[col]);
+    if (dither) {
+      int bias = ditherBias(row, col);
+      r = qBound(0, r + bias, 255);
+      g = qBound(0, g + bias, 255);
+      b = qBound(0, b + bias, 255);
+    }
+    indices[col] = mapColor(pixels[col], lookupKey(r, g, b));
+  }
+}
+
+/*!
+    Returns the palette index of the \a pixel, \a key is the RGB555 table
+    key of the pixel after dithering.
+*/
+uchar QGifQuantizer::mapColor(QRgb pixel, int key) const {
+  quint32 color = pixel | 0xff000000;
+  if (exactCells[lookupKey(qRed(color), qGreen(color), qBlue(color))]) {
+    for (int slot = exactSlot(color); exactKeys[slot] != 0;
+         slot = (slot + 1) & (exactSize - 1)) {
+      if (exactKeys[slot] == color) return exactIndices[slot];
+    }
+  }
+  return lookup[key];
+}
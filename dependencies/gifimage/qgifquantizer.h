@@ -0,0 +1,35 @@
+#ifndef QGIFQUANTIZER_H
+#define QGIFQUANTIZER_H
+
+#include <QImage>
+#include <QList>
+#include <QVector>
+#include <vector>
+
+#include "qgifglobal.h"
+
+class Q_GIFIMAGE_EXPORT QGifQuantizer {
+ public:
+  explicit QGifQuantizer(const QVector<QRgb> &palette);
+
+  static QVector<QRgb> buildPalette(const QList<QImage> &samples,
+                                    int maxColors = 256);
+
+  QVector<QRgb> palette() const;
+  QImage quantize(const QImage &image, bool dither = false) const;
+  QList<QImage> quantize(const QList<QImage> &images,
+                         bool dither = false) const;
+
+ private:
+  void mapRow(const QRgb *pixels, uchar *indices, int width, int row,
+              bool dither) const;
+  uchar mapColor(QRgb pixel, int key) const;
+
+  QVector<QRgb> colors;
+  std::vector<uchar> lookup;  // palette index of every RGB555 color
+  std::vector<uchar> exactCells;    // RGB555 cells with palette colors
+  std::vector<quint32> exactKeys;   // hash of palette colors, 0 is empty
+  std::vector<uchar> exactIndices;  // palette index of exactKeys
+};
+
+#endif  // QGIFQUANTIZER_H
@@ -0,0 +1,368 @@
+#include "qgifstreamwriter.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "task_scheduler.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+// frames held back to build the palette before the first one is written
+const int paletteSamplesCount = 8;
+
+int writeToIODevice(GifFileType *gifFile, const GifByteType *data,
+                    int maxSize) {
+  return static_cast<QIODevice *>(gifFile->UserData)
+      ->write(reinterpret_cast<const char *>(data), maxSize);
+}
+
+// returns index of the first byte which differs, or size if there is none
+int firstDifference(const uchar *a, const uchar *b, int size) {
+  int idx = 0;
+#if defined(__SSE2__)
+  for (; idx + 16 <= size; idx += 16) {
+    __m128i equal =
+        _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(a + idx)),
+                       _mm_loadu_si128((const __m128i *)(b + idx)));
+    int mask = ~_mm_movemask_epi8(equal) & 0xFFFF;
+    if (mask) return idx + __builtin_ctz(mask);
+  }
+#endif
+  while (idx < size && a[idx] == b[idx]) ++idx;
+  return idx;
+}
+
+// returns index of the last byte which differs, or -1 if there is none
+int lastDifference(const uchar *a, const uchar *b, int size) {
+  int idx = size;
+#if defined(__SSE2__)
+  for (; idx >= 16; idx -= 16) {
+    __m128i equal =
+        _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(a + idx - 16)),
+                       _mm_loadu_si128((const __m128i *)(b + idx - 16)));
+    int mask = ~_mm_movemask_epi8(equal) & 0xFFFF;
+    if (mask) return idx - 16 + 31 - __builtin_clz(mask);
+  }
+#endif
+  while (idx > 0 && a[idx - 1] == b[idx - 1]) --idx;
+  return idx - 1;
+}
+
+// copies current pixels, replacing the ones equal to previous by transparent
+void maskUnchanged(const uchar *current, const uchar *previous, uchar *result,
+                   int size, uchar transparent) {
+  int idx = 0;
+#if defined(__SSE2__)
+  const __m128i fill = _mm_set1_epi8(char(transparent));
+  for (; idx + 16 <= size; idx += 16) {
+    __m128i pixels = _mm_loadu_si128((const __m128i *)(current + idx));
+    __m128i equal = _mm_cmpeq_epi8(
+        pixels, _mm_loadu_si128((const __m128i *)(previous + idx)));
+    _mm_storeu_si128(
+        (__m128i *)(result + idx),
+        _mm_or_si128(_mm_and_si128(equal, fill),
+                     _mm_andnot_si128(equal, pixels)));
+  }
+#endif
+  for (; idx < size; ++idx)
+    result[idx] = current[idx] == previous[idx] ? transparent : current[idx];
+}
+}  // namespace
+
+/*!
+    \class QGifStreamWriter
+    \inmodule QtGifImage
+    \brief Class used to write .gif files frame by frame.
+
+    Frames are passed to a worker thread through a queue of at most
+    queueCapacity frames. The worker takes all queued frames at once,
+    converts them to indexed colors and LZW-compresses them in parallel,
+    then writes them in order, so memory use does not depend on the number
+    of frames. addFrame() blocks while the queue is full.
+
+    The global palette is built from the first eight frames, or from all
+    of them if fewer are written, and shared by all frames, so the colors do
+    not flicker between frames. The worker holds these frames back until
+    the palette is built.
+
+    Every frame after the first one is written as the smallest rectangle
+    which contains changed pixels. Frames are not disposed, and unchanged
+    pixels inside the rectangle use a reserved transparent index, so the
+    decoded frames are the same as the full ones.
+*/
+
+/*!
+    Constructs a writer of gif with canvas of the given \a size.
+*/
+QGifStreamWriter::QGifStreamWriter(const QSize &size, int queueCapacity)
+    : canvasSize(size),
+      capacity(queueCapacity > 0 ? queueCapacity : 1),
+      defaultDelayTime(1000),
+      loopCount(0),
+      dither(false),
+      device(0),
+      gifFile(0),
+      transparentIndex(0),
+      bitsPerPixel(8),
+      finished(false),
+      failed(false) {}
+
+/*!
+    Finishes writing and destroys the writer.
+*/
+QGifStreamWriter::~QGifStreamWriter() { close(); }
+
+/*!
+    Set the default \a delay in milliseconds. It must be set before open().
+*/
+void QGifStreamWriter::setDefaultDelay(int delay) { defaultDelayTime = delay; }
+
+/*!
+    Set the loop count, 0 means loop forever. It must be set before open().
+*/
+void QGifStreamWriter::setLoopCount(int loop) { loopCount = loop; }
+
+/*!
+    Enables ordered dithering of frames if \a enabled is \c true. It must be
+    set before open().
+*/
+void QGifStreamWriter::setDither(bool enabled) { dither = enabled; }
+
+/*!
+    Opens the file with the given \a fileName and starts the worker.
+*/
+bool QGifStreamWriter::open(const QString &fileName) {
+  file.setFileName(fileName);
+  if (!file.open(QIODevice::WriteOnly)) return false;
+  return open(&file);
+}
+
+/*!
+    \overload
+
+    Starts the worker which writes to the opened \a ioDevice.
+*/
+bool QGifStreamWriter::open(QIODevice *ioDevice) {
+  if (worker.joinable() || !ioDevice->isWritable()) return false;
+  device = ioDevice;
+  finished = false;
+  failed = false;
+  quantizer.reset();
+  previous = QImage();
+  worker = std::thread(&QGifStreamWriter::run, this);
+  return true;
+}
+
+/*!
+    Queues the \a frame with \a delay. Returns \c false if the writer is not
+    opened or writing has failed.
+*/
+bool QGifStreamWriter::addFrame(const QImage &frame, int delay) {
+  if (!worker.joinable() || failed) return false;
+  std::unique_lock<std::mutex> lock(mutex);
+  frameTaken.wait(lock, [this]() { return (int)queue.size() < capacity; });
+  queue.push_back({frame, delay});
+  frameAdded.notify_one();
+  return true;
+}
+
+/*!
+    Writes the queued frames, finishes the file and stops the worker.
+    Returns \c true if the whole file was written.
+*/
+bool QGifStreamWriter::close() {
+  if (!worker.joinable()) return !failed;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    finished = true;
+  }
+  frameAdded.notify_one();
+  worker.join();
+  if (file.isOpen()) file.close();
+  return !failed;
+}
+
+/*!
+    Returns \c true if writing has failed.
+*/
+bool QGifStreamWriter::hasError() const { return failed; }
+
+void QGifStreamWriter::run() {
+  std::vector<Frame> samples;  // frames waiting for the palette
+  bool last = false;
+  while (!last) {
+    std::vector<Frame> frames;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      frameAdded.wait(lock, [this]() { return finished || !queue.empty(); });
+      frames.assign(queue.begin(), queue.end());
+      queue.clear();
+      last = finished;
+    }
+    frameTaken.notify_one();
+    // frames are still taken after a failure, so addFrame never blocks
+    if (failed) continue;
+    if (!quantizer) {
+      samples.insert(samples.end(), frames.begin(), frames.end());
+      if ((int)samples.size() < paletteSamplesCount && !last) continue;
+      frames.swap(samples);
+      samples.clear();
+    }
+    if (!frames.empty() && !writeFrames(frames)) failed = true;
+  }
+  if (!gifFile && !failed && !writeHeader(QVector<QRgb>())) failed = true;
+  if (gifFile && EGifCloseFile(gifFile) == GIF_ERROR) failed = true;
+  gifFile = 0;
+}
+
+bool QGifStreamWriter::writeHeader(const QVector<QRgb> &palette) {
+  int error;
+  gifFile = EGifOpen(device, writeToIODevice, &error);
+  if (!gifFile) return false;
+  EGifSetGifVersion(gifFile, true);
+
+  ColorMapObject *colorMap = 0;
+  if (!palette.isEmpty()) {
+    colorMap = GifMakeMapObject(1 << GifBitSize(palette.size()), 0);
+    if (!colorMap) return false;
+    for (int idx = 0; idx < palette.size(); ++idx) {
+      colorMap->Colors[idx].Red = qRed(palette[idx]);
+      colorMap->Colors[idx].Green = qGreen(palette[idx]);
+      colorMap->Colors[idx].Blue = qBlue(palette[idx]);
+    }
+  }
+  bool ok = EGifPutScreenDesc(gifFile, canvasSize.width(), canvasSize.height(),
+                              8, 0, colorMap) != GIF_ERROR;
+  bitsPerPixel = colorMap ? colorMap->BitsPerPixel : 8;
+  if (colorMap) GifFreeMapObject(colorMap);
+  if (!ok) return false;
+
+  uchar loop[3] = {0x01, uchar(loopCount & 0xFF),
+                   uchar((loopCount >> 8) & 0xFF)};
+  return EGifPutExtensionLeader(gifFile, APPLICATION_EXT_FUNC_CODE) !=
+             GIF_ERROR &&
+         EGifPutExtensionBlock(gifFile, 11, "NETSCAPE2.0") != GIF_ERROR &&
+         EGifPutExtensionBlock(gifFile, 3, loop) != GIF_ERROR &&
+         EGifPutExtensionTrailer(gifFile) != GIF_ERROR;
+}
+
+bool QGifStreamWriter::writeFrames(const std::vector<Frame> &frames) {
+  QList<QImage> images;
+  for (const Frame &frame : frames) {
+    if (frame.image.size() != canvasSize)
+      images.append(frame.image.scaled(canvasSize, Qt::IgnoreAspectRatio));
+    else
+      images.append(frame.image);
+  }
+  if (!quantizer) {
+    // the last palette entry is kept for transparent pixels of delta frames
+    quantizer.reset(
+        new QGifQuantizer(QGifQuantizer::buildPalette(images, 255)));
+    QVector<QRgb> colorTable = quantizer->palette();
+    transparentIndex = colorTable.size();
+    colorTable.append(qRgb(0, 0, 0));
+    if (!writeHeader(colorTable)) return false;
+  }
+  images = quantizer->quantize(images, dither);
+
+  std::vector<EncodedFrame> encoded(frames.size());
+  for (size_t idx = 0; idx < frames.size(); ++idx) {
+    encoded[idx] = deltaFrame(images.at(idx));
+    encoded[idx].delay = frames[idx].delay;
+  }
+  compressFrames(&encoded);
+  bool ok = true;
+  for (EncodedFrame &frame : encoded) {
+    ok = ok && writeFrame(frame);
+    free(frame.data);
+  }
+  return ok;
+}
+
+QGifStreamWriter::EncodedFrame QGifStreamWriter::deltaFrame(
+    const QImage &image) {
+  EncodedFrame frame;
+  frame.rect = image.rect();
+  frame.pixels = image;
+  frame.delta = !previous.isNull();
+  frame.data = 0;
+  frame.size = 0;
+  if (frame.delta) {
+    frame.rect = changedRect(image);
+    // an unchanged frame is still written to keep its delay
+    if (frame.rect.isNull()) frame.rect = QRect(0, 0, 1, 1);
+    const QRect &rect = frame.rect;
+    frame.pixels = QImage(rect.size(), QImage::Format_Indexed8);
+    for (int row = 0; row < rect.height(); ++row) {
+      maskUnchanged(image.constScanLine(rect.top() + row) + rect.left(),
+                    previous.constScanLine(rect.top() + row) + rect.left(),
+                    frame.pixels.scanLine(row), rect.width(),
+                    transparentIndex);
+    }
+  }
+  previous = image;
+  return frame;
+}
+
+void QGifStreamWriter::compressFrames(std::vector<EncodedFrame> *frames) {
+  auto compress = [this, frames](size_t first, size_t last) {
+    std::vector<uchar> raster;
+    for (size_t idx = first; idx < last; ++idx) {
+      EncodedFrame &frame = (*frames)[idx];
+      int width = frame.pixels.width(), height = frame.pixels.height();
+      // scan lines of QImage are padded, the encoder needs them packed
+      raster.resize(size_t(width) * height);
+      for (int row = 0; row < height; ++row) {
+        memcpy(raster.data() + size_t(row) * width,
+               frame.pixels.constScanLine(row), width);
+      }
+      EGifCompressImage(raster.data(), width, height, bitsPerPixel, false,
+                        &frame.data, &frame.size);
+    }
+  };
+  TaskScheduler::instance().parallelFor(0, frames->size(), 1, compress);
+}
+
+bool QGifStreamWriter::writeFrame(const EncodedFrame &frame) {
+  if (!frame.data) return false;
+
+  GraphicsControlBlock gcbBlock;
+  gcbBlock.DisposalMode = DISPOSE_DO_NOT;
+  gcbBlock.UserInputFlag = false;
+  gcbBlock.TransparentColor =
+      frame.delta ? transparentIndex : NO_TRANSPARENT_COLOR;
+  gcbBlock.DelayTime =
+      (frame.delay != -1 ? frame.delay : defaultDelayTime) / 10;
+  GifByteType extension[4];
+  size_t extensionSize = EGifGCBToExtension(&gcbBlock, extension);
+
+  const QRect &rect = frame.rect;
+  return EGifPutExtension(gifFile, GRAPHICS_EXT_FUNC_CODE, extensionSize,
+                          extension) != GIF_ERROR &&
+         EGifPutImageData(gifFile, rect.left(), rect.top(), rect.width(),
+                          rect.height(), false, 0, frame.data,
+                          frame.size) != GIF_ERROR;
+}
+
+QRect QGifStreamWriter::changedRect(const QImage &image) const {
+  int width = image.width();
+  int left = width, right = -1, top = -1, bottom = -1;
+  for (int row = 0; row < image.height(); ++row) {
+    const uchar *current = image.constScanLine(row);
+    const uchar *last = previous.constScanLine(row);
+    int first = firstDifference(current, last, width);
+    if (first == width) continue;
+    if (top == -1) top = row;
+    bottom = row;
+    left = qMin(left, first);
+    // only the part right of the known rectangle has to be compared
+    int from = qMax(right + 1, first);
+    int end = lastDifference(current + from, last + from, width - from);
+    if (end != -1) right = from + end;
+  }
+  if (top == -1) return QRect();
+  return QRect(QPoint(left, top), QPoint(right, bottom));
+}
@@ -0,0 +1,81 @@
+#ifndef QGIFSTREAMWRITER_H
+#define QGIFSTREAMWRITER_H
+
+#include <QFile>
+#include <QImage>
+#include <QRect>
+#include <QSize>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../giflib/gif_lib.h"
+#include "qgifglobal.h"
+#include "qgifquantizer.h"
+
+class Q_GIFIMAGE_EXPORT QGifStreamWriter {
+ public:
+  explicit QGifStreamWriter(const QSize &size, int queueCapacity = 4);
+  ~QGifStreamWriter();
+
+  void setDefaultDelay(int delay);
+  void setLoopCount(int loop);
+  void setDither(bool enabled);
+
+  bool open(const QString &fileName);
+  bool open(QIODevice *ioDevice);
+  bool addFrame(const QImage &frame, int delay = -1);
+  bool close();
+  bool hasError() const;
+
+ private:
+  struct Frame {
+    QImage image;
+    int delay;
+  };
+
+  struct EncodedFrame {
+    QRect rect;         // part of the canvas covered by the frame
+    QImage pixels;      // indexed pixels of the rect
+    bool delta;         // unchanged pixels are transparent
+    int delay;
+    GifByteType *data;  // LZW stream, allocated by giflib
+    size_t size;
+  };
+
+  void run();
+  bool writeHeader(const QVector<QRgb> &palette);
+  bool writeFrames(const std::vector<Frame> &frames);
+  EncodedFrame deltaFrame(const QImage &image);
+  void compressFrames(std::vector<EncodedFrame> *frames);
+  bool writeFrame(const EncodedFrame &frame);
+  QRect changedRect(const QImage &image) const;
+
+  QSize canvasSize;
+  int capacity;
+  int defaultDelayTime;
+  int loopCount;
+  bool dither;
+
+  QFile file;
+  QIODevice *device;
+  GifFileType *gifFile;
+  std::unique_ptr<QGifQuantizer> quantizer;
+  int transparentIndex;
+  int bitsPerPixel;
+  QImage previous;
+
+  std::thread worker;
+  std::mutex mutex;
+  std::condition_variable frameAdded;
+  std::condition_variable frameTaken;
+  std::deque<Frame> queue;
+  bool finished;
+  std::atomic<bool> failed;
+};
+
+#endif  // QGIFSTREAMWRITER_H
@@ -37,6 +37,16 @@ static int EGifCompressLine(GifFileType *GifFile, GifPixelType *Line,
                             int LineLen);
 static int EGifCompressOutput(GifFileType *GifFile, int Code);
 static int EGifBufferedOutput(GifFileType *GifFile, GifByteType *Buf, int c);
+static int EGifWriteImageDesc(GifFileType *GifFile, const int Left,
+                              const int Top, const int Width, const int Height,
+                              const BOOL Interlace,
+                              const ColorMapObject *ColorMap);
+
+/* Growing buffer which receives the output of EGifCompressImage. */
+typedef struct GifMemoryOutput {
+  GifByteType *Data;
+  size_t Size, Capacity;
+} GifMemoryOutput;
 
 /* extract bytes from an unsigned word */
 #define LOBYTE(x) ((x)&0xff)
@@ -325,6 +335,47 @@ int EGifPutScreenDesc(GifFileType *GifFile, const int Width, const int Height,
 int EGifPutImageDesc(GifFileType *GifFile, const int Left, const int Top,
                      const int Width, const int Height, const BOOL Interlace,
                      const ColorMapObject *ColorMap) {
+  if (EGifWriteImageDesc(GifFile, Left, Top, Width, Height, Interlace,
+                         ColorMap) == GIF_ERROR)
+    return GIF_ERROR;
+
+  /* Reset compress algorithm parameters. */
+  (void)EGifSetupCompress(GifFile);
+
+  return GIF_OK;
+}
+
+/******************************************************************************
+ Put an image descriptor followed by raster data previously compressed by
+ EGifCompressImage() with the bits per pixel of the color map in effect.
+ Unlike EGifPutLine(), nothing has to be compressed while the file is held.
+******************************************************************************/
+int EGifPutImageData(GifFileType *GifFile, const int Left, const int Top,
+                     const int Width, const int Height, const BOOL Interlace,
+                     const ColorMapObject *ColorMap, const GifByteType *Data,
+                     const size_t DataSize) {
+  GifFilePrivateType *Private = (GifFilePrivateType *)GifFile->Private;
+
+  if (EGifWriteImageDesc(GifFile, Left, Top, Width, Height, Interlace,
+                         ColorMap) == GIF_ERROR)
+    return GIF_ERROR;
+
+  if (InternalWrite(GifFile, Data, DataSize) != (int)DataSize) {
+    GifFile->Error = E_GIF_ERR_WRITE_FAILED;
+    return GIF_ERROR;
+  }
+  Private->PixelCount = 0;
+
+  return GIF_OK;
+}
+
+/******************************************************************************
+ Write the image descriptor and the local color map of the next image.
+******************************************************************************/
+static int EGifWriteImageDesc(GifFileType *GifFile, const int Left,
+                              const int Top, const int Width, const int Height,
+                              const BOOL Interlace,
+                              const ColorMapObject *ColorMap) {
   GifByteType Buf[3];
   GifFilePrivateType *Private = (GifFilePrivateType *)GifFile->Private;
 
@@ -389,9 +440,6 @@ int EGifPutImageDesc(GifFileType *GifFile, const int Left, const int Top,
   Private->FileState |= FILE_STATE_IMAGE;
   Private->PixelCount = (long)Width * (long)Height;
 
-  /* Reset compress algorithm parameters. */
-  (void)EGifSetupCompress(GifFile);
-
   return GIF_OK;
 }
 
@@ -802,8 +850,8 @@ static int EGifSetupCompress(GifFileType *GifFile) {
 ******************************************************************************/
 static int EGifCompressLine(GifFileType *GifFile, GifPixelType *Line,
                             const int LineLen) {
-  int i = 0, CrntCode, NewCode;
-  unsigned long NewKey;
+  int i = 0, CrntCode;
+  uint32_t NewKey, *Entry;
   GifPixelType Pixel;
   GifHashTableType *HashTable;
   GifFilePrivateType *Private = (GifFilePrivateType *)GifFile->Private;
@@ -821,11 +869,12 @@ static int EGifCompressLine(GifFileType *GifFile, GifPixelType *Line,
      * CrntCode as Prefix string with Pixel as postfix char.
      */
     NewKey = (((uint32_t)CrntCode) << 8) + Pixel;
-    if ((NewCode = _ExistsHashTable(HashTable, NewKey)) >= 0) {
+    Entry = _ProbeHashTable(HashTable, NewKey);
+    if (*Entry != HT_EMPTY) {
       /* This Key is already there, or the string is old one, so
        * simple take new code as our CrntCode:
        */
-      CrntCode = NewCode;
+      CrntCode = HT_GET_CODE(*Entry);
     } else {
       /* Put it in hash table, output the prefix code, and make our
        * CrntCode equal to Pixel.
@@ -850,8 +899,9 @@ static int EGifCompressLine(GifFileType *GifFile, GifPixelType *Line,
         Private->MaxCode1 = 1 << Private->RunningBits;
         _ClearHashTable(HashTable);
       } else {
-        /* Put this unique key with its relative Code in hash table: */
-        _InsertHashTable(HashTable, NewKey, Private->RunningCode++);
+        /* Put this unique key with its relative Code in the empty entry
+         * found by the probe: */
+        *Entry = HT_PUT_KEY(NewKey) | HT_PUT_CODE(Private->RunningCode++);
       }
     }
   }
@@ -1048,4 +1098,148 @@ int EGifSpew(GifFileType *GifFileOut) {
   return (GIF_OK);
 }
 
+/******************************************************************************
+ Output function of EGifCompressImage, appends to a growing memory buffer.
+******************************************************************************/
+static int EGifMemoryWrite(GifFileType *GifFile, const GifByteType *Buf,
+                           int Len) {
+  GifMemoryOutput *Output = (GifMemoryOutput *)GifFile->UserData;
+
+  if (Output->Size + Len > Output->Capacity) {
+    size_t Capacity = Output->Capacity ? Output->Capacity * 2 : 4096;
+    GifByteType *Data;
+
+    while (Capacity < Output->Size + Len) Capacity *= 2;
+    Data = (GifByteType *)realloc(Output->Data, Capacity);
+    if (Data == NULL) return 0;
+    Output->Data = Data;
+    Output->Capacity = Capacity;
+  }
+  memcpy(Output->Data + Output->Size, Buf, Len);
+  Output->Size += Len;
+  return Len;
+}
+
+/******************************************************************************
+ LZW-compress a whole image of Width x Height pixels into a buffer allocated
+ with malloc(), in the form EGifPutImageData() expects: the code size, the
+ data sub-blocks and the block terminator. The encoder state is private to
+ the call, so several images can be compressed concurrently. If Interlace is
+ set the rows are written in the order of the four interlace passes.
+******************************************************************************/
+int EGifCompressImage(const GifPixelType *Pixels, const int Width,
+                      const int Height, const int BitsPerPixel,
+                      const BOOL Interlace, GifByteType **Data,
+                      size_t *DataSize) {
+  static const int InterlacedOffset[] = {0, 4, 2, 1};
+  static const int InterlacedJumps[] = {8, 8, 4, 2};
+  GifFileType GifFile;
+  GifFilePrivateType *Private;
+  ColorMapObject ColorMap;
+  GifMemoryOutput Output = {NULL, 0, 0};
+  GifPixelType *Line, Mask;
+  int Result = GIF_OK, Pass, Row, i;
+
+  *Data = NULL;
+  *DataSize = 0;
+  if (Width <= 0 || Height <= 0) return GIF_ERROR;
+
+  Private = (GifFilePrivateType *)malloc(sizeof(GifFilePrivateType));
+  Line = (GifPixelType *)malloc(Width);
+  if (Private == NULL || Line == NULL ||
+      (Private->HashTable = _InitHashTable()) == NULL) {
+    free(Private);
+    free(Line);
+    return GIF_ERROR;
+  }
+
+  /* Only the bits per pixel of the color map are used by the encoder. */
+  memset(&ColorMap, '\0', sizeof(ColorMapObject));
+  ColorMap.BitsPerPixel = BitsPerPixel;
+  memset(&GifFile, '\0', sizeof(GifFileType));
+  GifFile.SColorMap = &ColorMap;
+  GifFile.Private = (void *)Private;
+  GifFile.UserData = (void *)&Output;
+  Private->FileState = FILE_STATE_WRITE | FILE_STATE_IMAGE;
+  Private->File = (FILE *)0;
+  Private->Write = EGifMemoryWrite;
+  Private->PixelCount = (long)Width * (long)Height;
+
+  if (EGifSetupCompress(&GifFile) == GIF_ERROR) Result = GIF_ERROR;
+  Mask = CodeMask[Private->BitsPerPixel];
+  for (Pass = Interlace ? 0 : 3; Result == GIF_OK && Pass < 4; Pass++) {
+    int Offset = Interlace ? InterlacedOffset[Pass] : 0;
+    int Jump = Interlace ? InterlacedJumps[Pass] : 1;
+
+    for (Row = Offset; Result == GIF_OK && Row < Height; Row += Jump) {
+      const GifPixelType *Source = Pixels + (size_t)Row * Width;
+
+      for (i = 0; i < Width; i++) Line[i] = Source[i] & Mask;
+      Private->PixelCount -= Width;
+      Result = EGifCompressLine(&GifFile, Line, Width);
+    }
+  }
+
+  free(Private->HashTable);
+  free(Private);
+  free(Line);
+  if (Result == GIF_ERROR) {
+    free(Output.Data);
+    return GIF_ERROR;
+  }
+  *Data = Output.Data;
+  *DataSize = Output.Size;
+  return GIF_OK;
+}
+
+/******************************************************************************
+ The same as EGifSpew(), but the images are written from Data[i] and
+ DataSize[i], compressed beforehand by EGifCompressImage() with the bits per
+ pixel of the color map of each image. The caller may compress them
+ concurrently, the output bytes are those of EGifSpew(). The file is closed
+ as by EGifSpew(), the buffers are left to the caller.
+******************************************************************************/
+int EGifSpewCompressed(GifFileType *GifFileOut, GifByteType *const *Data,
+                       const size_t *DataSize) {
+  int i;
+
+  if (EGifPutScreenDesc(GifFileOut, GifFileOut->SWidth, GifFileOut->SHeight,
+                        GifFileOut->SColorResolution,
+                        GifFileOut->SBackGroundColor,
+                        GifFileOut->SColorMap) == GIF_ERROR)
+    return (GIF_ERROR);
+
+  for (i = 0; i < GifFileOut->ImageCount; i++) {
+    SavedImage *sp = &GifFileOut->SavedImages[i];
+
+    /* this allows us to delete images by nuking their rasters */
+    if (sp->RasterBits == NULL) continue;
+
+    if (EGifWriteExtensions(GifFileOut, sp->ExtensionBlocks,
+                            sp->ExtensionBlockCount) == GIF_ERROR)
+      return (GIF_ERROR);
+    if (Data[i] == NULL) {
+      /* Compression was skipped or failed: */
+      GifFileOut->Error =
+          sp->ImageDesc.ColorMap == NULL && GifFileOut->SColorMap == NULL
+              ? E_GIF_ERR_NO_COLOR_MAP
+              : E_GIF_ERR_NOT_ENOUGH_MEM;
+      return (GIF_ERROR);
+    }
+    if (EGifPutImageData(GifFileOut, sp->ImageDesc.Left, sp->ImageDesc.Top,
+                         sp->ImageDesc.Width, sp->ImageDesc.Height,
+                         sp->ImageDesc.Interlace, sp->ImageDesc.ColorMap,
+                         Data[i], DataSize[i]) == GIF_ERROR)
+      return (GIF_ERROR);
+  }
+
+  if (EGifWriteExtensions(GifFileOut, GifFileOut->ExtensionBlocks,
+                          GifFileOut->ExtensionBlockCount) == GIF_ERROR)
+    return (GIF_ERROR);
+
+  if (EGifCloseFile(GifFileOut) == GIF_ERROR) return (GIF_ERROR);
+
+  return (GIF_OK);
+}
+
 /* end */
@@ -6,6 +6,7 @@ gif_hash.c -- module to support the following operations:
 2. ClearHashTable - clear the hash table to an empty state.
 2. InsertHashTable - insert one item into data structure.
 3. ExistsHashTable - test if item exists in data structure.
+4. ProbeHashTable - find item or the place to insert it in one pass.
 
 This module is used to hash the GIF codes during encoding.
 
@@ -99,15 +100,32 @@ int _ExistsHashTable(GifHashTableType *HashTable, uint32_t Key) {
   return -1;
 }
 
+/******************************************************************************
+ Routine to find the entry of given Key, or the empty entry where it has to  *
+ be inserted, so lookup and insertion of the encoder share one probe         *
+ sequence. The caller stores HT_PUT_KEY(Key) | HT_PUT_CODE(Code) into an     *
+ empty entry to insert the Key.					      *
+******************************************************************************/
+uint32_t *_ProbeHashTable(GifHashTableType *HashTable, uint32_t Key) {
+  uint32_t *HTable = HashTable->HTable;
+  int HKey = KeyItem(Key);
+
+  while (HTable[HKey] != HT_EMPTY && HT_GET_KEY(HTable[HKey]) != Key)
+    HKey = (HKey + 1) & HT_KEY_MASK;
+
+  return HTable + HKey;
+}
+
 /******************************************************************************
  Routine to generate an HKey for the hashtable out of the given unique key.  *
  The given Key is assumed to be 20 bits as follows: lower 8 bits are the     *
  new postfix character, while the upper 12 bits are the prefix code.	      *
- Because the average hit ratio is only 2 (2 hash references per entry),      *
- evaluating more complex keys (such as twin prime keys) does not worth it!   *
+ Keys of one image share most of their prefix bits, so a multiplicative      *
+ hash takes the top bits of the product to spread them over the table and    *
+ keep the probe sequences short.					      *
 ******************************************************************************/
 static int KeyItem(uint32_t Item) {
-  return ((Item >> 12) ^ Item) & HT_KEY_MASK;
+  return (int)((Item * 0x9E3779B1U) >> (32 - HT_KEY_NUM_BITS));
 }
 
 #ifdef DEBUG_HIT_RATE
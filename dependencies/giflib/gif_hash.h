@@ -26,6 +26,7 @@ gif_hash.h - magfic constants and declarations for GIF LZW
 #define HT_GET_CODE(l)	(l & 0x0FFF)
 #define HT_PUT_KEY(l)	(l << 12)
 #define HT_PUT_CODE(l)	(l & 0x0FFF)
+#define HT_EMPTY	0xFFFFFFFFUL	/* Entry of a cleared table. */
 
 typedef struct GifHashTableType {
     uint32_t HTable[HT_SIZE];
@@ -35,6 +36,7 @@ GifHashTableType *_InitHashTable(void);
 void _ClearHashTable(GifHashTableType *HashTable);
 void _InsertHashTable(GifHashTableType *HashTable, uint32_t Key, int Code);
 int _ExistsHashTable(GifHashTableType *HashTable, uint32_t Key);
+uint32_t *_ProbeHashTable(GifHashTableType *HashTable, uint32_t Key);
 
 #endif /* _GIF_HASH_H_ */
 
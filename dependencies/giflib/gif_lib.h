@@ -179,6 +179,20 @@ int EGifPutCode(GifFileType *GifFile, int GifCodeSize,
 int EGifPutCodeNext(GifFileType *GifFile,
                     const GifByteType *GifCodeBlock);
 
+/* Thread-safe compression of whole images into memory */
+int EGifCompressImage(const GifPixelType *GifPixels,
+                      const int GifWidth, const int GifHeight,
+                      const int GifBitsPerPixel, const BOOL GifInterlace,
+                      GifByteType **GifData, size_t *GifDataSize);
+int EGifPutImageData(GifFileType *GifFile,
+                     const int GifLeft, const int GifTop,
+                     const int GifWidth, const int GifHeight,
+                     const BOOL GifInterlace,
+                     const ColorMapObject *GifColorMap,
+                     const GifByteType *GifData, const size_t GifDataSize);
+int EGifSpewCompressed(GifFileType *GifFile, GifByteType *const *GifData,
+                       const size_t *GifDataSize);
+
 /******************************************************************************
  GIF decoding routines
 ******************************************************************************/
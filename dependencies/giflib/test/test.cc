@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "gif_lib.h"
+
+// frame of the test animation with its own raster and optional color map
+struct TestFrame {
+  int left, top, width, height;
+  bool interlace;
+  int local_bits;  // bits per pixel of the local color map, 0 for none
+  std::vector<GifPixelType> raster;
+};
+
+static int writeMemory(GifFileType *gif, const GifByteType *data, int size) {
+  std::vector<GifByteType> *output =
+      static_cast<std::vector<GifByteType> *>(gif->UserData);
+  output->insert(output->end(), data, data + size);
+  return size;
+}
+
+struct MemoryInput {
+  const std::vector<GifByteType> *data;
+  size_t position;
+};
+
+static int readMemory(GifFileType *gif, GifByteType *data, int size) {
+  MemoryInput *input = static_cast<MemoryInput *>(gif->UserData);
+  int left = static_cast<int>(input->data->size() - input->position);
+  if (size > left) size = left;
+  std::copy(input->data->begin() + input->position,
+            input->data->begin() + input->position + size, data);
+  input->position += size;
+  return size;
+}
+
+static ColorMapObject *makeColorMap(int bits) {
+  std::vector<GifColorType> colors(1 << bits);
+  for (size_t i = 0; i < colors.size(); ++i) {
+    colors[i].Red = static_cast<GifByteType>(i * 37);
+    colors[i].Green = static_cast<GifByteType>(i * 11 + 5);
+    colors[i].Blue = static_cast<GifByteType>(255 - i);
+  }
+  return GifMakeMapObject(colors.size(), colors.data());
+}
+
+// frames of size 13x21 so interlace passes do not divide the rows evenly
+static std::vector<TestFrame> makeFrames(int bits) {
+  std::vector<TestFrame> frames = {{0, 0, 13, 21, false, 0, {}},
+                                   {2, 3, 9, 17, true, 0, {}},
+                                   {1, 1, 11, 7, false, 3, {}},
+                                   {0, 5, 13, 9, true, 1, {}}};
+  unsigned int seed = static_cast<unsigned int>(bits) * 7919u;
+  for (TestFrame &frame : frames) {
+    int frame_bits = frame.local_bits ? frame.local_bits : bits;
+    frame.raster.resize(frame.width * frame.height);
+    for (size_t i = 0; i < frame.raster.size(); ++i) {
+      // runs of one color and noise exercise both string and clear codes
+      seed = seed * 1103515245u + 12345u;
+      int value = (i / 5) % 3 ? static_cast<int>(i / 5) : (seed >> 16);
+      frame.raster[i] = static_cast<GifPixelType>(value % (1 << frame_bits));
+    }
+  }
+  return frames;
+}
+
+// writes the frames through EGifSpew, or compressed beforehand with
+// EGifCompressImage through EGifSpewCompressed
+static std::vector<GifByteType> spew(int bits, std::vector<TestFrame> &frames,
+                                     bool compressed) {
+  std::vector<GifByteType> output;
+  int error = 0;
+  GifFileType *gif = EGifOpen(&output, writeMemory, &error);
+  EXPECT_NE(gif, nullptr);
+  if (gif == nullptr) return output;
+  gif->SWidth = 13;
+  gif->SHeight = 21;
+  gif->SColorResolution = bits;
+  gif->SBackGroundColor = 0;
+  // the screen descriptor keeps a copy of the map
+  ColorMapObject *screen_map = makeColorMap(bits);
+  gif->SColorMap = screen_map;
+  std::vector<SavedImage> images(frames.size());
+  for (size_t i = 0; i < frames.size(); ++i) {
+    SavedImage &image = images[i];
+    image.ImageDesc.Left = frames[i].left;
+    image.ImageDesc.Top = frames[i].top;
+    image.ImageDesc.Width = frames[i].width;
+    image.ImageDesc.Height = frames[i].height;
+    image.ImageDesc.Interlace = frames[i].interlace;
+    image.ImageDesc.ColorMap =
+        frames[i].local_bits ? makeColorMap(frames[i].local_bits) : nullptr;
+    image.RasterBits = frames[i].raster.data();
+    image.ExtensionBlockCount = 0;
+    image.ExtensionBlocks = nullptr;
+  }
+  gif->SavedImages = images.data();
+  gif->ImageCount = images.size();
+
+  std::vector<GifByteType *> data(images.size(), nullptr);
+  std::vector<size_t> data_size(images.size(), 0);
+  int result = GIF_ERROR;
+  if (compressed) {
+    for (size_t i = 0; i < images.size(); ++i) {
+      const ColorMapObject *map = images[i].ImageDesc.ColorMap
+                                      ? images[i].ImageDesc.ColorMap
+                                      : screen_map;
+      EXPECT_EQ(EGifCompressImage(images[i].RasterBits,
+                                  images[i].ImageDesc.Width,
+                                  images[i].ImageDesc.Height,
+                                  map->BitsPerPixel,
+                                  images[i].ImageDesc.Interlace, &data[i],
+                                  &data_size[i]),
+                GIF_OK);
+    }
+    result = EGifSpewCompressed(gif, data.data(), data_size.data());
+  } else {
+    result = EGifSpew(gif);
+  }
+  EXPECT_EQ(result, GIF_OK);
+  // the file is freed by the spew, the images and their maps are not
+  GifFreeMapObject(screen_map);
+  for (size_t i = 0; i < images.size(); ++i) {
+    GifFreeMapObject(images[i].ImageDesc.ColorMap);
+    free(data[i]);
+  }
+  return output;
+}
+
+TEST(GiflibTest, TestSpewCompressed1) {
+  for (int bits = 1; bits <= 8; ++bits) {
+    std::vector<TestFrame> frames = makeFrames(bits);
+    std::vector<GifByteType> lines = spew(bits, frames, false);
+    std::vector<GifByteType> images = spew(bits, frames, true);
+    ASSERT_FALSE(lines.empty()) << bits;
+    EXPECT_EQ(lines, images) << bits;
+  }
+}
+
+TEST(GiflibTest, TestSpewCompressed2) {
+  for (int bits = 1; bits <= 8; ++bits) {
+    std::vector<TestFrame> frames = makeFrames(bits);
+    std::vector<GifByteType> output = spew(bits, frames, true);
+    MemoryInput input = {&output, 0};
+    int error = 0;
+    GifFileType *gif = DGifOpen(&input, readMemory, &error);
+    ASSERT_NE(gif, nullptr) << bits;
+    ASSERT_EQ(DGifSlurp(gif), GIF_OK) << bits;
+    ASSERT_EQ(gif->ImageCount, static_cast<int>(frames.size())) << bits;
+    for (size_t i = 0; i < frames.size(); ++i) {
+      const SavedImage &image = gif->SavedImages[i];
+      EXPECT_EQ(image.ImageDesc.Left, frames[i].left);
+      EXPECT_EQ(image.ImageDesc.Top, frames[i].top);
+      EXPECT_EQ(image.ImageDesc.Width, frames[i].width);
+      EXPECT_EQ(image.ImageDesc.Height, frames[i].height);
+      EXPECT_EQ(!!image.ImageDesc.Interlace, frames[i].interlace);
+      // interlaced rows are put back in order by DGifSlurp
+      std::vector<GifPixelType> raster(
+          image.RasterBits, image.RasterBits + frames[i].raster.size());
+      EXPECT_EQ(raster, frames[i].raster) << bits << " " << i;
+    }
+    DGifCloseFile(gif);
+  }
+}
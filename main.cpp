@@ -1,9 +1,17 @@
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QDir>
 #include <QStyleFactory>
+#include <QSurfaceFormat>
 
 #include "view.h"
 
 int main(int argc, char *argv[]) {
+  // viewer falls back to fixed-function drawing if core profile is refused
+  QSurfaceFormat format;
+  format.setVersion(3, 3);
+  format.setProfile(QSurfaceFormat::CoreProfile);
+  QSurfaceFormat::setDefaultFormat(format);
   QApplication a(argc, argv);
   QCoreApplication::setAttribute(Qt::AA_DontUseNativeMenuBar);
   QApplication::setStyle(QStyleFactory::create("Fusion"));
@@ -12,6 +20,43 @@ int main(int argc, char *argv[]) {
   Model model(&parser);
   Controller controller(&model, &settings);
   View view(&controller);
+
+  QCommandLineParser arguments;
+  arguments.addHelpOption();
+  QCommandLineOption replay_option(
+      "replay", "Replay recorded interactions and report frame times.",
+      "trace");
+  QCommandLineOption max_speed_option(
+      "max-speed", "Draw replayed frames without waiting for recorded time.");
+  QCommandLineOption report_option(
+      "report", "Write the frame time report of the replay to the file.",
+      "file");
+  QCommandLineOption out_of_core_option(
+      "out-of-core",
+      "Parse models into temporary files and keep only meshlets in view, up "
+      "to the budget, in memory.",
+      "megabytes");
+  QCommandLineOption direct_read_option(
+      "direct-read",
+      "Read model files around the page cache, for big models loaded once.");
+  arguments.addOption(replay_option);
+  arguments.addOption(max_speed_option);
+  arguments.addOption(report_option);
+  arguments.addOption(out_of_core_option);
+  arguments.addOption(direct_read_option);
+  arguments.process(a);
+  if (arguments.isSet(out_of_core_option)) {
+    size_t budget = arguments.value(out_of_core_option).toULongLong();
+    controller.setOutOfCore(QDir::tempPath().toStdString(), budget << 20);
+  }
+  controller.setDirectRead(arguments.isSet(direct_read_option));
+
   view.startEventLoop();
+  if (arguments.isSet(replay_option) &&
+      !view.replay(arguments.value(replay_option),
+                   arguments.isSet(max_speed_option),
+                   arguments.value(report_option))) {
+    return 1;
+  }
   return a.exec();
 }